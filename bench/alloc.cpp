@@ -0,0 +1,67 @@
+// Allocation throughput of the runtime heap objects.
+// Build twice (bench_alloc and bench_alloc_arena) and compare the ns/op columns.
+#include "core.h"
+#include "bench.h"
+
+using namespace js;
+
+class Point : public object
+{
+public:
+    number x;
+    number y;
+
+    Point(number x, number y) : x(x), y(y)
+    {
+    }
+};
+
+// in arena mode the batch is dropped in one go every "batch" iterations, in heap mode objects die one by one
+static constexpr std::size_t batch = 4096;
+
+template <typename F>
+static auto batched(F f)
+{
+    return [=](std::size_t i) {
+        f(i);
+#ifdef JS_ARENA
+        if (i % batch == batch - 1)
+        {
+            arena.reset();
+        }
+#endif
+    };
+}
+
+int main(int argc, char **argv)
+{
+    constexpr std::size_t iterations = 1000000;
+
+#ifdef JS_ARENA
+    std::printf("mode: arena\n");
+#else
+    std::printf("mode: shared_ptr\n");
+#endif
+
+    bench::run("new class instance", iterations, batched([](std::size_t i) {
+                   auto p = new_<Point>(number(i), number(i + 1));
+                   bench::do_not_optimize(p);
+               }));
+
+    bench::run("object literal {x, y}", iterations, batched([](std::size_t i) {
+                   auto o = object{object::pair{"x"_S, number(i)}, object::pair{"y"_S, number(i + 1)}};
+                   bench::do_not_optimize(o);
+               }));
+
+    bench::run("array literal [1, 2, 3]", iterations, batched([](std::size_t i) {
+                   auto a = array<number>{number(i), number(i + 1), number(i + 2)};
+                   bench::do_not_optimize(a);
+               }));
+
+    bench::run("closure box shared<number>", iterations, batched([](std::size_t i) {
+                   auto s = shared<number>(number(i));
+                   bench::do_not_optimize(s);
+               }));
+
+    return bench::report(argc, argv);
+}
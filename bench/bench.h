@@ -0,0 +1,119 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    struct result
+    {
+        std::string name;
+        std::size_t iterations;
+        double ns_per_op;
+    };
+
+    // every measurement of the program, written by report()
+    inline std::vector<result> &results()
+    {
+        static std::vector<result> all;
+        return all;
+    }
+
+    // keeps the optimizer from dropping the value computed by a benchmark body
+    template <typename T>
+    inline void do_not_optimize(T const &value)
+    {
+        static const void *volatile sink;
+        sink = static_cast<const void *>(&value);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+
+    // runs f(i) for i in [0, iterations) and prints the average time per call
+    template <typename F>
+    double run(const char *name, std::size_t iterations, F &&f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++)
+        {
+            f(i);
+        }
+
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        auto ns_per_op = elapsed / static_cast<double>(iterations);
+        std::printf("%-40s %12.2f ns/op\n", name, ns_per_op);
+        results().push_back({name, iterations, ns_per_op});
+        return ns_per_op;
+    }
+
+    // value of "--name value" among the arguments
+    inline const char *option(int argc, char **argv, const char *name)
+    {
+        for (auto i = 1; i + 1 < argc; i++)
+        {
+            if (std::strcmp(argv[i], name) == 0)
+            {
+                return argv[i + 1];
+            }
+        }
+
+        return nullptr;
+    }
+
+    // with "--json file" writes the results as JSON, bench/compare.js compares two such files, returns main's exit code
+    inline int report(int argc, char **argv)
+    {
+        const auto path = option(argc, argv, "--json");
+        if (path == nullptr)
+        {
+            return 0;
+        }
+
+        const auto file = std::fopen(path, "w");
+        if (file == nullptr)
+        {
+            std::printf("can't write %s\n", path);
+            return 1;
+        }
+
+        const auto quoted = [](const std::string &text) {
+            std::string escaped;
+            for (auto c : text)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    escaped += '\\';
+                }
+
+                escaped += c;
+            }
+
+            return escaped;
+        };
+
+        auto program = std::string(argv[0]);
+        program = program.substr(program.find_last_of("/\\") + 1);
+        if (program.size() > 4 && program.compare(program.size() - 4, 4, ".exe") == 0)
+        {
+            program.resize(program.size() - 4);
+        }
+
+        std::fprintf(file, "{\n  \"benchmark\": \"%s\",\n  \"results\": [", quoted(program).c_str());
+        for (std::size_t i = 0; i < results().size(); i++)
+        {
+            const auto &item = results()[i];
+            std::fprintf(file, "%s\n    { \"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.3f }",
+                         i > 0 ? "," : "", quoted(item.name).c_str(), item.iterations, item.ns_per_op);
+        }
+
+        std::fprintf(file, "\n  ]\n}\n");
+        std::fclose(file);
+        return 0;
+    }
+}
+
+#endif // BENCH_H
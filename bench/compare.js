@@ -0,0 +1,56 @@
+// Compares two benchmark runs written with --json: single files or directories of them (bench_run writes results/).
+// usage: node bench/compare.js <baseline> <current> [threshold %, default 5]
+// Prints the change of every benchmark and exits with 1 when one got slower by more than the threshold.
+const fs = require('fs');
+const path = require('path');
+
+function load(location) {
+    const files = fs.statSync(location).isDirectory()
+        ? fs.readdirSync(location).filter(f => f.endsWith('.json')).map(f => path.join(location, f))
+        : [location];
+
+    const results = new Map();
+    files.forEach(file => {
+        const run = JSON.parse(fs.readFileSync(file, 'utf8'));
+        run.results.forEach(r => results.set(run.benchmark + ': ' + r.name, r.ns_per_op));
+    });
+
+    return results;
+}
+
+if (process.argv.length < 4) {
+    console.log('usage: node compare.js <baseline> <current> [threshold %]');
+    process.exit(2);
+}
+
+const baseline = load(process.argv[2]);
+const current = load(process.argv[3]);
+const threshold = process.argv.length > 4 ? Number(process.argv[4]) : 5;
+
+let regressions = 0;
+current.forEach((ns, name) => {
+    const before = baseline.get(name);
+    if (before === undefined) {
+        console.log(`${name.padEnd(60)} ${ns.toFixed(2).padStart(12)} ns/op   (new)`);
+        return;
+    }
+
+    const change = before > 0 ? (ns - before) / before * 100 : 0;
+    const regressed = change > threshold;
+    if (regressed) {
+        regressions++;
+    }
+
+    const sign = change >= 0 ? '+' : '';
+    console.log(`${name.padEnd(60)} ${ns.toFixed(2).padStart(12)} ns/op ${(sign + change.toFixed(1) + '%').padStart(9)}`
+        + (regressed ? '   REGRESSION' : ''));
+});
+
+baseline.forEach((ns, name) => {
+    if (!current.has(name)) {
+        console.log(`${name.padEnd(60)} (missing)`);
+    }
+});
+
+console.log(regressions ? `${regressions} regression(s) over ${threshold}%` : `no regressions over ${threshold}%`);
+process.exit(regressions ? 1 : 0);
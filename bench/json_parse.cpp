@@ -0,0 +1,73 @@
+// JSON.parse throughput in GB/s for stage 1 (structural index) alone and for the whole parse into js::any.
+// Pass JSON files as arguments, the usual corpus is twitter.json and citm_catalog.json from the simdjson repository.
+#include "core.h"
+#include "bench.h"
+
+#include <fstream>
+
+using namespace js;
+
+static bool read_file(const char *path, std::string &text)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::printf("usage: %s twitter.json citm_catalog.json ...\n", argv[0]);
+        return 1;
+    }
+
+#ifdef JS_SSE2
+    std::printf("stage 1: sse2\n");
+#else
+    std::printf("stage 1: scalar\n");
+#endif
+
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+        {
+            i++;
+            continue;
+        }
+
+        std::string text;
+        if (!read_file(argv[i], text) || text.empty())
+        {
+            std::printf("%s: can't read\n", argv[i]);
+            continue;
+        }
+
+        // about 1 GB of input per measurement
+        const auto iterations = std::max<std::size_t>(10, (std::size_t{1} << 30) / text.size());
+        std::printf("%s: %zu bytes\n", argv[i], text.size());
+
+        std::vector<std::uint32_t> index;
+        const auto stage1 = bench::run("  stage 1", iterations, [&](std::size_t) {
+            json::index_structurals(text, index);
+            bench::do_not_optimize(index);
+        });
+
+        const auto parse = bench::run("  JSON.parse", iterations, [&](std::size_t) {
+            auto value = json::parse(text);
+            bench::do_not_optimize(value);
+        });
+
+        // bytes per nanosecond is GB/s
+        std::printf("  stage 1 %.2f GB/s, JSON.parse %.2f GB/s\n", text.size() / stage1, text.size() / parse);
+    }
+
+    return bench::report(argc, argv);
+}
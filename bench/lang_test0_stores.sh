@@ -0,0 +1,31 @@
+#!/bin/sh
+# counts object/array backing stores allocated and saved by lazy allocation for every test of test/lang-test0
+# usage: bench/lang_test0_stores.sh   (run from repository root after 'npm run build', CXX defaults to clang++)
+CXX=${CXX:-clang++}
+ROOT=$(pwd)
+WORK=$ROOT/__bench_stores
+mkdir -p $WORK
+cp test/tsconfig.json $WORK/
+
+total_allocated=0
+total_saved=0
+for test in test/lang-test0/[0-9]*.ts; do
+    name=$(basename $test .ts)
+    if [ "$name" = "99final" ]; then
+        continue
+    fi
+
+    cat test/lang-test0/lang-test0.ts $test test/lang-test0/99final.ts > $WORK/test.ts
+    (cd $WORK && node $ROOT/__out/main.js > /dev/null) || { echo "$name: transpile failed"; continue; }
+    $CXX -std=c++20 -O2 -DJS_STATS -Wno-switch -Wno-deprecated-declarations -I$ROOT/cpplib $WORK/test.cpp -o $WORK/test.exe 2> /dev/null \
+        || { echo "$name: build failed"; continue; }
+
+    stats=$($WORK/test.exe 2>&1 > /dev/null | grep "stores allocated")
+    echo "$name: $stats"
+    allocated=$(echo "$stats" | sed -n 's/.*stores allocated: \([0-9]*\).*/\1/p')
+    saved=$(echo "$stats" | sed -n 's/.*allocations saved: \([0-9]*\).*/\1/p')
+    total_allocated=$((total_allocated + ${allocated:-0}))
+    total_saved=$((total_saved + ${saved:-0}))
+done
+
+echo "total: stores allocated: $total_allocated, allocations saved: $total_saved"
@@ -0,0 +1,607 @@
+// DeltaBlue: incremental one-way dataflow constraint solver, after the V8 benchmark suite port of
+// John Maloney and Mario Wolczko's Smalltalk program. Every run builds a chain and a projection of constraints,
+// edits their inputs and checks the propagated values.
+
+const CHAIN_SIZE = 100;
+
+const DIRECTION_NONE = 0;
+const DIRECTION_FORWARD = 1;
+const DIRECTION_BACKWARD = -1;
+
+class Strength {
+    strengthValue: number;
+    name: string;
+
+    constructor(strengthValue: number, name: string) {
+        this.strengthValue = strengthValue;
+        this.name = name;
+    }
+
+    static stronger(s1: Strength, s2: Strength): boolean {
+        return s1.strengthValue < s2.strengthValue;
+    }
+
+    static weaker(s1: Strength, s2: Strength): boolean {
+        return s1.strengthValue > s2.strengthValue;
+    }
+
+    static weakestOf(s1: Strength, s2: Strength): Strength {
+        return Strength.weaker(s1, s2) ? s1 : s2;
+    }
+
+    nextWeaker(): Strength {
+        switch (this.strengthValue) {
+            case 0: return STRONG_PREFERRED;
+            case 1: return PREFERRED;
+            case 2: return STRONG_DEFAULT;
+            case 3: return NORMAL;
+            case 4: return WEAK_DEFAULT;
+            case 5: return WEAKEST;
+        }
+
+        throw "deltablue: no weaker strength";
+    }
+}
+
+const REQUIRED = new Strength(0, "required");
+const STRONG_PREFERRED = new Strength(1, "strongPreferred");
+const PREFERRED = new Strength(2, "preferred");
+const STRONG_DEFAULT = new Strength(3, "strongDefault");
+const NORMAL = new Strength(4, "normal");
+const WEAK_DEFAULT = new Strength(5, "weakDefault");
+const WEAKEST = new Strength(6, "weakest");
+
+abstract class Constraint {
+    strength: Strength;
+
+    constructor(strength: Strength) {
+        this.strength = strength;
+    }
+
+    abstract addToGraph(): void;
+    abstract removeFromGraph(): void;
+    abstract chooseMethod(mark: number): void;
+    abstract markInputs(mark: number): void;
+    abstract inputsKnown(mark: number): boolean;
+    abstract output(): Variable;
+    abstract execute(): void;
+    abstract recalculate(): void;
+    abstract markUnsatisfied(): void;
+    abstract isSatisfied(): boolean;
+
+    isInput(): boolean {
+        return false;
+    }
+
+    addConstraint() {
+        this.addToGraph();
+        planner.incrementalAdd(this);
+    }
+
+    satisfy(mark: number): Constraint {
+        this.chooseMethod(mark);
+        if (!this.isSatisfied()) {
+            if (this.strength == REQUIRED) {
+                throw "deltablue: could not satisfy a required constraint";
+            }
+
+            return null;
+        }
+
+        this.markInputs(mark);
+        const out = this.output();
+        const overridden = out.determinedBy;
+        if (overridden != null) {
+            overridden.markUnsatisfied();
+        }
+
+        out.determinedBy = this;
+        if (!planner.addPropagate(this, mark)) {
+            throw "deltablue: cycle encountered";
+        }
+
+        out.mark = mark;
+        return overridden;
+    }
+
+    destroyConstraint() {
+        if (this.isSatisfied()) {
+            planner.incrementalRemove(this);
+        } else {
+            this.removeFromGraph();
+        }
+    }
+}
+
+abstract class UnaryConstraint extends Constraint {
+    myOutput: Variable;
+    satisfied: boolean;
+
+    constructor(v: Variable, strength: Strength) {
+        super(strength);
+        this.myOutput = v;
+        this.satisfied = false;
+        this.addConstraint();
+    }
+
+    addToGraph() {
+        this.myOutput.addConstraint(this);
+        this.satisfied = false;
+    }
+
+    chooseMethod(mark: number) {
+        this.satisfied = this.myOutput.mark != mark && Strength.stronger(this.strength, this.myOutput.walkStrength);
+    }
+
+    isSatisfied(): boolean {
+        return this.satisfied;
+    }
+
+    markInputs(mark: number) {
+    }
+
+    output(): Variable {
+        return this.myOutput;
+    }
+
+    recalculate() {
+        this.myOutput.walkStrength = this.strength;
+        this.myOutput.stay = !this.isInput();
+        if (this.myOutput.stay) {
+            this.execute();
+        }
+    }
+
+    markUnsatisfied() {
+        this.satisfied = false;
+    }
+
+    inputsKnown(mark: number): boolean {
+        return true;
+    }
+
+    removeFromGraph() {
+        if (this.myOutput != null) {
+            this.myOutput.removeConstraint(this);
+        }
+
+        this.satisfied = false;
+    }
+}
+
+class StayConstraint extends UnaryConstraint {
+    constructor(v: Variable, strength: Strength) {
+        super(v, strength);
+    }
+
+    execute() {
+    }
+}
+
+class EditConstraint extends UnaryConstraint {
+    constructor(v: Variable, strength: Strength) {
+        super(v, strength);
+    }
+
+    isInput(): boolean {
+        return true;
+    }
+
+    execute() {
+    }
+}
+
+abstract class BinaryConstraint extends Constraint {
+    v1: Variable;
+    v2: Variable;
+    direction: number;
+
+    constructor(var1: Variable, var2: Variable, strength: Strength) {
+        super(strength);
+        this.v1 = var1;
+        this.v2 = var2;
+        this.direction = DIRECTION_NONE;
+    }
+
+    chooseMethod(mark: number) {
+        if (this.v1.mark == mark) {
+            this.direction = (this.v2.mark != mark && Strength.stronger(this.strength, this.v2.walkStrength))
+                ? DIRECTION_FORWARD
+                : DIRECTION_NONE;
+        }
+
+        if (this.v2.mark == mark) {
+            this.direction = (this.v1.mark != mark && Strength.stronger(this.strength, this.v1.walkStrength))
+                ? DIRECTION_BACKWARD
+                : DIRECTION_NONE;
+        }
+
+        if (Strength.weaker(this.v1.walkStrength, this.v2.walkStrength)) {
+            this.direction = Strength.stronger(this.strength, this.v1.walkStrength) ? DIRECTION_BACKWARD : DIRECTION_NONE;
+        } else {
+            this.direction = Strength.stronger(this.strength, this.v2.walkStrength) ? DIRECTION_FORWARD : DIRECTION_BACKWARD;
+        }
+    }
+
+    addToGraph() {
+        this.v1.addConstraint(this);
+        this.v2.addConstraint(this);
+        this.direction = DIRECTION_NONE;
+    }
+
+    isSatisfied(): boolean {
+        return this.direction != DIRECTION_NONE;
+    }
+
+    markInputs(mark: number) {
+        this.input().mark = mark;
+    }
+
+    input(): Variable {
+        return this.direction == DIRECTION_FORWARD ? this.v1 : this.v2;
+    }
+
+    output(): Variable {
+        return this.direction == DIRECTION_FORWARD ? this.v2 : this.v1;
+    }
+
+    recalculate() {
+        const ihn = this.input();
+        const out = this.output();
+        out.walkStrength = Strength.weakestOf(this.strength, ihn.walkStrength);
+        out.stay = ihn.stay;
+        if (out.stay) {
+            this.execute();
+        }
+    }
+
+    markUnsatisfied() {
+        this.direction = DIRECTION_NONE;
+    }
+
+    inputsKnown(mark: number): boolean {
+        const i = this.input();
+        return i.mark == mark || i.stay || i.determinedBy == null;
+    }
+
+    removeFromGraph() {
+        if (this.v1 != null) {
+            this.v1.removeConstraint(this);
+        }
+
+        if (this.v2 != null) {
+            this.v2.removeConstraint(this);
+        }
+
+        this.direction = DIRECTION_NONE;
+    }
+}
+
+class ScaleConstraint extends BinaryConstraint {
+    scale: Variable;
+    offset: Variable;
+
+    constructor(src: Variable, scale: Variable, offset: Variable, dest: Variable, strength: Strength) {
+        super(src, dest, strength);
+        this.scale = scale;
+        this.offset = offset;
+        this.addConstraint();
+    }
+
+    addToGraph() {
+        super.addToGraph();
+        this.scale.addConstraint(this);
+        this.offset.addConstraint(this);
+    }
+
+    removeFromGraph() {
+        super.removeFromGraph();
+        if (this.scale != null) {
+            this.scale.removeConstraint(this);
+        }
+
+        if (this.offset != null) {
+            this.offset.removeConstraint(this);
+        }
+    }
+
+    markInputs(mark: number) {
+        super.markInputs(mark);
+        this.scale.mark = mark;
+        this.offset.mark = mark;
+    }
+
+    execute() {
+        if (this.direction == DIRECTION_FORWARD) {
+            this.v2.value = this.v1.value * this.scale.value + this.offset.value;
+        } else {
+            this.v1.value = (this.v2.value - this.offset.value) / this.scale.value;
+        }
+    }
+
+    recalculate() {
+        const ihn = this.input();
+        const out = this.output();
+        out.walkStrength = Strength.weakestOf(this.strength, ihn.walkStrength);
+        out.stay = ihn.stay && this.scale.stay && this.offset.stay;
+        if (out.stay) {
+            this.execute();
+        }
+    }
+}
+
+class EqualityConstraint extends BinaryConstraint {
+    constructor(var1: Variable, var2: Variable, strength: Strength) {
+        super(var1, var2, strength);
+        this.addConstraint();
+    }
+
+    execute() {
+        this.output().value = this.input().value;
+    }
+}
+
+class Variable {
+    value: number;
+    constraints: Constraint[];
+    determinedBy: Constraint;
+    mark: number;
+    walkStrength: Strength;
+    stay: boolean;
+    name: string;
+
+    constructor(name: string, initialValue: number) {
+        this.value = initialValue;
+        this.constraints = [];
+        this.determinedBy = null;
+        this.mark = 0;
+        this.walkStrength = WEAKEST;
+        this.stay = true;
+        this.name = name;
+    }
+
+    addConstraint(c: Constraint) {
+        this.constraints.push(c);
+    }
+
+    removeConstraint(c: Constraint) {
+        const index = this.constraints.indexOf(c);
+        if (index >= 0) {
+            this.constraints.splice(index, 1);
+        }
+
+        if (this.determinedBy == c) {
+            this.determinedBy = null;
+        }
+    }
+}
+
+class Plan {
+    v: Constraint[];
+
+    constructor() {
+        this.v = [];
+    }
+
+    addConstraint(c: Constraint) {
+        this.v.push(c);
+    }
+
+    execute() {
+        for (const c of this.v) {
+            c.execute();
+        }
+    }
+}
+
+class Planner {
+    currentMark: number;
+
+    constructor() {
+        this.currentMark = 0;
+    }
+
+    incrementalAdd(c: Constraint) {
+        const mark = this.newMark();
+        let overridden = c.satisfy(mark);
+        while (overridden != null) {
+            overridden = overridden.satisfy(mark);
+        }
+    }
+
+    incrementalRemove(c: Constraint) {
+        const out = c.output();
+        c.markUnsatisfied();
+        c.removeFromGraph();
+        const unsatisfied = this.removePropagateFrom(out);
+        let strength = REQUIRED;
+        do {
+            for (const u of unsatisfied) {
+                if (u.strength == strength) {
+                    this.incrementalAdd(u);
+                }
+            }
+
+            strength = strength.nextWeaker();
+        } while (strength != WEAKEST);
+    }
+
+    newMark(): number {
+        return ++this.currentMark;
+    }
+
+    makePlan(sources: Constraint[]): Plan {
+        const mark = this.newMark();
+        const plan = new Plan();
+        const todo = sources;
+        while (todo.length > 0) {
+            const c = todo.pop();
+            if (c.output().mark != mark && c.inputsKnown(mark)) {
+                plan.addConstraint(c);
+                c.output().mark = mark;
+                this.addConstraintsConsumingTo(c.output(), todo);
+            }
+        }
+
+        return plan;
+    }
+
+    extractPlanFromConstraints(constraints: Constraint[]): Plan {
+        const sources: Constraint[] = [];
+        for (const c of constraints) {
+            if (c.isInput() && c.isSatisfied()) {
+                sources.push(c);
+            }
+        }
+
+        return this.makePlan(sources);
+    }
+
+    addPropagate(c: Constraint, mark: number): boolean {
+        const todo: Constraint[] = [c];
+        while (todo.length > 0) {
+            const d = todo.pop();
+            if (d.output().mark == mark) {
+                this.incrementalRemove(c);
+                return false;
+            }
+
+            d.recalculate();
+            this.addConstraintsConsumingTo(d.output(), todo);
+        }
+
+        return true;
+    }
+
+    removePropagateFrom(out: Variable): Constraint[] {
+        out.determinedBy = null;
+        out.walkStrength = WEAKEST;
+        out.stay = true;
+        const unsatisfied: Constraint[] = [];
+        const todo: Variable[] = [out];
+        while (todo.length > 0) {
+            const v = todo.pop();
+            for (const c of v.constraints) {
+                if (!c.isSatisfied()) {
+                    unsatisfied.push(c);
+                }
+            }
+
+            const determining = v.determinedBy;
+            for (const next of v.constraints) {
+                if (next != determining && next.isSatisfied()) {
+                    next.recalculate();
+                    todo.push(next.output());
+                }
+            }
+        }
+
+        return unsatisfied;
+    }
+
+    addConstraintsConsumingTo(v: Variable, coll: Constraint[]) {
+        const determining = v.determinedBy;
+        for (const c of v.constraints) {
+            if (c != determining && c.isSatisfied()) {
+                coll.push(c);
+            }
+        }
+    }
+}
+
+let planner: Planner = null;
+
+function chainTest(n: number) {
+    planner = new Planner();
+    let prev: Variable = null;
+    let first: Variable = null;
+    let last: Variable = null;
+
+    // a chain of equality constraints from the first to the last variable
+    for (let i = 0; i <= n; i++) {
+        const v = new Variable("v" + i, 0);
+        if (prev != null) {
+            new EqualityConstraint(prev, v, REQUIRED);
+        }
+
+        if (i == 0) {
+            first = v;
+        }
+
+        if (i == n) {
+            last = v;
+        }
+
+        prev = v;
+    }
+
+    new StayConstraint(last, STRONG_DEFAULT);
+    const edit = new EditConstraint(first, PREFERRED);
+    const plan = planner.extractPlanFromConstraints([edit]);
+    for (let i = 0; i < 100; i++) {
+        first.value = i;
+        plan.execute();
+        if (last.value != i) {
+            throw "deltablue: chain test failed, " + last.value + " != " + i;
+        }
+    }
+}
+
+function change(v: Variable, newValue: number) {
+    const edit = new EditConstraint(v, PREFERRED);
+    const plan = planner.extractPlanFromConstraints([edit]);
+    for (let i = 0; i < 10; i++) {
+        v.value = newValue;
+        plan.execute();
+    }
+
+    edit.destroyConstraint();
+}
+
+function projectionTest(n: number) {
+    planner = new Planner();
+    const scale = new Variable("scale", 10);
+    const offset = new Variable("offset", 1000);
+    let src: Variable = null;
+    let dst: Variable = null;
+
+    const dests: Variable[] = [];
+    for (let i = 0; i < n; i++) {
+        src = new Variable("src" + i, i);
+        dst = new Variable("dst" + i, i);
+        dests.push(dst);
+        new StayConstraint(src, NORMAL);
+        new ScaleConstraint(src, scale, offset, dst, REQUIRED);
+    }
+
+    change(src, 17);
+    if (dst.value != 1170) {
+        throw "deltablue: projection 1 failed";
+    }
+
+    change(dst, 1050);
+    if (src.value != 5) {
+        throw "deltablue: projection 2 failed";
+    }
+
+    change(scale, 5);
+    for (let i = 0; i < n - 1; i++) {
+        if (dests[i].value != i * 5 + 1000) {
+            throw "deltablue: projection 3 failed";
+        }
+    }
+
+    change(offset, 2000);
+    for (let i = 0; i < n - 1; i++) {
+        if (dests[i].value != i * 5 + 2000) {
+            throw "deltablue: projection 4 failed";
+        }
+    }
+}
+
+function runDeltaBlue() {
+    chainTest(CHAIN_SIZE);
+    projectionTest(CHAIN_SIZE);
+}
+
+runDeltaBlue();
@@ -0,0 +1,61 @@
+// JSON: builds a catalog of records, writes it with JSON.stringify, reads it back with JSON.parse
+// and walks the result. Every run checks the round trip by the totals of the parsed records.
+
+const RECORDS = 200;
+
+interface Item {
+    id: number;
+    name: string;
+    price: number;
+    tags: string[];
+    available: boolean;
+}
+
+interface Catalog {
+    title: string;
+    items: Item[];
+}
+
+function buildCatalog(): Catalog {
+    const items: Item[] = [];
+    for (let i = 0; i < RECORDS; i++) {
+        items.push({
+            id: i,
+            name: "item " + i,
+            price: i * 1.25,
+            tags: ["tag" + (i % 7), "group" + (i % 3)],
+            available: i % 2 == 0
+        });
+    }
+
+    return { title: "catalog \"benchmark\"", items: items };
+}
+
+function runJson() {
+    const text = JSON.stringify(buildCatalog());
+    const parsed: any = JSON.parse(text);
+
+    let count = 0;
+    let total = 0;
+    let tags = 0;
+    for (const item of parsed.items) {
+        count++;
+        total += item.price;
+        tags += item.tags.length;
+        if (item.available) {
+            total += 1;
+        }
+    }
+
+    // sum of i * 1.25 over the records plus one per available record
+    const expected = 1.25 * RECORDS * (RECORDS - 1) / 2 + RECORDS / 2;
+    if (count != RECORDS || tags != 2 * RECORDS || total != expected || parsed.title != "catalog \"benchmark\"") {
+        throw "json: wrong result, " + count + " records, total " + total;
+    }
+
+    if (JSON.stringify(parsed) != text) {
+        throw "json: stringify of the parsed text differs";
+    }
+}
+
+runJson();
@@ -0,0 +1,153 @@
+// N-body: the Jovian planets orbiting the sun, after the Computer Language Benchmarks Game program.
+// Every run advances the system from the same start and checks the energy against the reference output.
+
+const SOLAR_MASS = 4 * Math.PI * Math.PI;
+const DAYS_PER_YEAR = 365.24;
+const STEPS = 1000;
+const EXPECTED_ENERGY = -0.169087605;
+
+class Body {
+    x: number;
+    y: number;
+    z: number;
+    vx: number;
+    vy: number;
+    vz: number;
+    mass: number;
+
+    constructor(x: number, y: number, z: number, vx: number, vy: number, vz: number, mass: number) {
+        this.x = x;
+        this.y = y;
+        this.z = z;
+        this.vx = vx;
+        this.vy = vy;
+        this.vz = vz;
+        this.mass = mass;
+    }
+}
+
+function jupiter(): Body {
+    return new Body(
+        4.84143144246472090e+00,
+        -1.16032004402742839e+00,
+        -1.03622044471123109e-01,
+        1.66007664274403694e-03 * DAYS_PER_YEAR,
+        7.69901118419740425e-03 * DAYS_PER_YEAR,
+        -6.90460016972063023e-05 * DAYS_PER_YEAR,
+        9.54791938424326609e-04 * SOLAR_MASS);
+}
+
+function saturn(): Body {
+    return new Body(
+        8.34336671824457987e+00,
+        4.12479856412430479e+00,
+        -4.03523417114321381e-01,
+        -2.76742510726862411e-03 * DAYS_PER_YEAR,
+        4.99852801234917238e-03 * DAYS_PER_YEAR,
+        2.30417297573763929e-05 * DAYS_PER_YEAR,
+        2.85885980666130812e-04 * SOLAR_MASS);
+}
+
+function uranus(): Body {
+    return new Body(
+        1.28943695621391310e+01,
+        -1.51111514016986312e+01,
+        -2.23307578892655734e-01,
+        2.96460137564761618e-03 * DAYS_PER_YEAR,
+        2.37847173959480950e-03 * DAYS_PER_YEAR,
+        -2.96589568540237556e-05 * DAYS_PER_YEAR,
+        4.36624404335156298e-05 * SOLAR_MASS);
+}
+
+function neptune(): Body {
+    return new Body(
+        1.53796971148509165e+01,
+        -2.59193146099879641e+01,
+        1.79258772950371181e-01,
+        2.68067772490389322e-03 * DAYS_PER_YEAR,
+        1.62824170038242295e-03 * DAYS_PER_YEAR,
+        -9.51592254519715870e-05 * DAYS_PER_YEAR,
+        5.15138902046611451e-05 * SOLAR_MASS);
+}
+
+function sun(): Body {
+    return new Body(0, 0, 0, 0, 0, 0, SOLAR_MASS);
+}
+
+function offsetMomentum(bodies: Body[]) {
+    let px = 0;
+    let py = 0;
+    let pz = 0;
+    for (const body of bodies) {
+        px += body.vx * body.mass;
+        py += body.vy * body.mass;
+        pz += body.vz * body.mass;
+    }
+
+    bodies[0].vx = -px / SOLAR_MASS;
+    bodies[0].vy = -py / SOLAR_MASS;
+    bodies[0].vz = -pz / SOLAR_MASS;
+}
+
+function advance(bodies: Body[], dt: number) {
+    const size = bodies.length;
+    for (let i = 0; i < size; i++) {
+        const bi = bodies[i];
+        for (let j = i + 1; j < size; j++) {
+            const bj = bodies[j];
+            const dx = bi.x - bj.x;
+            const dy = bi.y - bj.y;
+            const dz = bi.z - bj.z;
+
+            const distance2 = dx * dx + dy * dy + dz * dz;
+            const magnitude = dt / (distance2 * Math.sqrt(distance2));
+
+            bi.vx -= dx * bj.mass * magnitude;
+            bi.vy -= dy * bj.mass * magnitude;
+            bi.vz -= dz * bj.mass * magnitude;
+
+            bj.vx += dx * bi.mass * magnitude;
+            bj.vy += dy * bi.mass * magnitude;
+            bj.vz += dz * bi.mass * magnitude;
+        }
+    }
+
+    for (const body of bodies) {
+        body.x += dt * body.vx;
+        body.y += dt * body.vy;
+        body.z += dt * body.vz;
+    }
+}
+
+function energy(bodies: Body[]): number {
+    let e = 0;
+    const size = bodies.length;
+    for (let i = 0; i < size; i++) {
+        const bi = bodies[i];
+        e += 0.5 * bi.mass * (bi.vx * bi.vx + bi.vy * bi.vy + bi.vz * bi.vz);
+        for (let j = i + 1; j < size; j++) {
+            const bj = bodies[j];
+            const dx = bi.x - bj.x;
+            const dy = bi.y - bj.y;
+            const dz = bi.z - bj.z;
+            e -= (bi.mass * bj.mass) / Math.sqrt(dx * dx + dy * dy + dz * dz);
+        }
+    }
+
+    return e;
+}
+
+function runNBody() {
+    const bodies: Body[] = [sun(), jupiter(), saturn(), uranus(), neptune()];
+    offsetMomentum(bodies);
+    for (let i = 0; i < STEPS; i++) {
+        advance(bodies, 0.01);
+    }
+
+    const e = energy(bodies);
+    if (Math.abs(e - EXPECTED_ENERGY) > 1e-9) {
+        throw "nbody: wrong result, energy " + e;
+    }
+}
+
+runNBody();
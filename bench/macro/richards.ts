@@ -0,0 +1,382 @@
+// Richards: operating system task scheduler simulation, after the benchmark by Martin Richards
+// as found in the V8 benchmark suite. Every run schedules the same tasks and checks the counters.
+
+const COUNT = 1000;
+const EXPECTED_QUEUE_COUNT = 2322;
+const EXPECTED_HOLD_COUNT = 928;
+
+const ID_IDLE = 0;
+const ID_WORKER = 1;
+const ID_HANDLER_A = 2;
+const ID_HANDLER_B = 3;
+const ID_DEVICE_A = 4;
+const ID_DEVICE_B = 5;
+
+const KIND_DEVICE = 0;
+const KIND_WORK = 1;
+
+const DATA_SIZE = 4;
+
+const STATE_RUNNING = 0;
+const STATE_RUNNABLE = 1;
+const STATE_SUSPENDED = 2;
+const STATE_HELD = 4;
+const STATE_SUSPENDED_RUNNABLE = STATE_SUSPENDED | STATE_RUNNABLE;
+const STATE_NOT_HELD = ~STATE_HELD;
+
+class Packet {
+    link: Packet;
+    id: number;
+    kind: number;
+    a1: number;
+    a2: number[];
+
+    constructor(link: Packet, id: number, kind: number) {
+        this.link = link;
+        this.id = id;
+        this.kind = kind;
+        this.a1 = 0;
+        this.a2 = [0, 0, 0, 0];
+    }
+
+    addTo(queue: Packet): Packet {
+        this.link = null;
+        if (queue == null) {
+            return this;
+        }
+
+        let next = queue;
+        let peek = next.link;
+        while (peek != null) {
+            next = peek;
+            peek = next.link;
+        }
+
+        next.link = this;
+        return queue;
+    }
+}
+
+abstract class Task {
+    abstract run(packet: Packet): TaskControlBlock;
+}
+
+class TaskControlBlock {
+    link: TaskControlBlock;
+    id: number;
+    priority: number;
+    queue: Packet;
+    task: Task;
+    state: number;
+
+    constructor(link: TaskControlBlock, id: number, priority: number, queue: Packet, task: Task) {
+        this.link = link;
+        this.id = id;
+        this.priority = priority;
+        this.queue = queue;
+        this.task = task;
+        this.state = queue == null ? STATE_SUSPENDED : STATE_SUSPENDED_RUNNABLE;
+    }
+
+    setRunning() {
+        this.state = STATE_RUNNING;
+    }
+
+    markAsNotHeld() {
+        this.state = this.state & STATE_NOT_HELD;
+    }
+
+    markAsHeld() {
+        this.state = this.state | STATE_HELD;
+    }
+
+    isHeldOrSuspended(): boolean {
+        return (this.state & STATE_HELD) != 0 || (this.state == STATE_SUSPENDED);
+    }
+
+    markAsSuspended() {
+        this.state = this.state | STATE_SUSPENDED;
+    }
+
+    markAsRunnable() {
+        this.state = this.state | STATE_RUNNABLE;
+    }
+
+    run(): TaskControlBlock {
+        let packet: Packet = null;
+        if (this.state == STATE_SUSPENDED_RUNNABLE) {
+            packet = this.queue;
+            this.queue = packet.link;
+            this.state = this.queue == null ? STATE_RUNNING : STATE_RUNNABLE;
+        }
+
+        return this.task.run(packet);
+    }
+
+    checkPriorityAdd(task: TaskControlBlock, packet: Packet): TaskControlBlock {
+        if (this.queue == null) {
+            this.queue = packet;
+            this.markAsRunnable();
+            if (this.priority > task.priority) {
+                return this;
+            }
+        } else {
+            this.queue = packet.addTo(this.queue);
+        }
+
+        return task;
+    }
+}
+
+class Scheduler {
+    queueCount: number;
+    holdCount: number;
+    blocks: TaskControlBlock[];
+    list: TaskControlBlock;
+    currentTcb: TaskControlBlock;
+    currentId: number;
+
+    constructor() {
+        this.queueCount = 0;
+        this.holdCount = 0;
+        this.blocks = [null, null, null, null, null, null];
+        this.list = null;
+        this.currentTcb = null;
+        this.currentId = 0;
+    }
+
+    addIdleTask(id: number, priority: number, queue: Packet, count: number) {
+        this.addRunningTask(id, priority, queue, new IdleTask(this, 1, count));
+    }
+
+    addWorkerTask(id: number, priority: number, queue: Packet) {
+        this.addTask(id, priority, queue, new WorkerTask(this, ID_HANDLER_A, 0));
+    }
+
+    addHandlerTask(id: number, priority: number, queue: Packet) {
+        this.addTask(id, priority, queue, new HandlerTask(this));
+    }
+
+    addDeviceTask(id: number, priority: number, queue: Packet) {
+        this.addTask(id, priority, queue, new DeviceTask(this));
+    }
+
+    addRunningTask(id: number, priority: number, queue: Packet, task: Task) {
+        this.addTask(id, priority, queue, task);
+        this.currentTcb.setRunning();
+    }
+
+    addTask(id: number, priority: number, queue: Packet, task: Task) {
+        this.currentTcb = new TaskControlBlock(this.list, id, priority, queue, task);
+        this.list = this.currentTcb;
+        this.blocks[id] = this.currentTcb;
+    }
+
+    schedule() {
+        this.currentTcb = this.list;
+        while (this.currentTcb != null) {
+            if (this.currentTcb.isHeldOrSuspended()) {
+                this.currentTcb = this.currentTcb.link;
+            } else {
+                this.currentId = this.currentTcb.id;
+                this.currentTcb = this.currentTcb.run();
+            }
+        }
+    }
+
+    release(id: number): TaskControlBlock {
+        const tcb = this.blocks[id];
+        if (tcb == null) {
+            return tcb;
+        }
+
+        tcb.markAsNotHeld();
+        if (tcb.priority > this.currentTcb.priority) {
+            return tcb;
+        }
+
+        return this.currentTcb;
+    }
+
+    holdCurrent(): TaskControlBlock {
+        this.holdCount++;
+        this.currentTcb.markAsHeld();
+        return this.currentTcb.link;
+    }
+
+    suspendCurrent(): TaskControlBlock {
+        this.currentTcb.markAsSuspended();
+        return this.currentTcb;
+    }
+
+    queue(packet: Packet): TaskControlBlock {
+        const t = this.blocks[packet.id];
+        if (t == null) {
+            return t;
+        }
+
+        this.queueCount++;
+        packet.link = null;
+        packet.id = this.currentId;
+        return t.checkPriorityAdd(this.currentTcb, packet);
+    }
+}
+
+class IdleTask extends Task {
+    scheduler: Scheduler;
+    v1: number;
+    count: number;
+
+    constructor(scheduler: Scheduler, v1: number, count: number) {
+        super();
+        this.scheduler = scheduler;
+        this.v1 = v1;
+        this.count = count;
+    }
+
+    run(packet: Packet): TaskControlBlock {
+        this.count--;
+        if (this.count == 0) {
+            return this.scheduler.holdCurrent();
+        }
+
+        if ((this.v1 & 1) == 0) {
+            this.v1 = this.v1 >> 1;
+            return this.scheduler.release(ID_DEVICE_A);
+        }
+
+        this.v1 = (this.v1 >> 1) ^ 0xD008;
+        return this.scheduler.release(ID_DEVICE_B);
+    }
+}
+
+class DeviceTask extends Task {
+    scheduler: Scheduler;
+    v1: Packet;
+
+    constructor(scheduler: Scheduler) {
+        super();
+        this.scheduler = scheduler;
+        this.v1 = null;
+    }
+
+    run(packet: Packet): TaskControlBlock {
+        if (packet == null) {
+            if (this.v1 == null) {
+                return this.scheduler.suspendCurrent();
+            }
+
+            const v = this.v1;
+            this.v1 = null;
+            return this.scheduler.queue(v);
+        }
+
+        this.v1 = packet;
+        return this.scheduler.holdCurrent();
+    }
+}
+
+class WorkerTask extends Task {
+    scheduler: Scheduler;
+    v1: number;
+    v2: number;
+
+    constructor(scheduler: Scheduler, v1: number, v2: number) {
+        super();
+        this.scheduler = scheduler;
+        this.v1 = v1;
+        this.v2 = v2;
+    }
+
+    run(packet: Packet): TaskControlBlock {
+        if (packet == null) {
+            return this.scheduler.suspendCurrent();
+        }
+
+        this.v1 = this.v1 == ID_HANDLER_A ? ID_HANDLER_B : ID_HANDLER_A;
+        packet.id = this.v1;
+        packet.a1 = 0;
+        for (let i = 0; i < DATA_SIZE; i++) {
+            this.v2++;
+            if (this.v2 > 26) {
+                this.v2 = 1;
+            }
+
+            packet.a2[i] = this.v2;
+        }
+
+        return this.scheduler.queue(packet);
+    }
+}
+
+class HandlerTask extends Task {
+    scheduler: Scheduler;
+    v1: Packet;
+    v2: Packet;
+
+    constructor(scheduler: Scheduler) {
+        super();
+        this.scheduler = scheduler;
+        this.v1 = null;
+        this.v2 = null;
+    }
+
+    run(packet: Packet): TaskControlBlock {
+        if (packet != null) {
+            if (packet.kind == KIND_WORK) {
+                this.v1 = packet.addTo(this.v1);
+            } else {
+                this.v2 = packet.addTo(this.v2);
+            }
+        }
+
+        if (this.v1 != null) {
+            const count = this.v1.a1;
+            if (count < DATA_SIZE) {
+                if (this.v2 != null) {
+                    const v = this.v2;
+                    this.v2 = this.v2.link;
+                    v.a1 = this.v1.a2[count];
+                    this.v1.a1 = count + 1;
+                    return this.scheduler.queue(v);
+                }
+            } else {
+                const v = this.v1;
+                this.v1 = this.v1.link;
+                return this.scheduler.queue(v);
+            }
+        }
+
+        return this.scheduler.suspendCurrent();
+    }
+}
+
+function runRichards() {
+    const scheduler = new Scheduler();
+    scheduler.addIdleTask(ID_IDLE, 0, null, COUNT);
+
+    let queue = new Packet(null, ID_WORKER, KIND_WORK);
+    queue = new Packet(queue, ID_WORKER, KIND_WORK);
+    scheduler.addWorkerTask(ID_WORKER, 1000, queue);
+
+    queue = new Packet(null, ID_DEVICE_A, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_A, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_A, KIND_DEVICE);
+    scheduler.addHandlerTask(ID_HANDLER_A, 2000, queue);
+
+    queue = new Packet(null, ID_DEVICE_B, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_B, KIND_DEVICE);
+    queue = new Packet(queue, ID_DEVICE_B, KIND_DEVICE);
+    scheduler.addHandlerTask(ID_HANDLER_B, 3000, queue);
+
+    scheduler.addDeviceTask(ID_DEVICE_A, 4000, null);
+    scheduler.addDeviceTask(ID_DEVICE_B, 5000, null);
+
+    scheduler.schedule();
+
+    if (scheduler.queueCount != EXPECTED_QUEUE_COUNT || scheduler.holdCount != EXPECTED_HOLD_COUNT) {
+        throw "richards: wrong result, queue count " + scheduler.queueCount + ", hold count " + scheduler.holdCount;
+    }
+}
+
+runRichards();
@@ -0,0 +1,46 @@
+// Host of the macrobenchmarks: a TypeScript program transpiled with JS_NO_MAIN, so its top-level code is Main(),
+// which is timed per run. The program checks its own results and throws when they are wrong.
+#include "core.h"
+#include "bench.h"
+
+#include <cstdlib>
+
+#ifndef JS_BENCH_RUNS
+#define JS_BENCH_RUNS 10
+#endif
+
+void Main(void);
+
+int main(int argc, char **argv)
+{
+    const auto runs_option = bench::option(argc, argv, "--runs");
+    const auto runs = runs_option != nullptr ? std::strtoul(runs_option, nullptr, 10) : JS_BENCH_RUNS;
+
+    try
+    {
+        js::utils::finally flush([] { js::console->flush(); });
+        bench::run(JS_BENCH_NAME, runs, [](std::size_t) { Main(); });
+    }
+    catch (const js::string &s)
+    {
+        std::cout << "Exception: " << s << std::endl;
+        return 1;
+    }
+    catch (const js::any &a)
+    {
+        std::cout << "Exception: " << a << std::endl;
+        return 1;
+    }
+    catch (const std::exception &exception)
+    {
+        std::cout << "Exception: " << exception.what() << std::endl;
+        return 1;
+    }
+    catch (const char *s)
+    {
+        std::cout << "Exception: " << s << std::endl;
+        return 1;
+    }
+
+    return bench::report(argc, argv);
+}
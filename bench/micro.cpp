@@ -0,0 +1,193 @@
+// Microbenchmarks of the runtime types the emitted code is made of.
+// Run with --json results.json to keep the numbers, bench/compare.js compares two runs.
+#include "core.h"
+#include "bench.h"
+
+using namespace js;
+
+static void number_benchmarks()
+{
+    constexpr std::size_t iterations = 10000000;
+
+    number total(0);
+    bench::run("number add", iterations, [&](std::size_t i) {
+        total = total + number(i);
+    });
+
+    bench::run("number multiply/divide", iterations, [&](std::size_t i) {
+        total = total * number(1.5) / number(i + 1);
+    });
+
+    auto count = 0;
+    bench::run("number compare", iterations, [&](std::size_t i) {
+        count += number(i) < total ? 1 : 0;
+    });
+
+    bench::do_not_optimize(total);
+    bench::do_not_optimize(count);
+}
+
+static void string_benchmarks()
+{
+    constexpr std::size_t iterations = 1000000;
+
+    auto text = "The quick brown fox jumps over the lazy dog"_S;
+    bench::run("string concat", iterations, [&](std::size_t i) {
+        auto s = text + "!"_S + number(i);
+        bench::do_not_optimize(s);
+    });
+
+    bench::run("string slice", iterations, [&](std::size_t i) {
+        auto s = text.slice(number(4), number(4 + i % 16));
+        bench::do_not_optimize(s);
+    });
+
+    string built("");
+    bench::run("string append +=", iterations, [&](std::size_t) {
+        built += "x"_S;
+    });
+
+    bench::do_not_optimize(built);
+}
+
+static void object_benchmarks()
+{
+    constexpr std::size_t iterations = 1000000;
+    const js::string keys[] = {"alpha"_S, "beta"_S, "gamma"_S, "delta"_S, "epsilon"_S, "zeta"_S, "eta"_S, "theta"_S};
+
+    object o{};
+    for (auto &key : keys)
+    {
+        o[key] = number(0);
+    }
+
+    bench::run("object set", iterations, [&](std::size_t i) {
+        o[keys[i % 8]] = number(i);
+    });
+
+    number total(0);
+    bench::run("object get", iterations, [&](std::size_t i) {
+        total = total + static_cast<number>(o[keys[i % 8]]);
+    });
+
+    bench::do_not_optimize(total);
+}
+
+static void array_benchmarks()
+{
+    constexpr std::size_t iterations = 1000000;
+    constexpr std::size_t size = 1024;
+
+    array<number> values;
+    bench::run("array push", iterations, [&](std::size_t i) {
+        if (i % size == 0)
+        {
+            values = array<number>();
+        }
+
+        values.push(number(i));
+    });
+
+    for (std::size_t i = values.get_length(); i < size; i++)
+    {
+        values.push(number(i));
+    }
+
+    number total(0);
+    bench::run("array index", iterations, [&](std::size_t i) {
+        total = total + values[i % size];
+    });
+
+    bench::run("array iteration (1024 elements)", iterations / size, [&](std::size_t) {
+        for (auto &value : values)
+        {
+            total = total + value;
+        }
+    });
+
+    bench::do_not_optimize(total);
+}
+
+static void any_benchmarks()
+{
+    constexpr std::size_t iterations = 10000000;
+
+    any value;
+    bench::run("any from number", iterations, [&](std::size_t i) {
+        value = any(number(i));
+    });
+
+    number total(0);
+    bench::run("any to number", iterations, [&](std::size_t) {
+        total = total + static_cast<number>(value);
+    });
+
+    any one(number(1));
+    bench::run("any + any", iterations, [&](std::size_t) {
+        value = value + one;
+    });
+
+    bench::run("any to string", iterations / 10, [&](std::size_t) {
+        auto s = static_cast<js::string>(value);
+        bench::do_not_optimize(s);
+    });
+
+    bench::do_not_optimize(total);
+}
+
+static void closure_benchmarks()
+{
+    constexpr std::size_t iterations = 10000000;
+
+    number captured(1);
+    auto lambda = [=](number x) { return x + captured; };
+
+    number total(0);
+    bench::run("closure call (direct)", iterations, [&](std::size_t i) {
+        total = total + lambda(number(i));
+    });
+
+    // what a value of function type holds: the lambda behind function_t
+    any function = lambda;
+    bench::run("closure call (function_t)", iterations / 10, [&](std::size_t i) {
+        total = total + static_cast<number>(function(number(i)));
+    });
+
+    bench::do_not_optimize(total);
+}
+
+static void switch_benchmarks()
+{
+    constexpr std::size_t iterations = 10000000;
+    const any keys[] = {any("add"_S), any("sub"_S), any("mul"_S), any("div"_S),
+                        any("mod"_S), any("and"_S), any("or"_S), any("xor"_S)};
+
+    // switch over values typed any
+    switch_type labels = {{keys[0], 0}, {keys[1], 1}, {keys[2], 2}, {keys[3], 3},
+                          {keys[4], 4}, {keys[5], 5}, {keys[6], 6}, {keys[7], 7}};
+    std::size_t total = 0;
+    bench::run("switch_type dispatch", iterations, [&](std::size_t i) {
+        total += labels[keys[i % 8]];
+    });
+
+    // switch over strings, the emitter's perfect hash
+    static constexpr string_switch strings{TXT("add"), TXT("sub"), TXT("mul"), TXT("div"),
+                                           TXT("mod"), TXT("and"), TXT("or"), TXT("xor")};
+    bench::run("string_switch dispatch", iterations, [&](std::size_t i) {
+        total += strings.index(keys[i % 8]);
+    });
+
+    bench::do_not_optimize(total);
+}
+
+int main(int argc, char **argv)
+{
+    number_benchmarks();
+    string_benchmarks();
+    object_benchmarks();
+    array_benchmarks();
+    any_benchmarks();
+    closure_benchmarks();
+    switch_benchmarks();
+    return bench::report(argc, argv);
+}
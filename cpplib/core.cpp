@@ -0,0 +1,7 @@
+// jscore: the template instances listed by JS_CORE_INSTANCES, translation units built with JS_CORE_LIB use these
+// instead of emitting the members they do not inline
+#include "core.h"
+
+#define JS_CORE_INSTANCE(...) template __VA_ARGS__;
+JS_CORE_INSTANCES(JS_CORE_INSTANCE)
+#undef JS_CORE_INSTANCE
@@ -4,6 +4,8 @@
 #include <cinttypes>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <bit>
 #include <functional>
 #include <type_traits>
 #include <vector>
@@ -27,19 +29,46 @@
 #include <chrono>
 #include <thread>
 #include <future>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <cfloat>
+#include <climits>
+#include <cerrno>
+#include <unordered_set>
+#include <deque>
+#include <mutex>
+#include <fstream>
+#include <csignal>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JS_SSE2
+#endif
 
 namespace js
 {
 
-//#define OR(x, y) ((bool)(x) ? (x) : (y))
-//#define AND(x, y) ((bool)(x) ? (y) : (x))
+// ||, && and ?? on operands which are not statically typed or with left operand which has to be evaluated once,
+// the compiler lowers the rest to ternaries over js::truthy() and js::is_nullish()
 #define OR(x, y) ([&]() {                      \
-    auto vx = (x);                             \
-    return (static_cast<bool>(vx)) ? vx : static_cast<decltype(vx)>(y); \
+    auto &&vx = (x);                           \
+    return js::truthy(vx) ? vx : static_cast<std::decay_t<decltype(vx)>>(y); \
 })()
 #define AND(x, y) ([&]() {                     \
-    auto vx = (x);                             \
-    return (static_cast<bool>(vx)) ? static_cast<decltype(vx)>(y) : vx; \
+    auto &&vx = (x);                           \
+    return js::truthy(vx) ? static_cast<std::decay_t<decltype(vx)>>(y) : vx; \
+})()
+#define COALESCE(x, y) ([&]() {                \
+    auto &&vx = (x);                           \
+    return js::is_nullish(vx) ? static_cast<std::decay_t<decltype(vx)>>(y) : vx; \
 })()
 
     struct undefined_t;
@@ -66,6 +95,12 @@ namespace js
         struct object;
     }
 
+    namespace json
+    {
+        struct parser;
+        struct stringifier;
+    }
+
     typedef tmpl::pointer_t<void *> pointer_t;
 
 #ifdef UNICODE
@@ -140,976 +175,1745 @@ namespace js
         return lo_value + 0x9e3779b9 + (hi_value << 6) + (hi_value >> 2);
     }
 
-    static std::ostream &operator<<(std::ostream &os, std::nullptr_t ptr)
+#ifdef JS_STATS
+    // runtime statistics (-DJS_STATS), printed to stderr at exit
+    namespace stats
     {
-        return os << "null";
-    }
+        // object/array backing stores allocated on heap
+        inline std::atomic<std::size_t> stores_allocated{0};
+        // shared empty store used instead of allocation
+        inline std::atomic<std::size_t> stores_deferred{0};
+        // shared empty store replaced by allocated one on first write or copy
+        inline std::atomic<std::size_t> stores_materialized{0};
 
-    template <typename I, typename T>
-    inline bool is(T *t)
-    {
-        return dynamic_cast<I *>(t) != nullptr;
-    }
+        struct report_t
+        {
+            ~report_t()
+            {
+                std::cerr << "stores allocated: " << stores_allocated
+                          << ", deferred: " << stores_deferred
+                          << ", materialized: " << stores_materialized
+                          << ", allocations saved: " << (stores_deferred - stores_materialized) << std::endl;
+            }
+        };
 
-    template <typename I, typename T>
-    inline bool is(const std::shared_ptr<T> &t)
-    {
-        return std::dynamic_pointer_cast<I>(t) != nullptr;
-    }
+        inline report_t report;
+    } // namespace stats
 
-    template <typename I, typename T>
-    inline bool __is(T *t)
-    {
-        return std::type_index(typeid(I *)) == std::type_index(typeid(t)) || is<I>(t);
-    }
+#define JS_STAT(name) (++js::stats::name)
+#else
+#define JS_STAT(name)
+#endif
 
-    template <typename I, typename T>
-    inline I as(T t)
-    {
-        return static_cast<I>(t);
-    }
+#ifdef JS_COUNTERS
+    // slow path counters (-DJS_COUNTERS): every thread counts into a block of its own with relaxed loads and stores, no
+    // lock and no read-modify-write. At exit the totals go to stderr as a table sorted by count, or as JSON into
+    // JS_COUNTERS_FILE when it is defined; on POSIX the table is also printed on JS_COUNTERS_SIGNAL (SIGUSR1).
+#if !defined(_WIN32) && !defined(JS_COUNTERS_SIGNAL)
+#define JS_COUNTERS_SIGNAL SIGUSR1
+#endif
 
-    template <typename I, typename T>
-    inline I *as(T *t)
-    {
-        return dynamic_cast<I *>(t);
-    }
+#define JS_COUNTER_LIST(X)                                              \
+    X(any_to_number, "any: conversion to number")                       \
+    X(any_string_to_number, "any: string parsed as number")             \
+    X(any_to_string, "any: conversion to string")                       \
+    X(any_number_to_string, "any: number formatted as string")          \
+    X(any_to_boolean, "any: conversion to boolean")                     \
+    X(any_wrong_type, "any: wrong type thrown")                         \
+    X(array_grow, "array: index past the end grows the array")          \
+    X(array_read_past_end, "array: read past the end")                  \
+    X(object_rehash, "object: property index rebuilt")                  \
+    X(function_invoke, "function: call through function_t, args boxed") \
+    X(shared_alloc, "shared: captured variable boxed")
+
+    namespace counters
+    {
+        enum id : std::size_t
+        {
+#define JS_COUNTER_ID(name, text) name,
+            JS_COUNTER_LIST(JS_COUNTER_ID)
+#undef JS_COUNTER_ID
+            count
+        };
 
-    template <typename I, typename T, class = std::enable_if_t<!std::is_same_v<I, any>>>
-    inline std::shared_ptr<I> as(const std::shared_ptr<T> &t)
-    {
-        return std::dynamic_pointer_cast<I>(t);
-    }
+        inline constexpr const char *names[] = {
+#define JS_COUNTER_NAME(name, text) #name,
+            JS_COUNTER_LIST(JS_COUNTER_NAME)
+#undef JS_COUNTER_NAME
+        };
 
-    template <typename I, typename T, class = std::enable_if_t<std::is_same_v<I, any>>>
-    inline I as(const std::shared_ptr<T> &t)
-    {
-        return I(t);
-    }
+        inline constexpr const char *descriptions[] = {
+#define JS_COUNTER_DESCRIPTION(name, text) text,
+            JS_COUNTER_LIST(JS_COUNTER_DESCRIPTION)
+#undef JS_COUNTER_DESCRIPTION
+        };
 
-    template <class T>
-    static string type_of(T value);
+        struct block
+        {
+            std::atomic<std::uint64_t> values[count];
+            block *next;
+        };
 
-    template <typename T>
-    inline auto isNaN(T t)
-    {
-        return std::isnan(static_cast<double>(t));
-    }
+        // blocks of all threads, only ever prepended to so a signal handler can walk it; blocks of exited threads
+        // stay in it and keep their counts in the totals
+        inline std::atomic<block *> blocks{nullptr};
 
-    template <typename R, typename T>
-    inline R cast(T t)
-    {
-        return static_cast<R>(t);
-    }
+        inline block &local()
+        {
+            thread_local block *mine = [] {
+                auto added = new block{};
+                added->next = blocks.load(std::memory_order_relaxed);
+                while (!blocks.compare_exchange_weak(added->next, added, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
 
-    template <typename T>
-    constexpr const T &const_(T &t)
-    {
-        return static_cast<const T &>(t);
-    }
+                return added;
+            }();
 
-    template <typename T>
-    constexpr const T *const_(T *t)
-    {
-        return static_cast<const T *>(t);
-    }
+            return *mine;
+        }
 
-    /*
-template <typename T> 
-constexpr const T const_(T t) {
-	return static_cast<const T>(t);
-}
-*/
+        inline void add(id counter)
+        {
+            // only the owning thread writes the block
+            auto &value = local().values[counter];
+            value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
 
-    template <typename T>
-    constexpr T &mutable_(const T &t)
-    {
-        return const_cast<T &>(t);
-    }
+        // totals over all threads and the counter ids sorted by them, descending; allocates nothing
+        inline void totals(std::uint64_t (&sums)[count], std::size_t (&order)[count])
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                sums[i] = 0;
+                order[i] = i;
+            }
 
-    template <typename T>
-    constexpr T *mutable_(const T *t)
-    {
-        return const_cast<T *>(t);
-    }
+            for (auto item = blocks.load(std::memory_order_acquire); item != nullptr; item = item->next)
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    sums[i] += item->values[i].load(std::memory_order_relaxed);
+                }
+            }
 
-    template <typename T>
-    constexpr T &deref_(T *t)
-    {
-        return *t;
-    }
+            for (std::size_t i = 1; i < count; i++)
+            {
+                for (auto j = i; j > 0 && sums[order[j]] > sums[order[j - 1]]; j--)
+                {
+                    std::swap(order[j], order[j - 1]);
+                }
+            }
+        }
 
-    template <typename T>
-    constexpr T deref_(T t)
-    {
-        return t;
-    }
+        // the counters which are not zero, formatted in place and written straight to the descriptor, safe in a signal
+        // handler
+        inline void write_table(int fd)
+        {
+            std::uint64_t sums[count];
+            std::size_t order[count];
+            totals(sums, order);
 
-    template <typename T>
-    constexpr auto keys_(const T &t)
-    {
-        return mutable_(t)->keys();
-    }
+            for (auto i : order)
+            {
+                if (sums[i] == 0)
+                {
+                    break;
+                }
 
-    template <typename T>
-    constexpr auto keys_(T &t)
-    {
-        return t->keys();
-    }
+                char line[128];
+                std::size_t length = 0;
+                for (auto c = descriptions[i]; *c != '\0' && length < 80; c++)
+                {
+                    line[length++] = *c;
+                }
 
-    namespace bitwise
-    {
-        template <typename T1, typename T2>
-        constexpr auto rshift(T1 op1, T2 op2)
-        {
-            auto op1ll = static_cast<long long>(op1);
-            auto op1l = static_cast<long>(op1ll);
-            auto op2ll = static_cast<long long>(op2);
-            auto op2ul = static_cast<unsigned long>(op2ll);
-            auto op2ul32 = op2ul & 0x1f;
-            auto r = op1l >> op2ul32;
-            auto rl = static_cast<long>(r);
-            return static_cast<T1>(rl);
+                while (length < 56)
+                {
+                    line[length++] = ' ';
+                }
+
+                char digits[24];
+                std::size_t used = 0;
+                auto value = sums[i];
+                do
+                {
+                    digits[used++] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while (value != 0);
+
+                for (auto pad = used; pad < 20; pad++)
+                {
+                    line[length++] = ' ';
+                }
+
+                while (used > 0)
+                {
+                    line[length++] = digits[--used];
+                }
+
+                line[length++] = '\n';
+#ifdef _WIN32
+                _write(fd, line, static_cast<unsigned int>(length));
+#else
+                [[maybe_unused]] const auto written = ::write(fd, line, length);
+#endif
+            }
         }
 
-        template <typename T1, typename T2>
-        constexpr auto rshift_nosign(T1 op1, T2 op2)
+        inline void write_json(std::ostream &out)
         {
-            auto op1ll = static_cast<long long>(op1);
-            auto op1ul = static_cast<unsigned long>(op1ll);
-            auto op2ll = static_cast<long long>(op2);
-            auto op2ul = static_cast<unsigned long>(op2ll);
-            auto op2ul32 = op2ul & 0x1f;
-            auto r = op1ul >> op2ul32;
-            auto rul = static_cast<unsigned long>(r);
-            return static_cast<T1>(rul);
+            std::uint64_t sums[count];
+            std::size_t order[count];
+            totals(sums, order);
+
+            out << "{";
+            for (std::size_t i = 0; i < count; i++)
+            {
+                out << (i > 0 ? ",\n  \"" : "\n  \"") << names[order[i]] << "\": " << sums[order[i]];
+            }
+
+            out << "\n}\n";
         }
 
-        template <typename T1, typename T2>
-        constexpr auto lshift(T1 op1, T2 op2)
+        struct report_t
         {
-            auto op1ll = static_cast<long long>(op1);
-            auto op1l = static_cast<long>(op1ll);
-            auto op2ll = static_cast<long long>(op2);
-            auto op2ul = static_cast<unsigned long>(op2ll);
-            auto op2ul32 = op2ul & 0x1f;
-            auto r = op1l << op2ul32;
-            auto rl = static_cast<long>(r);
-            return static_cast<T1>(rl);
-        }
+            report_t()
+            {
+#ifdef JS_COUNTERS_SIGNAL
+                std::signal(JS_COUNTERS_SIGNAL, [](int) { write_table(2); });
+#endif
+            }
 
-    } // namespace bitwise
+            ~report_t()
+            {
+#ifdef JS_COUNTERS_FILE
+                std::ofstream file(JS_COUNTERS_FILE);
+                write_json(file);
+#else
+                std::cerr.flush();
+                write_table(2);
+#endif
+            }
+        };
 
-    static struct undefined_t
+        inline report_t report;
+    } // namespace counters
+
+#define JS_COUNT(name) js::counters::add(js::counters::name)
+#else
+#define JS_COUNT(name)
+#endif
+
+#ifdef JS_ARENA
+    struct ref_counted;
+
+    // arena allocation mode (-DJS_ARENA): everything created through new_<T>() (class instances, object/array backing
+    // stores, closure boxes) is bump-allocated from a per-thread arena. References are not counted: objects live until
+    // arena.reset(), which destroys them and reclaims the memory in bulk. When a thread exits its arena is retired,
+    // not freed, as objects made on it may be held by globals or other threads; the next arena.reset() on any thread
+    // reclaims retired arenas too, otherwise they are left to the OS at process exit.
+    struct arena_t
     {
-        constexpr undefined_t()
-        {
-        }
+        static constexpr std::size_t block_size = 1024 * 1024;
 
-        constexpr undefined_t(const undefined_t &)
+        struct block
         {
-        }
+            block *next;
+            std::size_t size;
+            // set in the newest block of a retired arena
+            ref_counted *objects;
+            block *next_retired;
+        };
 
-        constexpr operator bool()
-        {
-            return false;
-        }
+        // arenas of exited threads, a lock-free stack which needs no destructor, threads can exit after globals
+        static inline std::atomic<block *> _retired{nullptr};
 
-        constexpr operator std::nullptr_t()
-        {
-            return nullptr;
-        }
+        block *_blocks = nullptr;
+        char *_current = nullptr;
+        char *_end = nullptr;
+        // objects created on this thread, newest first, linked through ref_counted::_arena_next
+        ref_counted *_objects = nullptr;
 
-        constexpr bool operator==(undefined_t)
+        arena_t() = default;
+        arena_t(const arena_t &) = delete;
+        arena_t &operator=(const arena_t &) = delete;
+
+        ~arena_t()
         {
-            return true;
+            if (_blocks == nullptr)
+            {
+                return;
+            }
+
+            _blocks->objects = _objects;
+            _blocks->next_retired = _retired.load(std::memory_order_relaxed);
+            while (!_retired.compare_exchange_weak(_blocks->next_retired, _blocks, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
         }
 
-        constexpr bool operator!=(undefined_t)
+        inline void *allocate(std::size_t size, std::size_t alignment)
         {
-            return false;
+            auto aligned = reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(_current) + alignment - 1) & ~(alignment - 1));
+            if (_current == nullptr || aligned + size > _end)
+            {
+                grow(size + alignment);
+                aligned = reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(_current) + alignment - 1) & ~(alignment - 1));
+            }
+
+            _current = aligned + size;
+            return aligned;
         }
 
-        constexpr bool operator==(const pointer_t &)
+        // destroys every object made on this thread since the previous reset and on threads which exited meanwhile;
+        // the first block is kept for reuse
+        void reset()
         {
-            return false;
+            destroy(_objects);
+            _objects = nullptr;
+
+            for (auto retired = _retired.exchange(nullptr, std::memory_order_acquire); retired != nullptr;)
+            {
+                auto next = retired->next_retired;
+                destroy(retired->objects);
+                while (retired != nullptr)
+                {
+                    auto older = retired->next;
+                    ::operator delete(retired);
+                    retired = older;
+                }
+
+                retired = next;
+            }
+
+            if (_blocks == nullptr)
+            {
+                return;
+            }
+
+            auto first = _blocks;
+            while (first->next != nullptr)
+            {
+                first = first->next;
+            }
+
+            release(first);
+            _blocks = first;
+            _current = reinterpret_cast<char *>(first + 1);
+            _end = reinterpret_cast<char *>(first) + first->size;
         }
 
-        constexpr bool operator!=(const pointer_t &)
+    private:
+        static void destroy(ref_counted *objects);
+
+        void grow(std::size_t minimum)
         {
-            return true;
+            auto size = std::max(block_size, minimum + sizeof(block));
+            auto new_block = static_cast<block *>(::operator new(size));
+            new_block->next = _blocks;
+            new_block->size = size;
+            _blocks = new_block;
+            _current = reinterpret_cast<char *>(new_block + 1);
+            _end = reinterpret_cast<char *>(new_block) + size;
         }
 
-        constexpr bool operator==(std::nullptr_t)
+        void release(block *keep)
         {
-            return false;
+            while (_blocks != nullptr && _blocks != keep)
+            {
+                auto next = _blocks->next;
+                ::operator delete(_blocks);
+                _blocks = next;
+            }
         }
+    };
 
-        constexpr bool operator!=(std::nullptr_t)
+    inline thread_local arena_t arena;
+#endif
+
+    // intrusive reference counter, kept in the header of every object handed out as ref<T>
+    // (class instances, object/array backing stores, closure boxes); build with -DJS_SINGLE_THREADED to make it non-atomic
+    struct ref_counted
+    {
+#ifdef JS_SINGLE_THREADED
+        using counter_type = std::size_t;
+#else
+        using counter_type = std::atomic<std::size_t>;
+#endif
+
+#ifdef JS_ARENA
+        // copies of ref<T> don't count, arena.reset() destroys the objects new_<T>() linked into the arena's list
+        ref_counted *_arena_next = nullptr;
+
+        ref_counted() noexcept
         {
-            return true;
         }
 
-        friend constexpr bool operator==(const undefined_t, std::nullptr_t)
+        ref_counted(const ref_counted &) noexcept
         {
-            return false;
         }
+#else
+        // starts at 1: the construction reference. new_<T>() adopts it, which makes ref_of(this) safe inside constructors;
+        // objects living on the stack or inside other objects keep it forever and are never deleted through a ref
+        mutable counter_type _ref_count;
 
-        friend constexpr bool operator!=(const undefined_t, std::nullptr_t)
+        ref_counted() noexcept : _ref_count(1)
         {
-            return true;
-        }        
+        }
 
-        template <typename N = void>
-        requires ArithmeticOrEnum<N>
-        bool operator==(N n) const;
+        ref_counted(const ref_counted &) noexcept : _ref_count(1)
+        {
+        }
+#endif
 
-        template <typename N = void>
-        requires ArithmeticOrEnum<N>
-        bool operator!=(N n) const;
+        ref_counted &operator=(const ref_counted &) noexcept
+        {
+            return *this;
+        }
 
-        template <typename N>
-        requires ArithmeticOrEnum<N>
-        friend bool operator==(N n, const undefined_t &u);
+        virtual ~ref_counted()
+        {
+        }
 
-        template <typename N>
-        requires ArithmeticOrEnum<N>
-        friend bool operator!=(N n, const undefined_t &u);
+        inline void add_ref() const noexcept
+        {
+#if defined(JS_ARENA)
+#elif defined(JS_SINGLE_THREADED)
+            ++_ref_count;
+#else
+            _ref_count.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
 
-        friend std::ostream &operator<<(std::ostream &os, undefined_t)
+        inline void release_ref() const noexcept
         {
-            return os << "undefined";
+#if defined(JS_ARENA)
+#elif defined(JS_SINGLE_THREADED)
+            if (--_ref_count == 0)
+            {
+                delete this;
+            }
+#else
+            if (_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                delete this;
+            }
+#endif
         }
-    } undefined;
+    };
 
-    struct void_t
+#ifdef JS_ARENA
+    inline void arena_t::destroy(ref_counted *objects)
     {
-        constexpr operator bool()
+        while (objects != nullptr)
         {
-            return false;
+            auto next = objects->_arena_next;
+            objects->~ref_counted();
+            objects = next;
         }
+    }
+#endif
 
-        constexpr bool operator==(void_t)
+    template <typename T>
+    struct ref
+    {
+        using element_type = T;
+
+        struct adopt_t
         {
-            return true;
-        }
+        };
 
-        constexpr bool operator!=(void_t)
+        T *_ptr;
+
+        constexpr ref() noexcept : _ptr(nullptr)
         {
-            return false;
         }
 
-        constexpr bool operator==(undefined_t)
+        constexpr ref(std::nullptr_t) noexcept : _ptr(nullptr)
         {
-            return true;
         }
 
-        constexpr bool operator!=(undefined_t)
+        ref(const undefined_t &) noexcept : _ptr(nullptr)
         {
-            return false;
         }
 
-        template <typename T>
-        constexpr bool operator==(T)
+        explicit ref(T *ptr) noexcept : _ptr(ptr)
         {
-            return false;
+            if (_ptr)
+            {
+                _ptr->add_ref();
+            }
         }
 
-        template <typename T>
-        constexpr bool operator!=(T)
+        // takes over the construction reference of a freshly created object
+        ref(T *ptr, adopt_t) noexcept : _ptr(ptr)
         {
-            return true;
         }
-    };
 
-    namespace tmpl
-    {
-        template <typename T>
-        struct pointer_t
+        ref(const ref &other) noexcept : ref(other._ptr)
         {
-            bool isUndefined;
-            T _ptr;
-
-            pointer_t() : _ptr(nullptr), isUndefined(false){};
-
-            pointer_t(const pointer_t &other) : _ptr(other._ptr), isUndefined(other.isUndefined){};
+        }
 
-            pointer_t(void *ptr) : _ptr(static_cast<T>(ptr)), isUndefined(false){};
+        ref(ref &&other) noexcept : _ptr(other._ptr)
+        {
+            other._ptr = nullptr;
+        }
 
-            pointer_t(std::nullptr_t) : _ptr(nullptr), isUndefined(false){};
+        template <typename U>
+        requires std::is_convertible_v<U *, T *>
+        ref(const ref<U> &other) noexcept : ref(static_cast<T *>(other._ptr))
+        {
+        }
 
-            pointer_t(js::number);
+        template <typename U>
+        requires std::is_convertible_v<U *, T *>
+        ref(ref<U> &&other) noexcept : _ptr(other._ptr)
+        {
+            other._ptr = nullptr;
+        }
 
-            pointer_t(const undefined_t &undef) : _ptr(nullptr), isUndefined(true)
+        ~ref()
+        {
+            if (_ptr)
             {
+                _ptr->release_ref();
             }
+        }
 
-            constexpr operator bool()
-            {
-                return !isUndefined && _ptr != nullptr;
-            }
+        ref &operator=(const ref &other) noexcept
+        {
+            ref(other).swap(*this);
+            return *this;
+        }
 
-            constexpr operator void *()
-            {
-                return static_cast<void *>(_ptr);
-            }
+        ref &operator=(ref &&other) noexcept
+        {
+            ref(std::move(other)).swap(*this);
+            return *this;
+        }
 
-            template <typename T1>
-            constexpr operator std::shared_ptr<T1>()
-            {
-                return std::shared_ptr<T1>(static_cast<T1 *>(_ptr));
-            }
+        ref &operator=(std::nullptr_t) noexcept
+        {
+            ref().swap(*this);
+            return *this;
+        }
 
-            template <typename T1>
-            constexpr operator const T1 *()
-            {
-                return isUndefined ? static_cast<const T1 *>(nullptr) : static_cast<const T1 *>(_ptr);
-            }
+        void swap(ref &other) noexcept
+        {
+            std::swap(_ptr, other._ptr);
+        }
 
-            template <typename T1 = void>
-            requires ArithmeticOrEnum<T1>
-            constexpr operator T1()
-            {
-                return static_cast<T1>(reinterpret_cast<intptr_t>(_ptr));
-            }
+        constexpr T *get() const noexcept
+        {
+            return _ptr;
+        }
 
-            operator tstring() const
-            {
-                tostringstream streamObj2;
-                streamObj2 << TXT("null");
-                return streamObj2.str();
-            }
+        constexpr T *operator->() const noexcept
+        {
+            return _ptr;
+        }
 
-            operator tstring()
-            {
-                tostringstream streamObj2;
-                streamObj2 << TXT("null");
-                return streamObj2.str();
-            }
+        constexpr T &operator*() const noexcept
+        {
+            return *_ptr;
+        }
 
-            bool operator==(undefined_t)
-            {
-                return isUndefined;
-            }
+        constexpr explicit operator bool() const noexcept
+        {
+            return _ptr != nullptr;
+        }
 
-            bool operator!=(undefined_t)
-            {
-                return !isUndefined;
-            }
+        template <typename U>
+        constexpr bool operator==(const ref<U> &other) const noexcept
+        {
+            return _ptr == other._ptr;
+        }
 
-            bool operator==(pointer_t p)
-            {
-                return isUndefined == p.isUndefined && _ptr == p._ptr;
-            }
+        template <typename U>
+        constexpr bool operator!=(const ref<U> &other) const noexcept
+        {
+            return _ptr != other._ptr;
+        }
 
-            bool operator!=(pointer_t p)
-            {
-                return isUndefined != p.isUndefined || _ptr != p._ptr;
-            }
+        constexpr bool operator==(std::nullptr_t) const noexcept
+        {
+            return _ptr == nullptr;
+        }
 
-            template <typename N = void>
-            requires ArithmeticOrEnumOrNumber<N>
-            bool operator==(N n);
+        constexpr bool operator!=(std::nullptr_t) const noexcept
+        {
+            return _ptr != nullptr;
+        }
 
-            template <typename N = void>
-            requires ArithmeticOrEnumOrNumber<N>
-            bool operator!=(N n);
+        template <typename Tv = T>
+        auto begin() const -> decltype(std::declval<Tv &>().begin())
+        {
+            return _ptr->begin();
+        }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend bool operator==(N n, const pointer_t p)
-            {
-                return !p.isUndefined && false;
-            }
+        template <typename Tv = T>
+        auto end() const -> decltype(std::declval<Tv &>().end())
+        {
+            return _ptr->end();
+        }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend bool operator!=(N n, const pointer_t p)
+        friend std::ostream &operator<<(std::ostream &os, const ref &val)
+        {
+            if (!val._ptr)
             {
-                return p.isUndefined || true;
+                return os << "null";
             }
 
-            template <typename _Ty>
-            bool operator==(std::shared_ptr<_Ty> sp)
+            if constexpr (requires { val._ptr->toString(); })
             {
-                return false;
+                return os << val._ptr->toString();
             }
-
-            template <typename _Ty>
-            bool operator!=(std::shared_ptr<_Ty> sp)
+            else
             {
-                return false;
+                return os << static_cast<const void *>(val._ptr);
             }
+        }
+    };
 
-            friend std::ostream &operator<<(std::ostream &os, pointer_t val)
-            {
-                if (!val.isUndefined && val._ptr == nullptr)
-                {
-                    return os << "null";
-                }
-
-                return os << val._ptr;
-            }
-        };
+    template <typename T>
+    struct ref_hash
+    {
+        std::size_t operator()(const ref<T> &value) const noexcept
+        {
+            return std::hash<T *>()(value.get());
+        }
+    };
 
+    // free this -> ref conversion (replaces std::enable_shared_from_this::shared_from_this())
+    template <typename T>
+    inline ref<std::remove_const_t<T>> ref_of(T *t)
+    {
+        return ref<std::remove_const_t<T>>(const_cast<std::remove_const_t<T> *>(t));
     }
 
-    static pointer_t null;
+    // ref-counted holder for values that are not objects themselves (array/object backing stores, closure boxes)
+    template <typename T>
+    struct ref_box : public ref_counted
+    {
+        T value;
 
-    constexpr bool equals(std::nullptr_t, std::nullptr_t)
+        template <class... Args>
+        ref_box(Args &&...args) : value(std::forward<Args>(args)...)
+        {
+        }
+    };
+
+    // compiled classes are numbered, __class_display holds the depth of the class in its inheritance tree, the tag of
+    // the program which numbered it and the ids of its bases from the root down to the class itself. An object points
+    // at the display of its class, so instanceof and narrowing casts check one entry: display[I::__class_depth + 1] ==
+    // I::__class_id. Ids are unique only within one program, classes numbered by another one (a library compiled on its
+    // own) have another tag and are checked by dynamic_cast
+    template <typename T>
+    concept class_with_id = requires {
+        T::__class_id;
+        T::__class_depth;
+        T::__class_display;
+        typename T::__class_self;
+    } && std::is_same_v<typename T::__class_self, T>;
+
+    // instances of classes without own id (generic ones) get the display of the nearest numbered base
+    template <typename T>
+    inline void set_class_id(T *t)
     {
-        return true;
+        if constexpr (requires { t->_class_display = T::__class_display; })
+        {
+            t->_class_display = T::__class_display;
+        }
     }
 
-    constexpr bool not_equals(std::nullptr_t, std::nullptr_t)
+    template <typename I, typename T>
+    inline I *class_cast(T *t)
     {
-        return false;
+        if constexpr (class_with_id<I> && requires(T *p) {
+                          p->_class_display;
+                          static_cast<I *>(p);
+                      })
+        {
+            // nullptr - created without new_(), e.g. copied
+            if (t && t->_class_display && t->_class_display[1] == I::__class_display[1])
+            {
+                auto display = t->_class_display;
+                return display[0] >= I::__class_depth && display[I::__class_depth + 1] == I::__class_id ? static_cast<I *>(t)
+                                                                                                       : nullptr;
+            }
+        }
+
+        return dynamic_cast<I *>(t);
     }
 
-    constexpr bool equals(undefined_t, undefined_t)
+    // single allocation point for heap objects: class instances (new), object/array backing stores and closure boxes
+    template <typename T, typename... Args>
+    inline ref<T> new_(Args &&...args)
     {
-        return true;
+#ifdef JS_ARENA
+        auto ptr = new (arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        ptr->_arena_next = arena._objects;
+        arena._objects = ptr;
+#else
+        auto ptr = new T(std::forward<Args>(args)...);
+#endif
+        set_class_id(ptr);
+        return ref<T>(ptr, typename ref<T>::adopt_t());
     }
 
-    constexpr bool not_equals(undefined_t, undefined_t)
+    // object literal of known interface shape: the interface struct is allocated once and its fields are set in place.
+    // The fields come in a braced list, new_with<T>(std::tuple{field(...), ...}), so their initializers are evaluated
+    // left to right as in JS; as function arguments their order would be unspecified
+    template <typename C, typename M, typename V>
+    inline auto field(M C::*member, V &&value)
     {
-        return false;
+        return [member, &value](C &obj) { obj.*member = std::forward<V>(value); };
     }
 
-    constexpr bool equals(std::nullptr_t, undefined_t)
+    template <typename T, typename... Fields>
+    inline ref<T> new_with(std::tuple<Fields...> &&fields)
     {
-        return true;
+        auto obj = new_<T>();
+        std::apply([&](auto &...field) { (field(*obj), ...); }, fields);
+        return obj;
     }
 
-    constexpr bool not_equals(std::nullptr_t, undefined_t)
+    static std::ostream &operator<<(std::ostream &os, std::nullptr_t ptr)
     {
-        return false;
-    }    
+        return os << "null";
+    }
 
-    constexpr bool equals(undefined_t, std::nullptr_t)
+    template <typename I, typename T>
+    inline bool is(T *t)
     {
-        return true;
+        return class_cast<I>(t) != nullptr;
     }
 
-    constexpr bool not_equals(undefined_t, std::nullptr_t)
+    template <typename I, typename T>
+    inline bool is(const std::shared_ptr<T> &t)
     {
-        return false;
-    }    
+        return std::dynamic_pointer_cast<I>(t) != nullptr;
+    }
 
-    template <typename L, typename R = void>
-    requires ArithmeticOrEnum<R>
-    constexpr bool equals(const L& l, R r)
+    template <typename I, typename T>
+    inline bool is(const ref<T> &t)
     {
-        auto lIsUndef = l == undefined;
-        auto lIsNull = l == nullptr;
-        return !lIsUndef && !lIsNull && l == r;
+        return class_cast<I>(t.get()) != nullptr;
     }
 
-    template <typename L = void, typename R>
-    requires ArithmeticOrEnum<L>
-    constexpr bool equals(L l, const R& r)
+    template <typename I, typename T>
+    inline bool __is(T *t)
     {
-        auto rIsUndef = r == undefined;
-        auto rIsNull = r == nullptr;
-        return !rIsUndef && !rIsNull && r == l;
+        return std::type_index(typeid(I *)) == std::type_index(typeid(t)) || is<I>(t);
     }
 
-    template <typename L = void, typename R = void>
-    requires (ArithmeticOrEnum<L> && ArithmeticOrEnum<R>)
-    constexpr bool equals(L l, R r)
+    template <typename I, typename T>
+    inline I as(T t)
     {
-        return l == r;
-    }    
+        return static_cast<I>(t);
+    }
 
-    template <typename L, typename R>
-    constexpr bool equals(const L& l, const R& r)
+    template <typename I, typename T>
+    inline I *as(T *t)
     {
-        auto lIsUndef = l == undefined;
-        auto lIsNull = l == nullptr;
-        auto rIsUndef = r == undefined;
-        auto rIsNull = r == nullptr;
-        return ((lIsUndef || lIsNull) && (rIsUndef || rIsNull)) || l == r;
+        return class_cast<I>(t);
     }
 
-    template <typename L, typename R = void>
-    requires ArithmeticOrEnum<R>
-    constexpr bool not_equals(const L& l, R r)
+    template <typename I, typename T, class = std::enable_if_t<!std::is_same_v<I, any>>>
+    inline std::shared_ptr<I> as(const std::shared_ptr<T> &t)
     {
-        return !equals(l, r);
+        return std::dynamic_pointer_cast<I>(t);
     }
 
-    template <typename L = void, typename R>
-    requires ArithmeticOrEnum<L>
-    constexpr bool not_equals(L l, const R& r)
+    template <typename I, typename T, class = std::enable_if_t<std::is_same_v<I, any>>>
+    inline I as(const std::shared_ptr<T> &t)
     {
-        return !equals(l, r);
+        return I(t);
     }
 
-    template <typename L = void, typename R = void>
-    requires (ArithmeticOrEnum<L> && ArithmeticOrEnum<R>)
-    constexpr bool not_equals(L l, R r)
+    template <typename I, typename T, class = std::enable_if_t<!std::is_same_v<I, any>>>
+    inline ref<I> as(const ref<T> &t)
     {
-        return l != r;
-    } 
+        return ref<I>(class_cast<I>(t.get()));
+    }
 
-    template <typename L, typename R>
-    constexpr bool not_equals(const L& l, const R& r)
+    template <typename I, typename T, class = std::enable_if_t<std::is_same_v<I, any>>>
+    inline I as(const ref<T> &t)
     {
-        return !equals(l, r);
+        return I(t);
     }
 
-    struct boolean
+    template <class T>
+    static string type_of(T value);
+
+    template <typename T>
+    inline auto isNaN(T t)
     {
-        enum control_t
-        {
-            boolean_false = 0,
-            boolean_true = 1,
-            boolean_undefined = 2
-        } _control;
+        return std::isnan(static_cast<double>(t));
+    }
 
-        constexpr boolean() : _control(boolean_undefined)
+    template <typename R, typename T>
+    inline R cast(T t)
+    {
+        return static_cast<R>(t);
+    }
+
+    template <typename T>
+    constexpr const T &const_(T &t)
+    {
+        return static_cast<const T &>(t);
+    }
+
+    template <typename T>
+    constexpr const T *const_(T *t)
+    {
+        return static_cast<const T *>(t);
+    }
+
+    /*
+template <typename T> 
+constexpr const T const_(T t) {
+	return static_cast<const T>(t);
+}
+*/
+
+    template <typename T>
+    constexpr T &mutable_(const T &t)
+    {
+        return const_cast<T &>(t);
+    }
+
+    template <typename T>
+    constexpr T *mutable_(const T *t)
+    {
+        return const_cast<T *>(t);
+    }
+
+    template <typename T>
+    constexpr T &deref_(T *t)
+    {
+        return *t;
+    }
+
+    template <typename T>
+    constexpr T deref_(T t)
+    {
+        return t;
+    }
+
+    template <typename T>
+    constexpr auto keys_(const T &t)
+    {
+        return mutable_(t)->keys();
+    }
+
+    template <typename T>
+    constexpr auto keys_(T &t)
+    {
+        return t->keys();
+    }
+
+    namespace bitwise
+    {
+        template <typename T1, typename T2>
+        constexpr auto rshift(T1 op1, T2 op2)
         {
+            auto op1ll = static_cast<long long>(op1);
+            auto op1l = static_cast<long>(op1ll);
+            auto op2ll = static_cast<long long>(op2);
+            auto op2ul = static_cast<unsigned long>(op2ll);
+            auto op2ul32 = op2ul & 0x1f;
+            auto r = op1l >> op2ul32;
+            auto rl = static_cast<long>(r);
+            return static_cast<T1>(rl);
         }
 
-        inline boolean(const boolean &value) : _control(value._control)
+        template <typename T1, typename T2>
+        constexpr auto rshift_nosign(T1 op1, T2 op2)
         {
+            auto op1ll = static_cast<long long>(op1);
+            auto op1ul = static_cast<unsigned long>(op1ll);
+            auto op2ll = static_cast<long long>(op2);
+            auto op2ul = static_cast<unsigned long>(op2ll);
+            auto op2ul32 = op2ul & 0x1f;
+            auto r = op1ul >> op2ul32;
+            auto rul = static_cast<unsigned long>(r);
+            return static_cast<T1>(rul);
         }
 
-        inline boolean(bool value) : _control(static_cast<control_t>(value))
+        template <typename T1, typename T2>
+        constexpr auto lshift(T1 op1, T2 op2)
         {
+            auto op1ll = static_cast<long long>(op1);
+            auto op1l = static_cast<long>(op1ll);
+            auto op2ll = static_cast<long long>(op2);
+            auto op2ul = static_cast<unsigned long>(op2ll);
+            auto op2ul32 = op2ul & 0x1f;
+            auto r = op1l << op2ul32;
+            auto rl = static_cast<long>(r);
+            return static_cast<T1>(rl);
         }
 
-        constexpr boolean(const undefined_t &) : _control(boolean_undefined)
+    } // namespace bitwise
+
+    static struct undefined_t
+    {
+        constexpr undefined_t()
         {
         }
 
-        constexpr operator bool() const
+        constexpr undefined_t(const undefined_t &)
         {
-            return _control == boolean_true;
         }
 
         constexpr operator bool()
         {
-            return _control == boolean_true;
+            return false;
         }
 
-        constexpr boolean *operator->()
+        constexpr operator std::nullptr_t()
         {
-            return this;
+            return nullptr;
         }
 
-        inline bool operator==(undefined_t) const
+        constexpr bool operator==(undefined_t)
         {
-            return _control == boolean_undefined;
+            return true;
         }
 
-        inline bool operator!=(undefined_t) const
+        constexpr bool operator!=(undefined_t)
         {
-            return _control != boolean_undefined;
+            return false;
         }
 
-        inline bool operator==(pointer_t) const
+        constexpr bool operator==(const pointer_t &)
         {
             return false;
         }
 
-        inline bool operator!=(pointer_t) const
+        constexpr bool operator!=(const pointer_t &)
         {
             return true;
         }
 
-        inline bool operator==(std::nullptr_t) const
+        constexpr bool operator==(std::nullptr_t)
         {
             return false;
         }
 
-        inline bool operator!=(std::nullptr_t) const
+        constexpr bool operator!=(std::nullptr_t)
         {
             return true;
         }
 
-        inline bool operator==(const undefined_t&)
+        friend constexpr bool operator==(const undefined_t, std::nullptr_t)
         {
-            return _control == boolean_undefined;
+            return false;
         }
 
-        inline bool operator!=(const undefined_t&)
+        friend constexpr bool operator!=(const undefined_t, std::nullptr_t)
         {
-            return _control != boolean_undefined;
+            return true;
+        }        
+
+        template <typename N = void>
+        requires ArithmeticOrEnum<N>
+        bool operator==(N n) const;
+
+        template <typename N = void>
+        requires ArithmeticOrEnum<N>
+        bool operator!=(N n) const;
+
+        template <typename N>
+        requires ArithmeticOrEnum<N>
+        friend bool operator==(N n, const undefined_t &u);
+
+        template <typename N>
+        requires ArithmeticOrEnum<N>
+        friend bool operator!=(N n, const undefined_t &u);
+
+        friend std::ostream &operator<<(std::ostream &os, undefined_t)
+        {
+            return os << "undefined";
         }
+    } undefined;
 
-        inline bool operator==(pointer_t)
+    struct void_t
+    {
+        constexpr operator bool()
         {
             return false;
         }
 
-        inline bool operator!=(pointer_t)
+        constexpr bool operator==(void_t)
         {
             return true;
         }
 
-        inline bool operator==(std::nullptr_t)
+        constexpr bool operator!=(void_t)
         {
             return false;
         }
 
-        inline bool operator!=(std::nullptr_t)
+        constexpr bool operator==(undefined_t)
         {
             return true;
         }
 
-        inline bool operator==(boolean other)
+        constexpr bool operator!=(undefined_t)
         {
-            return this->operator bool() == static_cast<bool>(other);
+            return false;
         }
 
-        inline bool operator!=(boolean other)
+        template <typename T>
+        constexpr bool operator==(T)
         {
-            return this->operator bool() != static_cast<bool>(other);
+            return false;
         }
 
-        inline bool operator==(bool other)
+        template <typename T>
+        constexpr bool operator!=(T)
         {
-            return this->operator bool() == other;
+            return true;
         }
+    };
 
-        inline bool operator!=(bool other)
+    namespace tmpl
+    {
+        template <typename T>
+        struct pointer_t
         {
-            return this->operator bool() != other;
-        }
+            bool isUndefined;
+            T _ptr;
 
-        boolean operator~()
-        {
-            return this->operator bool() ? false : true;
-        }
+            pointer_t() : _ptr(nullptr), isUndefined(false){};
 
-        friend std::ostream &operator<<(std::ostream &os, boolean val)
-        {
-            if (val._control == boolean_undefined)
-            {
-                return os << "undefined";
-            }
-
-            return os << (static_cast<bool>(val) ? "true" : "false");
-        }
-    };
-
-    static struct boolean true_t(true);
-    static struct boolean false_t(false);
-
-    namespace tmpl
-    {
-        template <typename V>
-        struct number
-        {
-            using number_t = number<V>;
-            V _value;
-
-            number() : _value{-std::numeric_limits<V>::quiet_NaN()}
-            {
-            }
+            pointer_t(const pointer_t &other) : _ptr(other._ptr), isUndefined(other.isUndefined){};
 
-            number(const number &value) : _value{value._value}
-            {
-            }
+            pointer_t(void *ptr) : _ptr(static_cast<T>(ptr)), isUndefined(false){};
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            number(T initValue) : _value{static_cast<V>(initValue)}
-            {
-            }
+            pointer_t(std::nullptr_t) : _ptr(nullptr), isUndefined(false){};
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            number(const shared<T> &initValue) : _value{static_cast<V>(initValue.get())}
-            {
-            }
+            pointer_t(js::number);
 
-            number(js::pointer_t p) : _value{p._ptr != nullptr ? static_cast<V>(intptr_t(p._ptr)) : -std::numeric_limits<V>::quiet_NaN()}
+            pointer_t(const undefined_t &undef) : _ptr(nullptr), isUndefined(true)
             {
             }
 
-            number(const undefined_t &undef) : _value{-std::numeric_limits<V>::quiet_NaN()}
+            constexpr operator bool()
             {
+                return !isUndefined && _ptr != nullptr;
             }
 
-            inline bool is_undefined()
+            constexpr operator void *()
             {
-                return std::signbit(_value) && std::isnan(_value);
+                return static_cast<void *>(_ptr);
             }
 
-            constexpr operator size_t()
+            template <typename T1>
+            constexpr operator std::shared_ptr<T1>()
             {
-                return static_cast<size_t>(_value);
+                return std::shared_ptr<T1>(static_cast<T1 *>(_ptr));
             }
 
-            constexpr operator bool()
+            template <typename T1>
+            constexpr operator ref<T1>()
             {
-                return std::isnormal(_value);
+                return ref<T1>(static_cast<T1 *>(_ptr));
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            constexpr operator T()
+            template <typename T1>
+            constexpr operator const T1 *()
             {
-                return static_cast<T>(_value);
+                return isUndefined ? static_cast<const T1 *>(nullptr) : static_cast<const T1 *>(_ptr);
             }
 
-            constexpr number_t *operator->()
+            template <typename T1 = void>
+            requires ArithmeticOrEnum<T1>
+            constexpr operator T1()
             {
-                return this;
+                return static_cast<T1>(reinterpret_cast<intptr_t>(_ptr));
             }
 
             operator tstring() const
             {
                 tostringstream streamObj2;
-                streamObj2 << _value;
+                streamObj2 << TXT("null");
                 return streamObj2.str();
             }
 
             operator tstring()
             {
                 tostringstream streamObj2;
-                streamObj2 << _value;
+                streamObj2 << TXT("null");
                 return streamObj2.str();
             }
 
-            operator js::string();
-
-            inline bool operator==(undefined_t)
-            {
-                return is_undefined();
-            }
-
-            inline bool operator!=(undefined_t)
+            bool operator==(undefined_t)
             {
-                return !is_undefined();
+                return isUndefined;
             }
 
-            inline friend bool operator==(const undefined_t, number_t other)
+            bool operator!=(undefined_t)
             {
-                return other.is_undefined();
+                return !isUndefined;
             }
 
-            inline friend bool operator!=(const undefined_t, number_t other)
+            bool operator==(pointer_t p)
             {
-                return !other.is_undefined();
+                return isUndefined == p.isUndefined && _ptr == p._ptr;
             }
 
-            inline friend bool operator==(const number_t n, js::pointer_t p)
+            bool operator!=(pointer_t p)
             {
-                return mutable_(n).is_undefined() == p.isUndefined && false;
+                return isUndefined != p.isUndefined || _ptr != p._ptr;
             }
 
-            inline friend bool operator!=(const number_t n, js::pointer_t p)
-            {
-                return mutable_(n).is_undefined() != p.isUndefined || true;
-            }
+            template <typename N = void>
+            requires ArithmeticOrEnumOrNumber<N>
+            bool operator==(N n);
 
-            inline friend bool operator==(const number_t n, std::nullptr_t)
-            {
-                return mutable_(n).is_undefined();
-            }
+            template <typename N = void>
+            requires ArithmeticOrEnumOrNumber<N>
+            bool operator!=(N n);
 
-            inline friend bool operator!=(const number_t n, std::nullptr_t)
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend bool operator==(N n, const pointer_t p)
             {
-                return !mutable_(n).is_undefined();
+                return !p.isUndefined && false;
             }
 
-            number_t operator+()
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend bool operator!=(N n, const pointer_t p)
             {
-                return +_value;
+                return p.isUndefined || true;
             }
 
-            number_t &operator++()
+            template <typename _Ty>
+            bool operator==(std::shared_ptr<_Ty> sp)
             {
-                _value += 1;
-                return *this;
+                return false;
             }
 
-            number_t operator++(int)
+            template <typename _Ty>
+            bool operator!=(std::shared_ptr<_Ty> sp)
             {
-                number_t tmp(*this);
-                operator++();
-                return tmp;
+                return false;
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator+(const number_t n, T value)
+            template <typename _Ty>
+            bool operator==(const ref<_Ty> &r)
             {
-                return n._value + static_cast<V>(value);
+                return !isUndefined && _ptr == static_cast<void *>(r.get());
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            friend T operator+(T value, const number_t n)
+            template <typename _Ty>
+            bool operator!=(const ref<_Ty> &r)
             {
-                return value + static_cast<T>(n._value);
+                return isUndefined || _ptr != static_cast<void *>(r.get());
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator+=(T value)
+            friend std::ostream &operator<<(std::ostream &os, pointer_t val)
             {
-                _value += static_cast<V>(value);
-                return *this;
-            }
+                if (!val.isUndefined && val._ptr == nullptr)
+                {
+                    return os << "null";
+                }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend N operator+=(N &n, const number &other)
-            {
-                return n += static_cast<N>(mutable_(other));
+                return os << val._ptr;
             }
+        };
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator-(const number_t n, T value)
-            {
-                return n._value - static_cast<V>(value);
-            }
+    }
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            friend T operator-(T value, const number_t n)
-            {
-                return value - static_cast<T>(n._value);
-            }
+    static pointer_t null;
 
-            number_t operator-()
-            {
-                return -_value;
-            }
+    // JS truthiness by static type of the value, reads it in place
+    template <typename T>
+    constexpr bool truthy(const T &value)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return value == value && value != 0;
+        }
+        else
+        {
+            return static_cast<bool>(mutable_(value));
+        }
+    }
 
-            number_t &operator--()
-            {
-                _value -= 1;
-                return *this;
-            }
+    // undefined or null, left operand of ??
+    template <typename T>
+    constexpr bool is_nullish(const T &value)
+    {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>)
+        {
+            return false;
+        }
+        else if constexpr (std::is_same_v<T, undefined_t> || std::is_same_v<T, std::nullptr_t>)
+        {
+            return true;
+        }
+        else if constexpr (requires { mutable_(value).is_null(); })
+        {
+            return mutable_(value).is_undefined() || mutable_(value).is_null();
+        }
+        else if constexpr (requires { mutable_(value).is_undefined(); })
+        {
+            return mutable_(value).is_undefined();
+        }
+        else if constexpr (std::is_same_v<T, pointer_t>)
+        {
+            return !mutable_(value);
+        }
+        else if constexpr (requires { value.get() == nullptr; })
+        {
+            return value.get() == nullptr;
+        }
+        else
+        {
+            return mutable_(value) == undefined;
+        }
+    }
 
-            number_t operator--(int)
-            {
-                number_t tmp(*this);
-                operator--();
-                return tmp;
-            }
+    constexpr bool equals(std::nullptr_t, std::nullptr_t)
+    {
+        return true;
+    }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator-=(T value)
-            {
-                _value -= static_cast<V>(value);
-                return *this;
-            }
+    constexpr bool not_equals(std::nullptr_t, std::nullptr_t)
+    {
+        return false;
+    }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend N operator-=(N &n, const number &other)
-            {
-                return n -= static_cast<N>(mutable_(other));
-            }
+    constexpr bool equals(undefined_t, undefined_t)
+    {
+        return true;
+    }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator*(const number_t n, T value)
-            {
-                return n._value * static_cast<V>(value);
-            }
+    constexpr bool not_equals(undefined_t, undefined_t)
+    {
+        return false;
+    }
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            friend T operator*(T value, const number_t n)
-            {
-                return value * static_cast<T>(n._value);
-            }
+    constexpr bool equals(std::nullptr_t, undefined_t)
+    {
+        return true;
+    }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator*=(T value)
+    constexpr bool not_equals(std::nullptr_t, undefined_t)
+    {
+        return false;
+    }    
+
+    constexpr bool equals(undefined_t, std::nullptr_t)
+    {
+        return true;
+    }
+
+    constexpr bool not_equals(undefined_t, std::nullptr_t)
+    {
+        return false;
+    }    
+
+    // abstract equality (==): pairs of static types are resolved at compile time,
+    // any x any is dispatched once on both runtime types by any::loose_equals()
+    template <typename L, typename R>
+    constexpr bool equals(const L &l, const R &r)
+    {
+        if constexpr (ArithmeticOrEnum<L> && ArithmeticOrEnum<R>)
+        {
+            return l == r;
+        }
+        else if constexpr (std::is_same_v<L, any> && std::is_same_v<R, any>)
+        {
+            return l.loose_equals(r);
+        }
+        else if constexpr (std::is_same_v<L, any> && (ArithmeticOrEnumOrNumber<R> || BoolOrBoolean<R> || std::is_same_v<R, string>))
+        {
+            return l.loose_equals(any(r));
+        }
+        else if constexpr (std::is_same_v<R, any> && (ArithmeticOrEnumOrNumber<L> || BoolOrBoolean<L> || std::is_same_v<L, string>))
+        {
+            return r.loose_equals(any(l));
+        }
+        else if constexpr (ArithmeticOrEnum<R>)
+        {
+            return !is_nullish(l) && l == r;
+        }
+        else if constexpr (ArithmeticOrEnum<L>)
+        {
+            return !is_nullish(r) && r == l;
+        }
+        else
+        {
+            const auto lIsNullish = is_nullish(l);
+            const auto rIsNullish = is_nullish(r);
+            return lIsNullish || rIsNullish ? lIsNullish && rIsNullish : l == r;
+        }
+    }
+
+    template <typename L, typename R>
+    constexpr bool not_equals(const L &l, const R &r)
+    {
+        return !equals(l, r);
+    }
+
+    struct boolean
+    {
+        enum control_t
+        {
+            boolean_false = 0,
+            boolean_true = 1,
+            boolean_undefined = 2
+        } _control;
+
+        constexpr boolean() : _control(boolean_undefined)
+        {
+        }
+
+        inline boolean(const boolean &value) : _control(value._control)
+        {
+        }
+
+        inline boolean(bool value) : _control(static_cast<control_t>(value))
+        {
+        }
+
+        constexpr boolean(const undefined_t &) : _control(boolean_undefined)
+        {
+        }
+
+        constexpr operator bool() const
+        {
+            return _control == boolean_true;
+        }
+
+        constexpr operator bool()
+        {
+            return _control == boolean_true;
+        }
+
+        constexpr boolean *operator->()
+        {
+            return this;
+        }
+
+        inline bool operator==(undefined_t) const
+        {
+            return _control == boolean_undefined;
+        }
+
+        inline bool operator!=(undefined_t) const
+        {
+            return _control != boolean_undefined;
+        }
+
+        inline bool operator==(pointer_t) const
+        {
+            return false;
+        }
+
+        inline bool operator!=(pointer_t) const
+        {
+            return true;
+        }
+
+        inline bool operator==(std::nullptr_t) const
+        {
+            return false;
+        }
+
+        inline bool operator!=(std::nullptr_t) const
+        {
+            return true;
+        }
+
+        inline bool operator==(const undefined_t&)
+        {
+            return _control == boolean_undefined;
+        }
+
+        inline bool operator!=(const undefined_t&)
+        {
+            return _control != boolean_undefined;
+        }
+
+        inline bool operator==(pointer_t)
+        {
+            return false;
+        }
+
+        inline bool operator!=(pointer_t)
+        {
+            return true;
+        }
+
+        inline bool operator==(std::nullptr_t)
+        {
+            return false;
+        }
+
+        inline bool operator!=(std::nullptr_t)
+        {
+            return true;
+        }
+
+        inline bool operator==(boolean other)
+        {
+            return this->operator bool() == static_cast<bool>(other);
+        }
+
+        inline bool operator!=(boolean other)
+        {
+            return this->operator bool() != static_cast<bool>(other);
+        }
+
+        inline bool operator==(bool other)
+        {
+            return this->operator bool() == other;
+        }
+
+        inline bool operator!=(bool other)
+        {
+            return this->operator bool() != other;
+        }
+
+        boolean operator~()
+        {
+            return this->operator bool() ? false : true;
+        }
+
+        friend std::ostream &operator<<(std::ostream &os, boolean val)
+        {
+            if (val._control == boolean_undefined)
             {
-                _value *= static_cast<V>(value);
-                return *this;
+                return os << "undefined";
             }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend N operator*=(N &n, const number &other)
+            return os << (static_cast<bool>(val) ? "true" : "false");
+        }
+    };
+
+    static struct boolean true_t(true);
+    static struct boolean false_t(false);
+
+    namespace tmpl
+    {
+        template <typename V>
+        struct number
+        {
+            using number_t = number<V>;
+            V _value;
+
+            number() : _value{-std::numeric_limits<V>::quiet_NaN()}
             {
-                return n *= static_cast<N>(mutable_(other));
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator/(const number_t n, T value)
+            number(const number &value) : _value{value._value}
             {
-                return n._value / static_cast<V>(value);
             }
 
             template <typename T = void>
             requires ArithmeticOrEnum<T>
-            friend T operator/(T value, const number_t n)
+            number(T initValue) : _value{static_cast<V>(initValue)}
             {
-                return value / static_cast<T>(n._value);
             }
 
             template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator/=(T value)
+            requires ArithmeticOrEnum<T>
+            number(const shared<T> &initValue) : _value{static_cast<V>(initValue.get())}
             {
-                _value /= static_cast<V>(value);
-                return *this;
             }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            friend N operator/=(N &n, const number &other)
+            number(js::pointer_t p) : _value{p._ptr != nullptr ? static_cast<V>(intptr_t(p._ptr)) : -std::numeric_limits<V>::quiet_NaN()}
             {
-                return n /= static_cast<N>(mutable_(other));
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator^(const number_t n, T value)
+            number(const undefined_t &undef) : _value{-std::numeric_limits<V>::quiet_NaN()}
             {
-                return static_cast<long>(n._value) ^ static_cast<long>(static_cast<V>(value));
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnum<T>
-            friend number_t operator^(T value, const number_t n)
+            inline bool is_undefined()
             {
-                return static_cast<long>(static_cast<V>(value)) ^ static_cast<long>(n._value);
+                return std::signbit(_value) && std::isnan(_value);
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator^=(T value)
+            constexpr operator size_t()
             {
-                _value = static_cast<long>(_value) ^ static_cast<long>(static_cast<V>(value));
-                return *this;
+                return static_cast<size_t>(_value);
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-            friend number_t operator|(const number_t n, T value)
+            constexpr operator bool()
             {
-                return static_cast<long>(n._value) | static_cast<long>(static_cast<V>(value));
+                return _value == _value && _value != 0;
             }
 
             template <typename T = void>
             requires ArithmeticOrEnum<T>
-            friend T operator|(T value, const number_t n)
+            constexpr operator T()
             {
-                return static_cast<long>(static_cast<V>(value)) | static_cast<long>(n._value);
+                return static_cast<T>(_value);
             }
 
-            template <typename T = void>
-            requires ArithmeticOrEnumOrNumber<T>
-                number_t &operator|=(T value)
+            constexpr number_t *operator->()
             {
-                _value = static_cast<long>(_value) | static_cast<long>(static_cast<V>(value));
-                return *this;
+                return this;
+            }
+
+            operator tstring() const
+            {
+                tostringstream streamObj2;
+                streamObj2 << _value;
+                return streamObj2.str();
+            }
+
+            operator tstring()
+            {
+                tostringstream streamObj2;
+                streamObj2 << _value;
+                return streamObj2.str();
+            }
+
+            operator js::string();
+
+            inline bool operator==(undefined_t)
+            {
+                return is_undefined();
+            }
+
+            inline bool operator!=(undefined_t)
+            {
+                return !is_undefined();
+            }
+
+            inline friend bool operator==(const undefined_t, number_t other)
+            {
+                return other.is_undefined();
+            }
+
+            inline friend bool operator!=(const undefined_t, number_t other)
+            {
+                return !other.is_undefined();
+            }
+
+            inline friend bool operator==(const number_t n, js::pointer_t p)
+            {
+                return mutable_(n).is_undefined() == p.isUndefined && false;
+            }
+
+            inline friend bool operator!=(const number_t n, js::pointer_t p)
+            {
+                return mutable_(n).is_undefined() != p.isUndefined || true;
+            }
+
+            inline friend bool operator==(const number_t n, std::nullptr_t)
+            {
+                return mutable_(n).is_undefined();
+            }
+
+            inline friend bool operator!=(const number_t n, std::nullptr_t)
+            {
+                return !mutable_(n).is_undefined();
+            }
+
+            number_t operator+()
+            {
+                return +_value;
+            }
+
+            number_t &operator++()
+            {
+                _value += 1;
+                return *this;
+            }
+
+            number_t operator++(int)
+            {
+                number_t tmp(*this);
+                operator++();
+                return tmp;
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator+(const number_t n, T value)
+            {
+                return n._value + static_cast<V>(value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend T operator+(T value, const number_t n)
+            {
+                return value + static_cast<T>(n._value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator+=(T value)
+            {
+                _value += static_cast<V>(value);
+                return *this;
+            }
+
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend N operator+=(N &n, const number &other)
+            {
+                return n += static_cast<N>(mutable_(other));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator-(const number_t n, T value)
+            {
+                return n._value - static_cast<V>(value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend T operator-(T value, const number_t n)
+            {
+                return value - static_cast<T>(n._value);
+            }
+
+            number_t operator-()
+            {
+                return -_value;
+            }
+
+            number_t &operator--()
+            {
+                _value -= 1;
+                return *this;
+            }
+
+            number_t operator--(int)
+            {
+                number_t tmp(*this);
+                operator--();
+                return tmp;
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator-=(T value)
+            {
+                _value -= static_cast<V>(value);
+                return *this;
+            }
+
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend N operator-=(N &n, const number &other)
+            {
+                return n -= static_cast<N>(mutable_(other));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator*(const number_t n, T value)
+            {
+                return n._value * static_cast<V>(value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend T operator*(T value, const number_t n)
+            {
+                return value * static_cast<T>(n._value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator*=(T value)
+            {
+                _value *= static_cast<V>(value);
+                return *this;
+            }
+
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend N operator*=(N &n, const number &other)
+            {
+                return n *= static_cast<N>(mutable_(other));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator/(const number_t n, T value)
+            {
+                return n._value / static_cast<V>(value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend T operator/(T value, const number_t n)
+            {
+                return value / static_cast<T>(n._value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator/=(T value)
+            {
+                _value /= static_cast<V>(value);
+                return *this;
+            }
+
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            friend N operator/=(N &n, const number &other)
+            {
+                return n /= static_cast<N>(mutable_(other));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator^(const number_t n, T value)
+            {
+                return static_cast<long>(n._value) ^ static_cast<long>(static_cast<V>(value));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend number_t operator^(T value, const number_t n)
+            {
+                return static_cast<long>(static_cast<V>(value)) ^ static_cast<long>(n._value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator^=(T value)
+            {
+                _value = static_cast<long>(_value) ^ static_cast<long>(static_cast<V>(value));
+                return *this;
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+            friend number_t operator|(const number_t n, T value)
+            {
+                return static_cast<long>(n._value) | static_cast<long>(static_cast<V>(value));
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnum<T>
+            friend T operator|(T value, const number_t n)
+            {
+                return static_cast<long>(static_cast<V>(value)) | static_cast<long>(n._value);
+            }
+
+            template <typename T = void>
+            requires ArithmeticOrEnumOrNumber<T>
+                number_t &operator|=(T value)
+            {
+                _value = static_cast<long>(_value) | static_cast<long>(static_cast<V>(value));
+                return *this;
             }
 
             template <typename T = void>
@@ -1370,11 +2174,18 @@ constexpr const T const_(T t) {
             {
             }
 
+            string(string &&value) noexcept : _value(std::move(value._value)), _control(value._control)
+            {
+            }
+
+            string &operator=(const string &) = default;
+            string &operator=(string &&) noexcept = default;
+
             string(js::pointer_t v) : _value(v ? static_cast<const char_t *>(v) : TXT("")), _control(v ? string_defined : string_null)
             {
             }
 
-            string(tstring value) : _value(value), _control(string_defined)
+            string(tstring value) : _value(std::move(value)), _control(string_defined)
             {
             }
 
@@ -1506,9 +2317,9 @@ constexpr const T const_(T t) {
             requires ArithmeticOrEnumOrNumber<N>
                 string_t &operator+=(N n)
             {
-                auto value = t_tostring(n);
+                const auto value = string_t() + n;
                 _control = string_defined;
-                _value.append(value);
+                _value.append(value._value);
                 return *this;
             }
 
@@ -1869,9 +2680,10 @@ constexpr const T const_(T t) {
         struct array
         {
             using array_type_base = std::vector<E>;
-            //using array_type = array_type_base; // array_type_base - value type, std::shared_ptr<array_type_base> - reference type
-            using array_type = std::shared_ptr<array_type_base>; // array_type_base - value type, std::shared_ptr<array_type_base> - reference type
+            //using array_type = array_type_base; // array_type_base - value type, ref<ref_box<array_type_base>> - reference type
+            using array_type = ref<ref_box<array_type_base>>; // array_type_base - value type, ref<ref_box<array_type_base>> - reference type
             using array_type_ref = array_type_base &;
+            using store_type = ref_box<array_type_base>; // storage which can be placed on the stack
 
             template <typename _Ty>
             struct array_traits
@@ -1889,46 +2701,74 @@ constexpr const T const_(T t) {
             };
 
             template <>
-            struct array_traits<std::shared_ptr<array_type_base>>
+            struct array_traits<ref<ref_box<array_type_base>>>
             {
                 template <class... _Types>
                 static inline auto create(_Types &&..._Args)
                 {
-                    return std::make_shared<array_type_base>(_Args...);
+                    JS_STAT(stores_allocated);
+                    return new_<ref_box<array_type_base>>(_Args...);
                 }
 
                 static inline array_type_ref access(array_type &_Arg)
                 {
-                    return (static_cast<array_type_ref>(*_Arg));
+                    return (static_cast<array_type_ref>(_Arg->value));
                 }
             };
 
-            bool isUndefined;
+            // null - defined but storage is not allocated yet, &undefined_store - undefined
             array_type _values;
 
-            array() : _values(array_traits<array_type>::create()), isUndefined(false)
+            // marks undefined arrays and is read as the storage of arrays without one, never written. Empty arrays hold
+            // null, so creating and copying them touches no reference count
+            static inline store_type undefined_store;
+
+            array()
+            {
+                JS_STAT(stores_deferred);
+            }
+
+            array(const array &value) : _values(value.shared_store())
+            {
+            }
+
+            array(std::initializer_list<E> values) : _values(values.size() > 0 ? array_traits<array_type>::create(values) : nullptr)
+            {
+            }
+
+            array(std::vector<E> values) : _values(array_traits<array_type>::create(values))
             {
             }
 
-            array(const array &value) : _values(value._values), isUndefined(value.isUndefined)
+            array(const array_type &store, std::initializer_list<E> values = {}) : _values(store)
             {
+                get().assign(values);
             }
 
-            array(std::initializer_list<E> values) : _values(array_traits<array_type>::create(values)), isUndefined(false)
+            array(const undefined_t &undef) : _values(ref_of(&undefined_store))
             {
             }
 
-            array(std::vector<E> values) : _values(array_traits<array_type>::create(values)), isUndefined(false)
+            array &operator=(const array &value)
+            {
+                _values = value.shared_store();
+                return *this;
+            }
+
+            inline bool is_undefined() const
             {
+                return _values.get() == &undefined_store;
             }
 
-            array(const undefined_t &undef) : _values(array_traits<array_type>::create()), isUndefined(true)
+            // reference identity, empty values without storage identify nothing
+            inline bool same_store(const array &other) const
             {
+                return this == &other || _values && _values.get() == other._values.get() && !is_undefined();
             }
 
             constexpr operator bool()
             {
-                return !isUndefined;
+                return !is_undefined();
             }
 
             constexpr array *operator->()
@@ -1936,19 +2776,48 @@ constexpr const T const_(T t) {
                 return this;
             }
 
+            // copies share storage, so it is allocated before it is shared
+            const array_type &shared_store() const
+            {
+                if (!_values)
+                {
+                    JS_STAT(stores_materialized);
+                    mutable_(_values) = array_traits<array_type>::create();
+                }
+
+                return _values;
+            }
+
+            // storage for reading, not allocated storage reads as the empty undefined_store
+            constexpr array_type_ref get_const() const
+            {
+                return _values ? array_traits<array_type>::access(mutable_(_values)) : undefined_store.value;
+            }
+
             constexpr array_type_ref get() const
             {
-                return array_traits<array_type>::access(mutable_(_values));
+                return get_const();
             }
 
-            constexpr array_type_ref get()
+            // storage for writing, allocated on first write
+            array_type_ref get()
             {
+                if (!_values || is_undefined())
+                {
+                    if (!_values)
+                    {
+                        JS_STAT(stores_materialized);
+                    }
+
+                    _values = array_traits<array_type>::create();
+                }
+
                 return array_traits<array_type>::access(_values);
             }
 
             size_t get_length()
             {
-                return get().size();
+                return get_const().size();
             }
 
             template <typename N = void>
@@ -1957,6 +2826,7 @@ constexpr const T const_(T t) {
             {
                 if (static_cast<size_t>(i) >= get().size())
                 {
+                    JS_COUNT(array_read_past_end);
                     if constexpr (std::is_same_v<decltype(E{undefined}), E>)
                     {
                         static E empty{undefined};
@@ -1976,6 +2846,11 @@ constexpr const T const_(T t) {
             requires can_cast_to_size_t<N>
                 E &operator[](N i)
             {
+                if (static_cast<size_t>(i) >= get().size())
+                {
+                    JS_COUNT(array_grow);
+                }
+
                 while (static_cast<size_t>(i) >= get().size())
                 {
                     if constexpr (std::is_same_v<decltype(E{undefined}), E>)
@@ -1993,7 +2868,7 @@ constexpr const T const_(T t) {
 
             ArrayKeys<size_t> keys()
             {
-                return ArrayKeys<size_t>(get().size());
+                return ArrayKeys<size_t>(get_const().size());
             }
 
             void push(E t)
@@ -2012,7 +2887,22 @@ constexpr const T const_(T t) {
 
             E pop()
             {
-                return get().pop_back();
+                auto &values = get();
+                if (values.empty())
+                {
+                    if constexpr (std::is_constructible_v<E, undefined_t>)
+                    {
+                        return E(undefined);
+                    }
+                    else
+                    {
+                        return E{};
+                    }
+                }
+
+                auto last = std::move(values.back());
+                values.pop_back();
+                return last;
             }
 
             template <typename... Args>
@@ -2024,12 +2914,12 @@ constexpr const T const_(T t) {
 
             array slice(size_t first, size_t last)
             {
-                return array(std::vector<E>(get().cbegin() + first, get().cbegin() + last + 1));
+                return array(std::vector<E>(get_const().cbegin() + first, get_const().cbegin() + last + 1));
             }
 
             js::number indexOf(const E &e)
             {
-                return get().cend() - std::find(get().cbegin(), get().cend(), e) - 1;
+                return get_const().cend() - std::find(get_const().cbegin(), get_const().cend(), e) - 1;
             }
 
             js::boolean removeElement(const E &e)
@@ -2039,17 +2929,17 @@ constexpr const T const_(T t) {
 
             auto begin()
             {
-                return get().begin();
+                return get_const().begin();
             }
 
             auto end()
             {
-                return get().end();
+                return get_const().end();
             }
 
             friend std::ostream &operator<<(std::ostream &os, array val)
             {
-                if (val.isUndefined)
+                if (val.is_undefined())
                 {
                     return os << "undefined";
                 }
@@ -2073,15 +2963,15 @@ constexpr const T const_(T t) {
             array filter(std::function<bool(E)> p)
             {
                 std::vector<E> result;
-                std::copy_if(get().begin(), get().end(), std::back_inserter(result), p);
+                std::copy_if(get_const().begin(), get_const().end(), std::back_inserter(result), p);
                 return result;
             }
 
             array filter(std::function<bool(E, size_t)> p)
             {
                 std::vector<E> result;
-                auto first = &(get())[0];
-                std::copy_if(get().begin(), get().end(), std::back_inserter(result), [=](auto &v)
+                auto first = &(get_const())[0];
+                std::copy_if(get_const().begin(), get_const().end(), std::back_inserter(result), [=](auto &v)
                              {
                                  auto index = &v - first;
                                  return p(v, index);
@@ -2093,7 +2983,7 @@ constexpr const T const_(T t) {
             auto map(F p) -> array<undefined_t>
             {
                 std::vector<undefined_t> result;
-                std::transform(get().begin(), get().end(), std::back_inserter(result), [=](auto &v)
+                std::transform(get_const().begin(), get_const().end(), std::back_inserter(result), [=](auto &v)
                                {
                                    mutable_(p)(v);
                                    return undefined;
@@ -2131,42 +3021,54 @@ constexpr const T const_(T t) {
             template <typename P>
             auto reduce(P p)
             {
-                return std::reduce(get().begin(), get().end(), 0, p);
+                return std::reduce(get_const().begin(), get_const().end(), 0, p);
             }
 
             template <typename P, typename I>
             auto reduce(P p, I initial)
             {
-                return std::reduce(get().begin(), get().end(), initial, p);
+                return std::reduce(get_const().begin(), get_const().end(), initial, p);
             }
 
             template <typename P>
             boolean every(P p)
             {
-                return std::all_of(get().begin(), get().end(), p);
+                return std::all_of(get_const().begin(), get_const().end(), p);
             }
 
             template <typename P>
             boolean some(P p)
             {
-                return std::any_of(get().begin(), get().end(), p);
+                return std::any_of(get_const().begin(), get_const().end(), p);
             }
 
             js::string join(js::string s)
             {
-                return std::accumulate(get().begin(), get().end(), js::string{}, [&](auto &res, auto &piece)
-                                       { return res += (res) ? s + piece : piece; });
+                js::string result(TXT(""));
+                auto first = true;
+                for (auto &piece : get_const())
+                {
+                    if (!first)
+                    {
+                        result += s;
+                    }
+
+                    first = false;
+                    result += piece;
+                }
+
+                return result;
             }
 
             void forEach(std::function<void(E)> p)
             {
-                std::for_each(get().begin(), get().end(), p);
+                std::for_each(get_const().begin(), get_const().end(), p);
             }
 
             void forEach(std::function<void(E, size_t)> p)
             {
-                auto first = &(*_values.get())[0];
-                std::for_each(get().begin(), get().end(), [=](auto &v)
+                auto first = &get_const()[0];
+                std::for_each(get_const().begin(), get_const().end(), [=](auto &v)
                               {
                                   auto index = &v - first;
                                   return p(v, index);
@@ -2176,234 +3078,781 @@ constexpr const T const_(T t) {
 
     } // namespace tmpl
 
-    template <typename TKey, typename TMap>
+    // snapshot of keys, stays valid when object is modified inside of for-in loop. The storage is held so the
+    // object can be reassigned in the loop, keys deleted before they are reached are skipped as in JS
+    template <typename TKey, typename TStore>
     struct ObjectKeys
     {
-        typedef ObjectKeys<TKey, TMap> iterator;
-        typedef decltype(((TMap *)nullptr)->begin()) TIterator_map;
+        struct iterator
+        {
+            typename std::vector<TKey>::iterator _current;
+            typename std::vector<TKey>::iterator _end;
+            const TStore *_store;
 
-        TIterator_map _index;
-        const TIterator_map _end;
+            void skip_deleted()
+            {
+                while (_current != _end && !(*_store)->value.contains(*_current))
+                {
+                    ++_current;
+                }
+            }
 
-        ObjectKeys(TMap &values_) : _index(values_.begin()), _end(values_.end())
-        {
-        }
+            TKey &operator*() const
+            {
+                return *_current;
+            }
 
-        iterator &begin()
-        {
-            return *this;
-        }
+            iterator &operator++()
+            {
+                ++_current;
+                skip_deleted();
+                return *this;
+            }
 
-        iterator &end()
-        {
-            return *this;
-        }
+            bool operator!=(const iterator &other) const
+            {
+                return _current != other._current;
+            }
+        };
+
+        TStore _store;
+        std::vector<TKey> _keys;
 
-        const TKey &operator*()
+        ObjectKeys(const TStore &store) : _store(store)
         {
-            return _index->first;
+            if (!_store)
+            {
+                return;
+            }
+
+            auto &values_ = _store->value;
+            _keys.reserve(values_.size());
+            for (auto &item : values_)
+            {
+                _keys.push_back(item.first);
+            }
         }
 
-        bool operator!=(const iterator &rhs)
+        iterator begin()
         {
-            return _index != rhs._end;
+            return iterator{_keys.begin(), _keys.end(), &_store};
         }
 
-        iterator &operator++()
+        iterator end()
         {
-            ++_index;
-            return *this;
+            return iterator{_keys.end(), _keys.end(), &_store};
         }
     };
 
     namespace tmpl
     {
 
-        template <typename K, typename V>
-        struct object
+        // property storage of objects in dictionary mode: a dense array of entries in insertion order and an open
+        // addressing index of 1, 2 or 4 byte entry positions over it (the compact dict of CPython 3.6). Iteration is
+        // a scan of the entries, array index keys ("0", "1", ...) are visited first in ascending order as in JS
+        template <typename K, typename V, typename Hash, typename Equal>
+        struct compact_dict
         {
-            struct K_hash
+            using key_type = K;
+            using mapped_type = V;
+            using value_type = std::pair<K, V>;
+            using size_type = std::size_t;
+
+            struct entry
             {
-                typedef K argument_type;
-                typedef std::size_t result_type;
-                result_type operator()(argument_type const &value) const
+                // removed_hash marks a hole left by erase()
+                std::size_t hash;
+                value_type value;
+            };
+
+            static constexpr std::size_t removed_hash = ~std::size_t{0};
+            static constexpr std::int32_t slot_empty = -1;
+            static constexpr std::int32_t slot_removed = -2;
+            static constexpr std::size_t min_capacity = 8;
+
+            std::vector<entry> _entries;
+            // positions in _entries, capacity() slots of _width bytes
+            std::vector<std::uint8_t> _index;
+            std::size_t _width = 1;
+            std::size_t _size = 0;
+            std::size_t _array_index_keys = 0;
+            // iteration order when there are array index keys, rebuilt after keys are added or removed
+            mutable std::vector<std::uint32_t> _order;
+            mutable bool _order_valid = false;
+
+            struct iterator
+            {
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = compact_dict::value_type;
+                using difference_type = std::ptrdiff_t;
+                using pointer = value_type *;
+                using reference = value_type &;
+
+                const compact_dict *_dict = nullptr;
+                // position in _entries, or in _order when _ordered
+                std::size_t _step = 0;
+                bool _ordered = false;
+
+                inline entry &current() const
                 {
-                    return value.hash();
+                    return mutable_(_dict->_entries[_ordered ? _dict->_order[_step] : _step]);
                 }
-            };
 
-            struct K_equal_to
-            {
-                typedef K argument_type;
-                bool operator()(argument_type const &value, argument_type const &other) const
+                inline void skip_holes()
                 {
-                    return value == other;
+                    while (!at_end() && current().hash == removed_hash)
+                    {
+                        _step++;
+                    }
                 }
-            };
 
-            using object_type_base = std::unordered_map<K, V, K_hash, K_equal_to>;
-            //using object_type = object_type_base; // object_type_base - value type, std::shared_ptr<object_type_base> - reference type
-            using object_type = std::shared_ptr<object_type_base>; // object_type_base - value type, std::shared_ptr<object_type_base> - reference type
-            using object_type_ref = object_type_base &;
-            using pair = std::pair<const K, V>;
+                inline bool at_end() const
+                {
+                    return !_dict || _step >= (_ordered ? _dict->_order.size() : _dict->_entries.size());
+                }
 
-            template <typename _Ty>
-            struct object_traits
-            {
-                template <class... _Types>
-                static _Ty create(_Types &&..._Args)
+                inline reference operator*() const
                 {
-                    return object_type_base(_Args...);
+                    return current().value;
                 }
 
-                static constexpr _Ty &access(std::remove_reference_t<_Ty> &_Arg)
+                inline pointer operator->() const
                 {
-                    return (static_cast<_Ty &>(_Arg));
+                    return &current().value;
                 }
-            };
 
-            template <>
-            struct object_traits<std::shared_ptr<object_type_base>>
-            {
-                template <class... _Types>
-                static inline auto create(_Types &&..._Args)
+                inline iterator &operator++()
                 {
-                    return std::make_shared<object_type_base>(_Args...);
+                    _step++;
+                    skip_holes();
+                    return *this;
                 }
 
-                static inline object_type_ref access(object_type &_Arg)
+                inline iterator operator++(int)
+                {
+                    auto copy = *this;
+                    ++*this;
+                    return copy;
+                }
+
+                inline bool operator==(const iterator &other) const
                 {
-                    return (static_cast<object_type_ref>(*_Arg));
+                    const auto end = at_end();
+                    return end == other.at_end() && (end || &current() == &other.current());
+                }
+
+                inline bool operator!=(const iterator &other) const
+                {
+                    return !(*this == other);
                 }
             };
 
-            bool isUndefined;
-            object_type _values;
+            using const_iterator = iterator;
 
-            object();
+            compact_dict() = default;
 
-            object(const object &value);
+            compact_dict(std::initializer_list<value_type> values)
+            {
+                reserve(values.size());
+                for (auto &item : values)
+                {
+                    insert_or_assign(item.first, item.second);
+                }
+            }
 
-            object(std::initializer_list<pair> values);
+            inline size_type size() const
+            {
+                return _size;
+            }
 
-            object(const undefined_t &);
+            inline bool empty() const
+            {
+                return _size == 0;
+            }
 
-            virtual ~object()
+            inline std::size_t capacity() const
             {
+                return _index.size() / _width;
             }
 
-            constexpr operator bool()
+            iterator begin() const
             {
-                return !isUndefined;
+                iterator result{this, 0, _array_index_keys > 0};
+                if (result._ordered)
+                {
+                    build_order();
+                }
+
+                result.skip_holes();
+                return result;
             }
 
-            constexpr object_type_ref get() const
+            inline iterator end() const
             {
-                return object_traits<object_type>::access(mutable_(_values));
+                return iterator{};
             }
 
-            constexpr object_type_ref get()
+            inline iterator cbegin() const
             {
-                return object_traits<object_type>::access(_values);
+                return begin();
             }
 
-            static ObjectKeys<js::string, object_type_base> keys(const object &);
+            inline iterator cend() const
+            {
+                return end();
+            }
 
-            ObjectKeys<js::string, object_type_base> keys();
+            iterator find(const K &key) const
+            {
+                const auto slot = find_slot(key, hash_of(key));
+                return slot == capacity() ? end() : iterator{this, static_cast<std::size_t>(get_slot(slot)), false};
+            }
 
-            constexpr object *operator->()
+            inline size_type count(const K &key) const
             {
-                return this;
+                return find_slot(key, hash_of(key)) != capacity();
             }
 
-            any &operator[](js::number n) const;
+            inline bool contains(const K &key) const
+            {
+                return count(key) != 0;
+            }
 
-            any &operator[](const char_t *s) const;
+            V &operator[](const K &key)
+            {
+                return try_emplace(key).first->second;
+            }
 
-            any &operator[](std::string s) const;
+            template <typename... Args>
+            std::pair<iterator, bool> try_emplace(const K &key, Args &&...args)
+            {
+                const auto hash = hash_of(key);
+                const auto slot = find_slot(key, hash);
+                if (slot != capacity())
+                {
+                    return {iterator{this, static_cast<std::size_t>(get_slot(slot)), false}, false};
+                }
 
-            any &operator[](js::string s) const;
+                return {append(hash, K(key), V(std::forward<Args>(args)...)), true};
+            }
 
-            any &operator[](js::number n);
+            template <typename KV, typename T>
+            std::pair<iterator, bool> insert_or_assign(KV &&key, T &&value)
+            {
+                const K &lookup = key;
+                const auto hash = hash_of(lookup);
+                const auto slot = find_slot(lookup, hash);
+                if (slot != capacity())
+                {
+                    auto &found = _entries[get_slot(slot)];
+                    found.value.second = std::forward<T>(value);
+                    return {iterator{this, static_cast<std::size_t>(get_slot(slot)), false}, false};
+                }
 
-            any &operator[](const char_t *s);
+                return {append(hash, K(std::forward<KV>(key)), V(std::forward<T>(value))), true};
+            }
 
-            any &operator[](std::string s);
+            std::pair<iterator, bool> insert(const value_type &value)
+            {
+                return try_emplace(value.first, value.second);
+            }
 
-            any &operator[](js::string s);
+            size_type erase(const K &key)
+            {
+                const auto slot = find_slot(key, hash_of(key));
+                if (slot == capacity())
+                {
+                    return 0;
+                }
 
-            any &operator[](undefined_t undef);
+                auto &removed = _entries[get_slot(slot)];
+                _array_index_keys -= is_array_index(removed.value.first);
+                removed.hash = removed_hash;
+                removed.value = value_type();
+                set_slot(slot, slot_removed);
+                _size--;
+                _order_valid = false;
+                return 1;
+            }
 
-            inline bool operator==(const object &other) const
+            void clear()
             {
-                // TODO - finish it
-                return isUndefined == other.isUndefined && isUndefined == true;
+                _entries.clear();
+                _index.clear();
+                _size = 0;
+                _array_index_keys = 0;
+                _order_valid = false;
             }
 
-            void Delete(js::number field)
+            void reserve(std::size_t count)
             {
-                get().erase(field.operator std::string &());
+                if (count > usable(capacity()))
+                {
+                    resize(count);
+                }
             }
 
-            void Delete(js::string field)
+            // canonical array index: "0" or digits without a leading zero, below 2^32 - 1
+            static bool is_array_index(const K &key, std::uint32_t *index = nullptr)
             {
-                get().erase(field.operator std::string &());
+                if constexpr (requires { key._value.data(); })
+                {
+                    const auto &text = key._value;
+                    if (text.empty() || text.size() > 10 || text[0] < '0' || text[0] > '9' || text[0] == '0' && text.size() > 1)
+                    {
+                        return false;
+                    }
+
+                    std::uint64_t value = 0;
+                    for (auto c : text)
+                    {
+                        if (c < '0' || c > '9')
+                        {
+                            return false;
+                        }
+
+                        value = value * 10 + (c - '0');
+                    }
+
+                    if (value >= 0xFFFFFFFFull)
+                    {
+                        return false;
+                    }
+
+                    if (index)
+                    {
+                        *index = static_cast<std::uint32_t>(value);
+                    }
+
+                    return true;
+                }
+                else
+                {
+                    return false;
+                }
             }
 
-            void Delete(js::any field)
+            static inline std::size_t usable(std::size_t capacity)
             {
-                get().erase(field.operator std::string &());
+                return capacity * 2 / 3;
             }
 
-            void Delete(js::undefined_t)
+            static inline std::size_t hash_of(const K &key)
             {
-                get().erase("undefined");
+                return Hash{}(key) & (removed_hash >> 1);
             }
 
-            void Delete(const char_t *field)
+            inline std::int32_t get_slot(std::size_t slot) const
             {
-                get().erase(field);
+                switch (_width)
+                {
+                case 1:
+                    return static_cast<std::int8_t>(_index[slot]);
+                case 2:
+                    return reinterpret_cast<const std::int16_t *>(_index.data())[slot];
+                default:
+                    return reinterpret_cast<const std::int32_t *>(_index.data())[slot];
+                }
             }
 
-            template <typename N = void>
-            requires ArithmeticOrEnum<N>
-            bool exists(N n) const
+            inline void set_slot(std::size_t slot, std::int32_t value)
             {
-                return get().find(js::string(to_tstring(n))) != get().end();
+                switch (_width)
+                {
+                case 1:
+                    _index[slot] = static_cast<std::uint8_t>(static_cast<std::int8_t>(value));
+                    break;
+                case 2:
+                    reinterpret_cast<std::int16_t *>(_index.data())[slot] = static_cast<std::int16_t>(value);
+                    break;
+                default:
+                    reinterpret_cast<std::int32_t *>(_index.data())[slot] = value;
+                    break;
+                }
             }
 
-            template <class T>
-            bool exists(T i) const
+            // slot of the key, or capacity() when there is none
+            std::size_t find_slot(const K &key, std::size_t hash) const
             {
-                if constexpr (is_stringish_v<T>)
+                const auto capacity_ = capacity();
+                if (_size == 0)
                 {
-                    return get().find(i) != get().end();
+                    return capacity_;
                 }
 
-                return false;
+                const auto mask = capacity_ - 1;
+                auto slot = hash & mask;
+                for (auto perturb = hash;; perturb >>= 5)
+                {
+                    const auto position = get_slot(slot);
+                    if (position == slot_empty)
+                    {
+                        return capacity_;
+                    }
+
+                    if (position >= 0)
+                    {
+                        auto &candidate = _entries[position];
+                        if (candidate.hash == hash && Equal{}(candidate.value.first, key))
+                        {
+                            return slot;
+                        }
+                    }
+
+                    slot = (slot * 5 + perturb + 1) & mask;
+                }
             }
 
-            virtual js::string toString()
+            std::size_t find_empty_slot(std::size_t hash) const
             {
-                tostringstream streamObj2;
-                streamObj2 << *this;
-                return streamObj2.str();
+                const auto mask = capacity() - 1;
+                auto slot = hash & mask;
+                for (auto perturb = hash; get_slot(slot) != slot_empty; perturb >>= 5)
+                {
+                    slot = (slot * 5 + perturb + 1) & mask;
+                }
+
+                return slot;
             }
 
-            friend tostream &operator<<(tostream &os, object val)
+            iterator append(std::size_t hash, K &&key, V &&value)
             {
-                if (val.isUndefined)
+                // holes count as used, resize() drops them
+                if (_entries.size() >= usable(capacity()))
                 {
-                    return os << TXT("undefined");
+                    resize(_size + 1);
                 }
 
-                return os << TXT("[object]");
+                _array_index_keys += is_array_index(key);
+                const auto position = _entries.size();
+                set_slot(find_empty_slot(hash), static_cast<std::int32_t>(position));
+                _entries.push_back(entry{hash, value_type(std::move(key), std::move(value))});
+                _size++;
+                _order_valid = false;
+                return iterator{this, position, false};
             }
-        };
 
-    } // namespace tmpl
+            // drops holes and rebuilds index with room for 3/2 of `count` entries
+            void resize(std::size_t count)
+            {
+                JS_COUNT(object_rehash);
+                if (_size < _entries.size())
+                {
+                    _entries.erase(std::remove_if(_entries.begin(), _entries.end(), [](auto &item) { return item.hash == removed_hash; }), _entries.end());
+                }
 
-    typedef tmpl::object<string, any> object;
+                auto new_capacity = min_capacity;
+                while (usable(new_capacity) < count)
+                {
+                    new_capacity *= 2;
+                }
+
+                _width = new_capacity <= 0x80 ? 1 : new_capacity <= 0x8000 ? 2 : 4;
+                // all bytes 0xFF reads as slot_empty in every width
+                _index.assign(new_capacity * _width, 0xFF);
+                _entries.reserve(count);
+                for (std::size_t position = 0; position < _entries.size(); position++)
+                {
+                    set_slot(find_empty_slot(_entries[position].hash), static_cast<std::int32_t>(position));
+                }
+
+                _order_valid = false;
+            }
+
+            void build_order() const
+            {
+                if (_order_valid)
+                {
+                    return;
+                }
+
+                _order.clear();
+                std::vector<std::pair<std::uint32_t, std::uint32_t>> indexes;
+                for (std::size_t position = 0; position < _entries.size(); position++)
+                {
+                    std::uint32_t index;
+                    if (_entries[position].hash != removed_hash && is_array_index(_entries[position].value.first, &index))
+                    {
+                        indexes.emplace_back(index, static_cast<std::uint32_t>(position));
+                    }
+                }
+
+                std::sort(indexes.begin(), indexes.end());
+                for (auto &item : indexes)
+                {
+                    _order.push_back(item.second);
+                }
+
+                for (std::size_t position = 0; position < _entries.size(); position++)
+                {
+                    if (_entries[position].hash != removed_hash && !is_array_index(_entries[position].value.first))
+                    {
+                        _order.push_back(static_cast<std::uint32_t>(position));
+                    }
+                }
+
+                _order_valid = true;
+            }
+        };
+
+        template <typename K, typename V>
+        struct object : public ref_counted
+        {
+            struct K_hash
+            {
+                typedef K argument_type;
+                typedef std::size_t result_type;
+                result_type operator()(argument_type const &value) const
+                {
+                    return value.hash();
+                }
+            };
+
+            struct K_equal_to
+            {
+                typedef K argument_type;
+                bool operator()(argument_type const &value, argument_type const &other) const
+                {
+                    return value == other;
+                }
+            };
+
+            using object_type_base = compact_dict<K, V, K_hash, K_equal_to>;
+            //using object_type = object_type_base; // object_type_base - value type, ref<ref_box<object_type_base>> - reference type
+            using object_type = ref<ref_box<object_type_base>>; // object_type_base - value type, ref<ref_box<object_type_base>> - reference type
+            using object_type_ref = object_type_base &;
+            using store_type = ref_box<object_type_base>; // storage which can be placed on the stack
+            using pair = std::pair<const K, V>;
+
+            template <typename _Ty>
+            struct object_traits
+            {
+                template <class... _Types>
+                static _Ty create(_Types &&..._Args)
+                {
+                    return object_type_base(_Args...);
+                }
+
+                static constexpr _Ty &access(std::remove_reference_t<_Ty> &_Arg)
+                {
+                    return (static_cast<_Ty &>(_Arg));
+                }
+            };
+
+            template <>
+            struct object_traits<ref<ref_box<object_type_base>>>
+            {
+                template <class... _Types>
+                static inline auto create(_Types &&..._Args)
+                {
+                    JS_STAT(stores_allocated);
+                    return new_<ref_box<object_type_base>>(_Args...);
+                }
+
+                static inline object_type_ref access(object_type &_Arg)
+                {
+                    return (static_cast<object_type_ref>(_Arg->value));
+                }
+            };
+
+            // null - defined but storage is not allocated yet, &undefined_store - undefined
+            object_type _values;
+
+            // see class_cast(), nullptr - not a numbered class instance
+            const std::uint32_t *_class_display = nullptr;
+
+            // marks undefined objects and is read as the storage of objects without one, never written. Empty objects
+            // hold null, so creating and copying them touches no reference count
+            static inline store_type undefined_store;
+
+            object();
+
+            object(const object &value);
+
+            object(std::initializer_list<pair> values);
+
+            object(const object_type &store, std::initializer_list<pair> values = {});
+
+            object(const undefined_t &);
+
+            virtual ~object()
+            {
+            }
+
+            // single pass over literal values into pre-sized storage, later duplicate keys win as in JS
+            void insert_values(std::initializer_list<pair> values)
+            {
+                auto &ref = get();
+                ref.reserve(ref.size() + values.size());
+                for (auto &item : values)
+                {
+                    ref.insert_or_assign(item.first, item.second);
+                }
+            }
+
+            object &operator=(const object &value)
+            {
+                _values = value.shared_store();
+                return *this;
+            }
+
+            inline bool is_undefined() const
+            {
+                return _values.get() == &undefined_store;
+            }
+
+            // reference identity, empty values without storage identify nothing
+            inline bool same_store(const object &other) const
+            {
+                return this == &other || _values && _values.get() == other._values.get() && !is_undefined();
+            }
+
+            constexpr operator bool()
+            {
+                return !is_undefined();
+            }
+
+            // copies share storage, so it is allocated before it is shared
+            const object_type &shared_store() const
+            {
+                if (!_values)
+                {
+                    JS_STAT(stores_materialized);
+                    mutable_(_values) = object_traits<object_type>::create();
+                }
+
+                return _values;
+            }
+
+            // storage for reading, not allocated storage reads as the empty undefined_store
+            constexpr object_type_ref get_const() const
+            {
+                return _values ? object_traits<object_type>::access(mutable_(_values)) : undefined_store.value;
+            }
+
+            constexpr object_type_ref get() const
+            {
+                return get_const();
+            }
+
+            // storage for writing, allocated on first write
+            object_type_ref get()
+            {
+                if (!_values || is_undefined())
+                {
+                    if (!_values)
+                    {
+                        JS_STAT(stores_materialized);
+                    }
+
+                    _values = object_traits<object_type>::create();
+                }
+
+                return object_traits<object_type>::access(_values);
+            }
+
+            static ObjectKeys<js::string, object_type> keys(const object &);
+
+            ObjectKeys<js::string, object_type> keys();
+
+            constexpr object *operator->()
+            {
+                return this;
+            }
+
+            any &operator[](js::number n) const;
+
+            any &operator[](const char_t *s) const;
+
+            any &operator[](std::string s) const;
+
+            any &operator[](js::string s) const;
+
+            any &operator[](js::number n);
+
+            any &operator[](const char_t *s);
+
+            any &operator[](std::string s);
+
+            any &operator[](js::string s);
+
+            any &operator[](undefined_t undef);
+
+            inline bool operator==(const object &other) const
+            {
+                return is_undefined() && other.is_undefined() || same_store(other);
+            }
+
+            void Delete(js::number field)
+            {
+                get().erase(field.operator std::string &());
+            }
+
+            void Delete(js::string field)
+            {
+                get().erase(field.operator std::string &());
+            }
+
+            void Delete(js::any field)
+            {
+                get().erase(field.operator std::string &());
+            }
+
+            void Delete(js::undefined_t)
+            {
+                get().erase("undefined");
+            }
+
+            void Delete(const char_t *field)
+            {
+                get().erase(field);
+            }
+
+            template <typename N = void>
+            requires ArithmeticOrEnum<N>
+            bool exists(N n) const
+            {
+                return get().find(js::string(to_tstring(n))) != get().end();
+            }
+
+            template <class T>
+            bool exists(T i) const
+            {
+                if constexpr (is_stringish_v<T>)
+                {
+                    return get().find(i) != get().end();
+                }
+
+                return false;
+            }
+
+            virtual js::string toString()
+            {
+                tostringstream streamObj2;
+                streamObj2 << *this;
+                return streamObj2.str();
+            }
+
+            // fields of emitted interfaces and classes, false makes JSON.stringify write own dynamic properties instead
+            virtual bool __json_write(json::stringifier &) const
+            {
+                return false;
+            }
+
+            friend tostream &operator<<(tostream &os, object val)
+            {
+                if (val.is_undefined())
+                {
+                    return os << TXT("undefined");
+                }
+
+                return os << TXT("[object]");
+            }
+        };
+
+    } // namespace tmpl
+
+    typedef tmpl::object<string, any> object;
 
     struct any
     {
@@ -2448,7 +3897,7 @@ constexpr const T const_(T t) {
             js::array_any,
             js::object,
             std::shared_ptr<js::function>,
-            std::shared_ptr<js::object>>;
+            js::ref<js::object>>;
 
         any_value_type _value;
 
@@ -2460,6 +3909,10 @@ constexpr const T const_(T t) {
         {
         }
 
+        any(any &&other) noexcept : _value(std::move(other._value))
+        {
+        }
+
         any(void_t) : _value(undefined)
         {
         }
@@ -2525,7 +3978,7 @@ constexpr const T const_(T t) {
         }
 
         template <typename C>
-        any(std::shared_ptr<C> value) : _value(std::shared_ptr<js::object>(value))
+        any(const js::ref<C> &value) : _value(js::ref<js::object>(value))
         {
         }
 
@@ -2539,34 +3992,203 @@ constexpr const T const_(T t) {
             return static_cast<anyTypeId>(_value.index());
         }
 
-        template <typename T>
-        inline const T &get() const
-        {
-            return std::get<T>(_value);
-        }
-
-        template <typename T>
-        inline std::shared_ptr<T> get_ptr() const
-        {
-            return std::dynamic_pointer_cast<T>(mutable_(std::get<std::shared_ptr<js::object>>(_value)));
-        }
+        static constexpr int type_count = anyTypeId::class_type + 1;
 
-        template <typename T>
-        inline T &get()
+        // binary operations on any x any switch once on the pair of operand types
+        static constexpr int pair_of(anyTypeId left, anyTypeId right)
         {
-            return std::get<T>(_value);
+            return left * type_count + right;
         }
 
-        template <typename T>
-        inline std::shared_ptr<T> get_ptr()
+        inline int pair_with(const any &other) const
         {
-            return std::dynamic_pointer_cast<T>(std::get<std::shared_ptr<js::object>>(_value));
+            return pair_of(get_type(), other.get_type());
         }
 
-        inline const js::boolean &boolean_ref_const() const
+        // ToNumber
+        double to_number() const
         {
-            return get<js::boolean>();
-        }
+            switch (get_type())
+            {
+            case anyTypeId::boolean_type:
+                return boolean_ref_const() ? 1 : 0;
+            case anyTypeId::number_type:
+                return number_ref_const()._value;
+            case anyTypeId::string_type:
+                return string_to_number(string_ref_const()._value);
+            case anyTypeId::pointer_type:
+                return get<js::pointer_t>().isUndefined ? std::numeric_limits<double>::quiet_NaN() : 0;
+            default:
+                break;
+            }
+
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        // StringToNumber: white space around a decimal literal with optional sign, Infinity or a 0x/0o/0b integer,
+        // anything else (inf, nan, hex floats, trailing characters) is NaN; nothing throws
+        static double string_to_number(const tstring &value)
+        {
+            constexpr auto nan = std::numeric_limits<double>::quiet_NaN();
+            constexpr auto infinity = std::numeric_limits<double>::infinity();
+            const auto is_space = [](char_t c) {
+                return c == ' ' || c >= '\t' && c <= '\r'
+#ifdef UNICODE
+                       || c == 0xA0 || c == 0x1680 || c >= 0x2000 && c <= 0x200A || c == 0x2028 || c == 0x2029
+                       || c == 0x202F || c == 0x205F || c == 0x3000 || c == 0xFEFF
+#endif
+                    ;
+            };
+            const auto is_digit = [](char_t c) { return c >= '0' && c <= '9'; };
+
+            auto begin = value.data();
+            auto end = begin + value.size();
+            while (begin < end && is_space(*begin))
+            {
+                begin++;
+            }
+
+            while (end > begin && is_space(end[-1]))
+            {
+                end--;
+            }
+
+            if (begin == end)
+            {
+                return 0;
+            }
+
+            if (end - begin > 2 && begin[0] == '0')
+            {
+                const auto prefix = begin[1] | 0x20;
+                const auto radix = prefix == 'x' ? 16 : prefix == 'o' ? 8 : prefix == 'b' ? 2 : 0;
+                if (radix)
+                {
+                    double result = 0;
+                    for (auto current = begin + 2; current < end; current++)
+                    {
+                        const auto c = *current;
+                        const auto lower = c | 0x20;
+                        const auto digit = is_digit(c) ? c - '0' : lower >= 'a' && lower <= 'z' ? lower - 'a' + 10 : radix;
+                        if (digit >= radix)
+                        {
+                            return nan;
+                        }
+
+                        result = result * radix + digit;
+                    }
+
+                    return result;
+                }
+            }
+
+            const auto negative = *begin == '-';
+            if (*begin == '+' || *begin == '-')
+            {
+                begin++;
+            }
+
+            if (std::basic_string_view<char_t>(begin, end - begin) == TXT("Infinity"))
+            {
+                return negative ? -infinity : infinity;
+            }
+
+            // the literal is checked here, from_chars takes the narrow copy
+            std::string literal;
+            literal.reserve(end - begin);
+            auto current = begin;
+            auto digits = 0;
+            const auto copy_digits = [&]() {
+                auto count = 0;
+                for (; current < end && is_digit(*current); current++, count++)
+                {
+                    literal += static_cast<char>(*current);
+                }
+
+                return count;
+            };
+
+            digits += copy_digits();
+            if (current < end && *current == '.')
+            {
+                literal += '.';
+                current++;
+                digits += copy_digits();
+            }
+
+            if (!digits)
+            {
+                return nan;
+            }
+
+            if (current < end && (*current | 0x20) == 'e')
+            {
+                literal += 'e';
+                current++;
+                if (current < end && (*current == '+' || *current == '-'))
+                {
+                    literal += static_cast<char>(*current++);
+                }
+
+                if (!copy_digits())
+                {
+                    return nan;
+                }
+            }
+
+            if (current != end)
+            {
+                return nan;
+            }
+
+            double result = 0;
+            if (std::from_chars(literal.data(), literal.data() + literal.size(), result).ec == std::errc::result_out_of_range)
+            {
+                // overflow to infinity, underflow to zero
+                result = std::strtod(literal.c_str(), nullptr);
+            }
+
+            return negative ? -result : result;
+        }
+
+        inline bool is_undefined() const
+        {
+            return get_type() == anyTypeId::undefined_type;
+        }
+
+        inline bool is_null() const
+        {
+            return get_type() == anyTypeId::pointer_type && !mutable_(get<js::pointer_t>());
+        }
+
+        template <typename T>
+        inline const T &get() const
+        {
+            return std::get<T>(_value);
+        }
+
+        template <typename T>
+        inline js::ref<T> get_ptr() const
+        {
+            return js::ref<T>(js::class_cast<T>(std::get<js::ref<js::object>>(_value).get()));
+        }
+
+        template <typename T>
+        inline T &get()
+        {
+            return std::get<T>(_value);
+        }
+
+        template <typename T>
+        inline js::ref<T> get_ptr()
+        {
+            return js::ref<T>(js::class_cast<T>(std::get<js::ref<js::object>>(_value).get()));
+        }
+
+        inline const js::boolean &boolean_ref_const() const
+        {
+            return get<js::boolean>();
+        }
 
         inline js::boolean &boolean_ref()
         {
@@ -2618,14 +4240,14 @@ constexpr const T const_(T t) {
             return get<object>();
         }
 
-        inline const std::shared_ptr<js::object> &class_ref_const() const
+        inline const js::ref<js::object> &class_ref_const() const
         {
-            return get<std::shared_ptr<js::object>>();
+            return get<js::ref<js::object>>();
         }
 
-        inline std::shared_ptr<js::object> &class_ref()
+        inline js::ref<js::object> &class_ref()
         {
-            return get<std::shared_ptr<js::object>>();
+            return get<js::ref<js::object>>();
         }
 
         any &operator=(const any &other)
@@ -2661,6 +4283,7 @@ constexpr const T const_(T t) {
                 }
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2683,6 +4306,7 @@ constexpr const T const_(T t) {
                 }
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2708,16 +4332,19 @@ constexpr const T const_(T t) {
 
         operator js::boolean()
         {
+            JS_COUNT(any_to_boolean);
             if (get_type() == anyTypeId::boolean_type)
             {
                 return boolean_ref();
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
         operator js::number()
         {
+            JS_COUNT(any_to_number);
             if (get_type() == anyTypeId::number_type)
             {
                 return number_ref();
@@ -2725,14 +4352,11 @@ constexpr const T const_(T t) {
 
             if (get_type() == anyTypeId::string_type)
             {
-                char_t *end;
-#ifdef UNICODE
-                return js::number(std::wcstof(string_ref().operator const char_t *(), &end));
-#else
-                return js::number(std::strtof(string_ref().operator const char_t *(), &end));
-#endif
+                JS_COUNT(any_string_to_number);
+                return js::number(string_to_number(string_ref()._value));
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2746,6 +4370,7 @@ constexpr const T const_(T t) {
             }    
         */
 
+            JS_COUNT(any_to_string);
             if (get_type() == anyTypeId::undefined_type)
             {
                 return js::string();
@@ -2758,6 +4383,7 @@ constexpr const T const_(T t) {
 
             if (get_type() == anyTypeId::number_type)
             {
+                JS_COUNT(any_number_to_string);
                 return js::string(number_ref().operator tstring());
             }
 
@@ -2766,6 +4392,7 @@ constexpr const T const_(T t) {
                 return js::string(get<js::pointer_t>());
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2776,6 +4403,7 @@ constexpr const T const_(T t) {
                 return object_ref();
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2786,11 +4414,13 @@ constexpr const T const_(T t) {
                 return array_ref();
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
         operator bool()
         {
+            JS_COUNT(any_to_boolean);
             switch (get_type())
             {
             case anyTypeId::undefined_type:
@@ -2802,13 +4432,15 @@ constexpr const T const_(T t) {
             case anyTypeId::string_type:
                 return string_ref()._value.length() > 0;
             case anyTypeId::object_type:
-                return object_ref()->get().size() > 0;
+                return object_ref();
             case anyTypeId::array_type:
-                return array_ref()->get().size() > 0;
+                return array_ref();
             case anyTypeId::pointer_type:
                 return get<pointer_t>();
+            case anyTypeId::function_type:
+                return static_cast<bool>(get<std::shared_ptr<js::function>>());
             case anyTypeId::class_type:
-                return true;
+                return static_cast<bool>(class_ref_const());
             default:
                 break;
             }
@@ -2820,6 +4452,7 @@ constexpr const T const_(T t) {
         requires ArithmeticOrEnum<N>
         operator N()
         {
+            JS_COUNT(any_to_number);
             switch (get_type())
             {
             case anyTypeId::undefined_type:
@@ -2829,25 +4462,34 @@ constexpr const T const_(T t) {
             case anyTypeId::number_type:
                 return number_ref();
             case anyTypeId::string_type:
-                char_t *end;
-#ifdef UNICODE
-                return static_cast<N>(std::wcstof(string_ref().operator const char_t *(), &end));
-#else
-                return static_cast<N>(std::strtof(string_ref().operator const char_t *(), &end));
-#endif
+            {
+                JS_COUNT(any_string_to_number);
+                const auto parsed = string_to_number(string_ref()._value);
+                if constexpr (std::is_integral_v<N> || std::is_enum_v<N>)
+                {
+                    // NaN has no integer value
+                    return std::isnan(parsed) ? N() : static_cast<N>(parsed);
+                }
+                else
+                {
+                    return static_cast<N>(parsed);
+                }
+            }
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
         template <typename T>
-        operator std::shared_ptr<T>() const
+        operator js::ref<T>() const
         {
             if (get_type() == anyTypeId::class_type)
             {
-                return std::dynamic_pointer_cast<T>(std::get<std::shared_ptr<js::object>>(_value));
+                return get_ptr<T>();
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2861,6 +4503,7 @@ constexpr const T const_(T t) {
                                                   { return func->invoke({args...}); });
             }
 
+            JS_COUNT(any_wrong_type);
             throw "wrong type";
         }
 
@@ -2871,6 +4514,7 @@ constexpr const T const_(T t) {
             return streamObj2.str();
         }
 
+        // strict equality (===)
         bool operator==(const js::any &other) const
         {
             if (get_type() != other.get_type())
@@ -2884,15 +4528,49 @@ constexpr const T const_(T t) {
                 return true;
             case anyTypeId::boolean_type:
                 return boolean_ref_const() == mutable_(other).boolean_ref_const();
+            case anyTypeId::pointer_type:
+                return get<js::pointer_t>()._ptr == other.get<js::pointer_t>()._ptr;
             case anyTypeId::number_type:
-                return number_ref_const() == mutable_(other).number_ref_const();
+                return number_ref_const()._value == other.number_ref_const()._value;
             case anyTypeId::string_type:
                 return string_ref_const() == mutable_(other).string_ref_const();
+            case anyTypeId::array_type:
+                return array_ref_const().same_store(other.array_ref_const());
             case anyTypeId::object_type:
-                return object_ref_const() == mutable_(other).object_ref_const();
+                return object_ref_const().same_store(other.object_ref_const());
+            case anyTypeId::function_type:
+                return get<std::shared_ptr<js::function>>() == other.get<std::shared_ptr<js::function>>();
+            case anyTypeId::class_type:
+                return class_ref_const().get() == other.class_ref_const().get();
             }
 
-            throw "not implemented";
+            return false;
+        }
+
+        // abstract equality (==), objects are not converted to primitives
+        bool loose_equals(const js::any &other) const
+        {
+            const auto isNullish = is_undefined() || is_null();
+            const auto otherIsNullish = other.is_undefined() || other.is_null();
+            if (isNullish || otherIsNullish)
+            {
+                return isNullish && otherIsNullish;
+            }
+
+            switch (pair_with(other))
+            {
+            case pair_of(anyTypeId::number_type, anyTypeId::string_type):
+            case pair_of(anyTypeId::string_type, anyTypeId::number_type):
+            case pair_of(anyTypeId::boolean_type, anyTypeId::number_type):
+            case pair_of(anyTypeId::number_type, anyTypeId::boolean_type):
+            case pair_of(anyTypeId::boolean_type, anyTypeId::string_type):
+            case pair_of(anyTypeId::string_type, anyTypeId::boolean_type):
+                return to_number() == other.to_number();
+            default:
+                break;
+            }
+
+            return *this == other;
         }
 
         bool operator!=(const js::any &other) const
@@ -2968,54 +4646,58 @@ constexpr const T const_(T t) {
             return !operator==(nullptr);
         }        
 
+        // strict equality (===) with a static operand: other types are never equal and nothing is converted, == goes
+        // through equals() and loose_equals()
         bool operator==(const js::boolean &other) const
         {
-            return static_cast<js::boolean>(*mutable_(this)) == other;
+            return get_type() == anyTypeId::boolean_type && boolean_ref_const() == other;
         }
 
         bool operator!=(const js::boolean &other) const
         {
-            return static_cast<js::boolean>(*mutable_(this)) != other;
+            return !operator==(other);
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         bool operator==(const N &n) const
         {
-            return static_cast<js::number>(*mutable_(this)) == n;
+            return get_type() == anyTypeId::number_type && number_ref_const() == n;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend bool operator==(const N &n, const any &val)
         {
-            return n == static_cast<js::number>(mutable_(val));
+            return val.operator==(n);
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         bool operator!=(const N &n) const
         {
-            return static_cast<js::number>(*mutable_(this)) != n;
+            return !operator==(n);
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend bool operator!=(const N &n, const any &val)
         {
-            return n != static_cast<js::number>(mutable_(val));
+            return !val.operator==(n);
         }
 
         bool operator==(const js::string &other) const
         {
-            return static_cast<js::string>(*mutable_(this)) == other;
+            return get_type() == anyTypeId::string_type && string_ref_const() == other;
         }
 
         bool operator!=(const js::string &other) const
         {
-            return static_cast<js::string>(*mutable_(this)) != other;
+            return !operator==(other);
         }
 
+        // any x static number: numbers take the fast path, strings concatenate, every other type is converted by
+        // ToNumber as in any x any
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any operator+(N n)
@@ -3024,22 +4706,30 @@ constexpr const T const_(T t) {
             {
             case anyTypeId::number_type:
                 return number_ref() + n;
+            case anyTypeId::string_type:
+                return any(string_ref() + js::number(n).operator js::string());
+            default:
+                break;
             }
 
-            throw "not implemented";
+            return js::number(to_number()) + n;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
-        friend N operator+(N n, const any &val)
+        friend any operator+(N n, const any &val)
         {
             switch (val.get_type())
             {
             case anyTypeId::number_type:
-                return n + mutable_(val).number_ref();
+                return js::number(n) + val.number_ref_const();
+            case anyTypeId::string_type:
+                return any(js::number(n).operator js::string() + val.string_ref_const());
+            default:
+                break;
             }
 
-            throw "not implemented";
+            return js::number(n) + js::number(val.to_number());
         }
 
         any operator+(string s)
@@ -3050,9 +4740,21 @@ constexpr const T const_(T t) {
                 return number_ref().operator js::string() + s;
             case anyTypeId::string_type:
                 return any(string_ref() + s);
+            default:
+                break;
             }
 
-            throw "not implemented";
+            return any(js::string(operator tstring()) + s);
+        }
+
+        friend any operator+(const string &s, const any &val)
+        {
+            if (val.get_type() == anyTypeId::string_type)
+            {
+                return any(s + val.string_ref_const());
+            }
+
+            return any(s + js::string(mutable_(val).operator tstring()));
         }
 
         inline any operator+(any t) const
@@ -3062,455 +4764,313 @@ constexpr const T const_(T t) {
 
         any operator+(any t)
         {
-            switch (get_type())
+            switch (pair_with(t))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return number_ref() + t.number_ref();
-                case anyTypeId::string_type:
-                    return number_ref().operator js::string() + t.string_ref();
-                }
-                break;
-            case anyTypeId::string_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::string_type:
-                    return string_ref() + t.string_ref();
-                }
+            case pair_of(anyTypeId::number_type, anyTypeId::number_type):
+                return number_ref() + t.number_ref();
+            case pair_of(anyTypeId::string_type, anyTypeId::string_type):
+                return string_ref() + t.string_ref();
+            case pair_of(anyTypeId::number_type, anyTypeId::string_type):
+                return number_ref().operator js::string() + t.string_ref();
+            default:
                 break;
             }
 
-            throw "not implemented";
+            // string concatenation if any side is string, numeric addition otherwise
+            if (get_type() == anyTypeId::string_type || t.get_type() == anyTypeId::string_type)
+            {
+                return js::string(operator tstring()) + js::string(t.operator tstring());
+            }
+
+            return js::number(to_number() + t.to_number());
         }
 
         any &operator++()
         {
-            switch (get_type())
+            if (get_type() == anyTypeId::number_type)
             {
-            case anyTypeId::number_type:
                 number_ref()++;
                 return *this;
             }
 
-            throw "not implemented";
+            _value = js::number(to_number() + 1);
+            return *this;
         }
 
         any operator++(int)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                any tmp(number_ref());
-                operator++();
-                return tmp;
-            }
-
-            throw "not implemented";
+            any tmp = js::number(to_number());
+            operator++();
+            return tmp;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any &operator+=(N n)
         {
-            switch (get_type())
+            if (get_type() == anyTypeId::number_type)
             {
-            case anyTypeId::number_type:
                 number_ref() += n;
                 return *this;
             }
 
-            throw "not implemented";
+            *this = operator+(n);
+            return *this;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend N operator+=(N &n, any value)
         {
-            switch (value.get_type())
-            {
-            case anyTypeId::number_type:
-                return n += value.number_ref();
-            }
-
-            throw "not implemented";
+            return n += static_cast<N>(value.to_number());
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any operator-(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return number_ref() - n;
-            }
-
-            throw "not implemented";
+            return js::number(to_number()) - n;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend N operator-(N n, const any &val)
         {
-            switch (val.get_type())
-            {
-            case anyTypeId::number_type:
-                return n - mutable_(val).number_ref();
-            }
-
-            throw "not implemented";
+            return n - static_cast<N>(val.to_number());
         }
 
         any operator-(any t)
         {
-            switch (get_type())
+            if (pair_with(t) == pair_of(anyTypeId::number_type, anyTypeId::number_type))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return number_ref() - t.number_ref();
-                }
-                break;
+                return number_ref() - t.number_ref();
             }
 
-            throw "not implemented";
+            return js::number(to_number() - t.to_number());
         }
 
         any &operator--()
         {
-            switch (get_type())
+            if (get_type() == anyTypeId::number_type)
             {
-            case anyTypeId::number_type:
                 number_ref() -= 1;
                 return *this;
             }
 
-            throw "not implemented";
+            _value = js::number(to_number() - 1);
+            return *this;
         }
 
         any operator--(int)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                any tmp(number_ref());
-                operator--();
-                return tmp;
-            }
-
-            throw "not implemented";
+            any tmp = js::number(to_number());
+            operator--();
+            return tmp;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any &operator-=(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                number_ref() -= n;
-                return *this;
-            }
-
-            throw "not implemented";
+            _value = js::number(to_number()) - n;
+            return *this;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend N operator-=(N &n, any value)
         {
-            switch (value.get_type())
-            {
-            case anyTypeId::number_type:
-                return n -= value.number_ref();
-            }
-
-            throw "not implemented";
+            return n -= static_cast<N>(value.to_number());
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any operator*(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return any(number_ref() * n);
-            }
-
-            throw "not implemented";
+            return any(js::number(to_number()) * n);
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend N operator*(N n, const any &val)
         {
-            switch (val.get_type())
-            {
-            case anyTypeId::number_type:
-                return n * mutable_(val).number_ref();
-            }
-
-            throw "not implemented";
+            return n * static_cast<N>(val.to_number());
         }
 
         any operator*(any t)
         {
-            switch (get_type())
+            if (pair_with(t) == pair_of(anyTypeId::number_type, anyTypeId::number_type))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() * t.number_ref());
-                }
-                break;
+                return any(number_ref() * t.number_ref());
             }
 
-            throw "not implemented";
+            return js::number(to_number() * t.to_number());
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any &operator*=(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                number_ref() *= n;
-                return *this;
-            }
-
-            throw "not implemented";
+            _value = js::number(to_number()) * n;
+            return *this;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any operator/(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return any(number_ref() / n);
-            }
-
-            throw "not implemented";
+            return any(js::number(to_number()) / n);
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend N operator/(N n, const any &val)
         {
-            switch (val.get_type())
-            {
-            case anyTypeId::number_type:
-                return n / mutable_(val).number_ref();
-            }
-
-            throw "not implemented";
+            return n / static_cast<N>(val.to_number());
         }
 
         any operator/(any t)
         {
-            switch (get_type())
+            if (pair_with(t) == pair_of(anyTypeId::number_type, anyTypeId::number_type))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() / t.number_ref());
-                }
-                break;
+                return any(number_ref() / t.number_ref());
             }
 
-            throw "not implemented";
+            return js::number(to_number() / t.to_number());
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any &operator/=(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                number_ref() /= n;
-                return *this;
-            }
-
-            throw "not implemented";
+            _value = js::number(to_number()) / n;
+            return *this;
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any operator%(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return any(number_ref() % n);
-            }
-
-            throw "not implemented";
+            return any(js::number(to_number()) % n);
         }
 
         any operator%(any t)
         {
-            switch (get_type())
+            if (pair_with(t) == pair_of(anyTypeId::number_type, anyTypeId::number_type))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() % t.number_ref());
-                }
-                break;
+                return any(number_ref() % t.number_ref());
             }
 
-            throw "not implemented";
+            return any(js::number(to_number()) % js::number(t.to_number()));
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         friend any operator%(N n, any value)
         {
-            switch (value.get_type())
-            {
-            case anyTypeId::number_type:
-                return any(n % value.number_ref());
-            }
-
-            throw "not implemented";
+            return any(n % js::number(value.to_number()));
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
             any &operator%=(N other)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                number_ref() %= other;
-                return *this;
-            }
-
-            throw "not implemented";
+            _value = js::number(to_number()) % other;
+            return *this;
         }
 
+        // any x static number compares numbers, a string or any other type is converted by ToNumber (NaN compares
+        // false); strings compare by code units only with another string
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         bool operator>(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return number_ref() > n;
-            }
-
-            throw "not implemented";
+            return to_number() > js::number(n)._value;
         }
 
         any operator>(any t)
         {
-            switch (get_type())
+            switch (pair_with(t))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() > t.number_ref());
-                }
+            case pair_of(anyTypeId::number_type, anyTypeId::number_type):
+                return any(number_ref() > t.number_ref());
+            case pair_of(anyTypeId::string_type, anyTypeId::string_type):
+                return any(js::boolean(string_ref()._value > t.string_ref()._value));
+            default:
                 break;
             }
 
-            throw "not implemented";
+            // NaN compares false
+            return any(js::boolean(to_number() > t.to_number()));
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         bool operator>=(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return number_ref() >= n;
-            }
-
-            throw "not implemented";
+            return to_number() >= js::number(n)._value;
         }
 
         any operator>=(any t)
         {
-            switch (get_type())
+            switch (pair_with(t))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() >= t.number_ref());
-                }
+            case pair_of(anyTypeId::number_type, anyTypeId::number_type):
+                return any(number_ref() >= t.number_ref());
+            case pair_of(anyTypeId::string_type, anyTypeId::string_type):
+                return any(js::boolean(string_ref()._value >= t.string_ref()._value));
+            default:
                 break;
             }
 
-            throw "not implemented";
+            // NaN compares false
+            return any(js::boolean(to_number() >= t.to_number()));
         }
 
         template <typename N = void>
         requires ArithmeticOrEnumOrNumber<N>
         bool operator<(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return number_ref() < n;
-            }
-
-            throw "not implemented";
+            return to_number() < js::number(n)._value;
         }
 
         any operator<(any t)
         {
-            switch (get_type())
+            switch (pair_with(t))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() < t.number_ref());
-                }
+            case pair_of(anyTypeId::number_type, anyTypeId::number_type):
+                return any(number_ref() < t.number_ref());
+            case pair_of(anyTypeId::string_type, anyTypeId::string_type):
+                return any(js::boolean(string_ref()._value < t.string_ref()._value));
+            default:
                 break;
             }
 
-            throw "not implemented";
+            // NaN compares false
+            return any(js::boolean(to_number() < t.to_number()));
         }
 
-        bool operator<=(js::number n)
+        template <typename N = void>
+        requires ArithmeticOrEnumOrNumber<N>
+        bool operator<=(N n)
         {
-            switch (get_type())
-            {
-            case anyTypeId::number_type:
-                return number_ref() <= n;
-            }
-
-            throw "not implemented";
+            return to_number() <= js::number(n)._value;
         }
 
         any operator<=(any t)
         {
-            switch (get_type())
+            switch (pair_with(t))
             {
-            case anyTypeId::number_type:
-                switch (t.get_type())
-                {
-                case anyTypeId::number_type:
-                    return any(number_ref() <= t.number_ref());
-                }
+            case pair_of(anyTypeId::number_type, anyTypeId::number_type):
+                return any(number_ref() <= t.number_ref());
+            case pair_of(anyTypeId::string_type, anyTypeId::string_type):
+                return any(js::boolean(string_ref()._value <= t.string_ref()._value));
+            default:
                 break;
             }
 
-            throw "not implemented";
+            // NaN compares false
+            return any(js::boolean(to_number() <= t.to_number()));
         }
 
         template <typename... Args>
@@ -3573,6 +5133,7 @@ constexpr const T const_(T t) {
                 break;
 
             default:
+                JS_COUNT(any_wrong_type);
                 throw "wrong type";
             }
         }
@@ -3586,6 +5147,7 @@ constexpr const T const_(T t) {
             case anyTypeId::array_type:
                 return array_ref().get_length();
             default:
+                JS_COUNT(any_wrong_type);
                 throw "wrong type";
             }
         }
@@ -3597,6 +5159,7 @@ constexpr const T const_(T t) {
             case anyTypeId::array_type:
                 return array_ref().begin();
             default:
+                JS_COUNT(any_wrong_type);
                 throw "wrong type";
             }
         }
@@ -3608,6 +5171,7 @@ constexpr const T const_(T t) {
             case anyTypeId::array_type:
                 return array_ref().end();
             default:
+                JS_COUNT(any_wrong_type);
                 throw "wrong type";
             }
         }
@@ -3679,6 +5243,21 @@ constexpr const T const_(T t) {
         }
     };
 
+    // strict equality (===) of a switch value and a case: operands of different types are never equal, an any is
+    // compared by its tag and nothing is converted, so a mismatch can't throw
+    template <typename L, typename R>
+    constexpr bool strict_equals(const L &l, const R &r)
+    {
+        if constexpr (ArithmeticOrEnum<L> && ArithmeticOrEnum<R> || std::is_same_v<L, R>)
+        {
+            return l == r;
+        }
+        else
+        {
+            return any(l) == any(r);
+        }
+    }
+
     template <typename... Args>
     auto function::operator()(Args... args)
     {
@@ -3688,6 +5267,7 @@ constexpr const T const_(T t) {
     template <typename F, typename _MethodType>
     any function_t<F, _MethodType>::invoke(std::initializer_list<any> args_)
     {
+        JS_COUNT(function_invoke);
         auto args_vector = std::vector<any>(args_);
         if constexpr (std::is_void_v<_ReturnType>)
         {
@@ -3711,33 +5291,36 @@ constexpr const T const_(T t) {
     {
         using shared_type = shared<T>;
 
-        std::shared_ptr<T> _value;
+        ref<ref_box<T>> _value;
 
-        shared(T t) : _value(std::make_shared<T>(t)) {}
-        shared(std::shared_ptr<T> t) : _value(t) {}
+        shared(T t) : _value(new_<ref_box<T>>(t))
+        {
+            JS_COUNT(shared_alloc);
+        }
 
         template <typename V>
         shared_type &operator=(const V &v)
         {
-            *_value = mutable_(v);
+            _value->value = mutable_(v);
             return *this;
         }
 
         T &operator*() const
         {
-            return *_value.get();
+            return _value->value;
         }
 
-        operator T() { return *_value.get(); }
+        operator T() { return _value->value; }
 
         // todo: memory leak here, improve it using any(shared_t<value> s)
-        operator any() { return *_value.get(); }
+        operator any() { return _value->value; }
 
-        T &get() const { return *_value.get(); }
+        T &get() const { return _value->value; }
 
-        T *operator->() const
+        // returns the boxed value itself so that -> keeps chaining into values like ref<T>, array<T> or object
+        T &operator->() const
         {
-            return _value.get();
+            return _value->value;
         }
 
         template <class Tv>
@@ -3948,6 +5531,158 @@ constexpr const T const_(T t) {
     // typedefs
     typedef std::unordered_map<any, int, any::any_hash, any::any_equal_to> switch_type;
 
+    // perfect hash over string labels of switch, built at compile time by "hash and displace":
+    // labels are split into buckets by first hash, each bucket gets displacement which puts all
+    // its labels into free slots. Falls back to linear compare if labels repeat or no displacement found
+    template <size_t N>
+    struct string_switch
+    {
+        using view_type = std::basic_string_view<char_t>;
+
+        static constexpr size_t table_size = std::bit_ceil(N * 2);
+        static constexpr size_t max_displacement = 4096;
+
+        view_type _labels[N];
+        size_t _displacements[N];
+        size_t _slots[table_size];
+        bool _linear;
+
+        template <size_t... M>
+        requires(sizeof...(M) == N)
+        consteval string_switch(const char_t (&...labels)[M]) : _labels{view_type(labels, M - 1)...}, _displacements{}, _slots{}, _linear(false)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                for (size_t j = 0; j < i; j++)
+                {
+                    if (_labels[i] == _labels[j])
+                    {
+                        _linear = true;
+                        return;
+                    }
+                }
+            }
+
+            // place biggest buckets first
+            size_t bucket_sizes[N] = {};
+            for (size_t i = 0; i < N; i++)
+            {
+                bucket_sizes[hash(_labels[i], 0) % N]++;
+            }
+
+            for (size_t placed = 0; placed < N;)
+            {
+                size_t bucket = 0;
+                for (size_t b = 1; b < N; b++)
+                {
+                    if (bucket_sizes[b] > bucket_sizes[bucket])
+                    {
+                        bucket = b;
+                    }
+                }
+
+                if (!place(bucket))
+                {
+                    _linear = true;
+                    return;
+                }
+
+                placed += bucket_sizes[bucket];
+                bucket_sizes[bucket] = 0;
+            }
+        }
+
+        static constexpr size_t hash(view_type value, size_t seed)
+        {
+            // FNV-1a
+            size_t h = static_cast<size_t>(14695981039346656037ull) ^ (seed * 0x9e3779b97f4a7c15ull) ^ value.size();
+            for (auto c : value)
+            {
+                h ^= static_cast<size_t>(c);
+                h *= static_cast<size_t>(1099511628211ull);
+            }
+
+            return h ^ (h >> 29);
+        }
+
+        // returns 1-based index of matched label or 0
+        constexpr size_t index(view_type value) const
+        {
+            if (_linear)
+            {
+                for (size_t i = 0; i < N; i++)
+                {
+                    if (_labels[i] == value)
+                    {
+                        return i + 1;
+                    }
+                }
+
+                return 0;
+            }
+
+            auto slot = _slots[hash(value, _displacements[hash(value, 0) % N]) & (table_size - 1)];
+            return slot != 0 && _labels[slot - 1] == value ? slot : 0;
+        }
+
+        size_t index(const js::string &value) const
+        {
+            return value._control == js::string::string_defined ? index(view_type(value._value)) : 0;
+        }
+
+        size_t index(const any &value) const
+        {
+            return value.get_type() == any::string_type ? index(value.string_ref_const()) : 0;
+        }
+
+    private:
+        constexpr bool place(size_t bucket)
+        {
+            for (size_t displacement = 1; displacement < max_displacement; displacement++)
+            {
+                size_t taken[N] = {};
+                size_t count = 0;
+                bool fits = true;
+                for (size_t i = 0; i < N && fits; i++)
+                {
+                    if (hash(_labels[i], 0) % N != bucket)
+                    {
+                        continue;
+                    }
+
+                    auto slot = hash(_labels[i], displacement) & (table_size - 1);
+                    fits = _slots[slot] == 0;
+                    for (size_t t = 0; t < count && fits; t++)
+                    {
+                        fits = taken[t] != slot;
+                    }
+
+                    taken[count++] = slot;
+                }
+
+                if (fits)
+                {
+                    _displacements[bucket] = displacement;
+                    count = 0;
+                    for (size_t i = 0; i < N; i++)
+                    {
+                        if (hash(_labels[i], 0) % N == bucket)
+                        {
+                            _slots[taken[count++]] = i + 1;
+                        }
+                    }
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    };
+
+    template <size_t... M>
+    string_switch(const char_t (&...labels)[M]) -> string_switch<sizeof...(M)>;
+
     // Number
     static js::number Infinity(std::numeric_limits<double>::infinity());
     static js::number NaN(std::numeric_limits<double>::quiet_NaN());
@@ -3995,46 +5730,56 @@ constexpr const T const_(T t) {
 
         // Object
         template <typename K, typename V>
-        object<K, V>::object() : _values(object<K, V>::object_traits<object<K, V>::object_type>::create()), isUndefined(false)
+        object<K, V>::object()
         {
+            JS_STAT(stores_deferred);
         }
 
         template <typename K, typename V>
-        object<K, V>::object(const object &value) : _values(value._values), isUndefined(value.isUndefined)
+        object<K, V>::object(const object &value) : _values(value.shared_store())
         {
         }
 
         template <typename K, typename V>
-        object<K, V>::object(std::initializer_list<pair> values) : _values(object<K, V>::object_traits<object<K, V>::object_type>::create(values)), isUndefined(false)
+        object<K, V>::object(std::initializer_list<pair> values)
+            : _values(values.size() > 0 ? object<K, V>::object_traits<object<K, V>::object_type>::create() : nullptr)
         {
-            auto &ref = get();
-            for (auto &item : values)
+            if (values.size() == 0)
             {
-                ref[item.first] = item.second;
+                JS_STAT(stores_deferred);
+                return;
             }
+
+            insert_values(values);
+        }
+
+        template <typename K, typename V>
+        object<K, V>::object(const object_type &store, std::initializer_list<pair> values) : _values(store)
+        {
+            insert_values(values);
         }
 
         template <typename K, typename V>
-        object<K, V>::object(const undefined_t &) : _values(object<K, V>::object_traits<object<K, V>::object_type>::create()), isUndefined(true)
+        object<K, V>::object(const undefined_t &) : _values(ref_of(&undefined_store))
         {
         }
 
         template <typename K, typename V>
-        ObjectKeys<js::string, typename object<K, V>::object_type_base> object<K, V>::keys(const object<K, V> &obj)
+        ObjectKeys<js::string, typename object<K, V>::object_type> object<K, V>::keys(const object<K, V> &obj)
         {
-            return ObjectKeys<js::string, object<K, V>::object_type_base>(obj->get());
+            return ObjectKeys<js::string, typename object<K, V>::object_type>(obj._values);
         }
 
         template <typename K, typename V>
-        ObjectKeys<js::string, typename object<K, V>::object_type_base> object<K, V>::keys()
+        ObjectKeys<js::string, typename object<K, V>::object_type> object<K, V>::keys()
         {
-            return ObjectKeys<js::string, object<K, V>::object_type_base>(get());
+            return ObjectKeys<js::string, typename object<K, V>::object_type>(_values);
         }
 
         template <typename K, typename V>
         any &object<K, V>::operator[](js::number n) const
         {
-            return mutable_(get())[static_cast<std::string>(n)];
+            return mutable_(*this)[n];
         }
 
         template <typename K, typename V>
@@ -4046,19 +5791,19 @@ constexpr const T const_(T t) {
         template <typename K, typename V>
         any &object<K, V>::operator[](const char_t *s) const
         {
-            return mutable_(get())[std::string(s)];
+            return mutable_(*this)[s];
         }
 
         template <typename K, typename V>
         any &object<K, V>::operator[](std::string s) const
         {
-            return mutable_(get())[s];
+            return mutable_(*this)[s];
         }
 
         template <typename K, typename V>
         any &object<K, V>::operator[](js::string s) const
         {
-            return mutable_(get())[(std::string)s];
+            return mutable_(*this)[s];
         }
 
         template <typename K, typename V>
@@ -4195,6 +5940,134 @@ constexpr const T const_(T t) {
 
     }; // namespace Utils
 
+#ifndef JS_TYPE_PROFILE_FILE
+#define JS_TYPE_PROFILE_FILE "typescript2cxx.profile"
+#endif
+
+    // type feedback: code compiled with -profile_generate counts the types operands typed any have at each source
+    // location and appends the counts to JS_TYPE_PROFILE_FILE at exit; -profile_use gives operators whose operands
+    // were numbers a number fast path guarded by a type check, everything else takes the generic any operator
+    namespace type_feedback
+    {
+        struct site
+        {
+            const char *location;
+            std::atomic<std::uint64_t> counts[any::class_type + 1];
+        };
+
+        struct profile_t
+        {
+            std::mutex lock;
+            // deque keeps sites in place, the code holds references to them
+            std::deque<site> sites;
+
+            site &add(const char *location)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                auto &added = sites.emplace_back();
+                added.location = location;
+                return added;
+            }
+
+            ~profile_t()
+            {
+                static constexpr const char *type_names[] = {
+                    "undefined", "boolean", "null", "number", "string", "array", "object", "function", "class"};
+
+                std::ofstream file(JS_TYPE_PROFILE_FILE, std::ios::app);
+                for (auto &item : sites)
+                {
+                    for (auto type = 0; type <= any::class_type; type++)
+                    {
+                        const auto count = item.counts[type].load(std::memory_order_relaxed);
+                        if (count > 0)
+                        {
+                            file << item.location << '\t' << type_names[type] << '\t' << count << '\n';
+                        }
+                    }
+                }
+            }
+        };
+
+        inline profile_t &profile()
+        {
+            static profile_t instance;
+            return instance;
+        }
+
+        template <typename T>
+        inline T &&observe(site &at, T &&value)
+        {
+            if constexpr (std::is_same_v<std::decay_t<T>, any>)
+            {
+                at.counts[value.get_type()].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return std::forward<T>(value);
+        }
+
+        template <typename T>
+        inline bool is_number(const T &value)
+        {
+            if constexpr (std::is_same_v<T, any>)
+            {
+                return value.get_type() == any::number_type;
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        template <typename T>
+        inline double number_value(const T &value)
+        {
+            if constexpr (std::is_same_v<T, any>)
+            {
+                return value.number_ref_const()._value;
+            }
+            else if constexpr (std::is_arithmetic_v<T>)
+            {
+                return static_cast<double>(value);
+            }
+            else
+            {
+                return value._value;
+            }
+        }
+
+        // Op(left, right) of std::plus<> and the like on doubles when both are numbers, the operator of the
+        // operands otherwise; the result has the type the operator of the operands gives
+        template <typename Op, typename L, typename R>
+        inline auto numbers(L &&left, R &&right) -> decltype(Op()(left, right))
+        {
+            using result_t = decltype(Op()(left, right));
+            if (is_number(left) && is_number(right))
+            {
+                const auto value = Op()(number_value(left), number_value(right));
+                if constexpr (std::is_same_v<std::remove_const_t<decltype(value)>, bool>)
+                {
+                    return result_t(js::boolean(value));
+                }
+                else
+                {
+                    return result_t(js::number(value));
+                }
+            }
+
+            return Op()(left, right);
+        }
+    } // namespace type_feedback
+
+// a counter per location, created the first time the code there runs
+#define JS_OBSERVE(location, ...)                                                  \
+    js::type_feedback::observe(                                                    \
+        []() -> js::type_feedback::site & {                                        \
+            static auto &at = js::type_feedback::profile().add(location);          \
+            return at;                                                             \
+        }(),                                                                       \
+        __VA_ARGS__)
+
     template <typename V, class Ax = void>
     requires has_exists_member<Ax>
     constexpr bool in(V v, const Ax &a)
@@ -4217,12 +6090,16 @@ constexpr const T const_(T t) {
 
 } // namespace js
 
-#ifdef UNICODE
+#if defined(JS_NO_MAIN)
+// the program's Main() is called by a host, e.g. the benchmark harness bench/macro_main.cpp
+#define MAIN
+#elif defined(UNICODE)
 #define MAIN                                                             \
     int wmain(int argc, char_t **argv)                                   \
     {                                                                    \
         try                                                              \
         {                                                                \
+            js::utils::finally flush([] { js::console->flush(); });      \
             Main();                                                      \
         }                                                                \
         catch (const js::string &s)                                      \
@@ -4257,6 +6134,7 @@ constexpr const T const_(T t) {
     {                                                                    \
         try                                                              \
         {                                                                \
+            js::utils::finally flush([] { js::console->flush(); });      \
             Main();                                                      \
         }                                                                \
         catch (const js::string &s)                                      \
@@ -4331,7 +6209,7 @@ namespace js
     template <typename T>
     using Array = tmpl::array<T>;
 
-    struct Date
+    struct Date : public ref_counted
     {
         number getHours()
         {
@@ -4353,7 +6231,7 @@ namespace js
 
     typedef any Function;
 
-    struct RegExp
+    struct RegExp : public ref_counted
     {
 
 #ifdef UNICODE
@@ -4384,12 +6262,12 @@ namespace js
     };
 
     template <typename T>
-    struct TypedArray : public Array<T>
+    struct TypedArray : public Array<T>, public ref_counted
     {
         typedef Array<T> super__;
         js::number _length;
 
-        TypedArray(js::number length_) : super__()
+        TypedArray(js::number length_) : super__(std::vector<T>(static_cast<std::size_t>(length_._value)))
         {
             _length = length_;
         }
@@ -4451,7 +6329,7 @@ namespace js
         }
     };
 
-    struct ArrayBuffer
+    struct ArrayBuffer : public ref_counted
     {
     };
 
@@ -4460,182 +6338,3349 @@ namespace js
     };
 
     template <typename T>
-    struct Promise
+    struct Promise : public ref_counted
+    {
+        static void all()
+        {
+        }
+
+        void _catch()
+        {
+        }
+
+        void finally()
+        {
+        }
+
+        void then()
+        {
+        }
+
+        static void race()
+        {
+        }
+
+        static void reject()
+        {
+        }
+
+        static void resolve()
+        {
+        }
+    };
+
+    namespace collections
+    {
+        // SameValueZero of Map and Set keys: NaN is equal to itself, -0 to 0, reference values compare by identity
+        template <typename T>
+        struct same_value_zero
+        {
+            static std::size_t hash(const T &value)
+            {
+                return std::hash<T>{}(value);
+            }
+
+            static bool equals(const T &value, const T &other)
+            {
+                return value == other;
+            }
+        };
+
+        template <>
+        struct same_value_zero<js::number>
+        {
+            static std::size_t hash(const js::number &value)
+            {
+                auto bits = std::uint64_t{0x7FF8000000000000};
+                if (!std::isnan(value._value))
+                {
+                    // adding 0.0 turns -0 into 0
+                    const auto normalized = value._value + 0.0;
+                    std::memcpy(&bits, &normalized, sizeof(bits));
+                }
+
+                return static_cast<std::size_t>(bits ^ bits >> 32);
+            }
+
+            static bool equals(const js::number &value, const js::number &other)
+            {
+                return value._value == other._value || std::isnan(value._value) && std::isnan(other._value);
+            }
+        };
+
+        template <>
+        struct same_value_zero<js::string>
+        {
+            static std::size_t hash(const js::string &value)
+            {
+                return value._control == js::string::string_defined ? value.hash() : static_cast<std::size_t>(value._control);
+            }
+
+            static bool equals(const js::string &value, const js::string &other)
+            {
+                return value._control == other._control && (value._control != js::string::string_defined || value._value == other._value);
+            }
+        };
+
+        template <>
+        struct same_value_zero<js::boolean>
+        {
+            static std::size_t hash(const js::boolean &value)
+            {
+                return static_cast<std::size_t>(value._control);
+            }
+
+            static bool equals(const js::boolean &value, const js::boolean &other)
+            {
+                return value._control == other._control;
+            }
+        };
+
+        template <typename T>
+        struct same_value_zero<js::ref<T>>
+        {
+            static std::size_t hash(const js::ref<T> &value)
+            {
+                return std::hash<const void *>{}(value.get());
+            }
+
+            static bool equals(const js::ref<T> &value, const js::ref<T> &other)
+            {
+                return value.get() == other.get();
+            }
+        };
+
+        // storage is allocated when a copy of the key is kept, so it identifies the array or object
+        template <typename E>
+        struct same_value_zero<tmpl::array<E>>
+        {
+            static std::size_t hash(const tmpl::array<E> &value)
+            {
+                return std::hash<const void *>{}(value.shared_store().get());
+            }
+
+            static bool equals(const tmpl::array<E> &value, const tmpl::array<E> &other)
+            {
+                return value.shared_store().get() == other.shared_store().get();
+            }
+        };
+
+        template <>
+        struct same_value_zero<js::object>
+        {
+            static std::size_t hash(const js::object &value)
+            {
+                return std::hash<const void *>{}(value.shared_store().get());
+            }
+
+            static bool equals(const js::object &value, const js::object &other)
+            {
+                return value.shared_store().get() == other.shared_store().get();
+            }
+        };
+
+        template <>
+        struct same_value_zero<any>
+        {
+            static std::size_t hash(const any &value)
+            {
+                switch (value.get_type())
+                {
+                case any::number_type:
+                    return same_value_zero<js::number>::hash(value.number_ref_const());
+                case any::string_type:
+                    return same_value_zero<js::string>::hash(value.string_ref_const());
+                case any::array_type:
+                    return same_value_zero<js::array_any>::hash(value.array_ref_const());
+                case any::object_type:
+                    return same_value_zero<js::object>::hash(value.object_ref_const());
+                case any::function_type:
+                    return std::hash<const void *>{}(value.get<std::shared_ptr<js::function>>().get());
+                case any::class_type:
+                    return std::hash<const void *>{}(value.class_ref_const().get());
+                default:
+                    return value.hash();
+                }
+            }
+
+            static bool equals(const any &value, const any &other)
+            {
+                if (value.get_type() != other.get_type())
+                {
+                    return false;
+                }
+
+                switch (value.get_type())
+                {
+                case any::number_type:
+                    return same_value_zero<js::number>::equals(value.number_ref_const(), other.number_ref_const());
+                case any::string_type:
+                    return same_value_zero<js::string>::equals(value.string_ref_const(), other.string_ref_const());
+                case any::array_type:
+                    return same_value_zero<js::array_any>::equals(value.array_ref_const(), other.array_ref_const());
+                case any::object_type:
+                    return same_value_zero<js::object>::equals(value.object_ref_const(), other.object_ref_const());
+                default:
+                    return value == other;
+                }
+            }
+        };
+
+        // value of Set entries
+        struct none
+        {
+        };
+
+        // one control byte per index slot: empty, deleted or the low 7 bits of the hash of an occupied slot
+        enum control : std::int8_t
+        {
+            control_empty = -128,
+            control_deleted = -2
+        };
+
+        // 16 control bytes compared at once, bit i of a mask is set when byte i matches
+        struct group
+        {
+            static constexpr std::size_t width = 16;
+
+#ifdef JS_SSE2
+            __m128i _control;
+
+            explicit group(const std::int8_t *position) : _control(_mm_loadu_si128(reinterpret_cast<const __m128i *>(position)))
+            {
+            }
+
+            inline std::uint32_t match(std::int8_t h2) const
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _control)));
+            }
+
+            // empty and deleted both have the sign bit set, occupied slots never do
+            inline std::uint32_t match_free() const
+            {
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(_control));
+            }
+#else
+            const std::int8_t *_control;
+
+            explicit group(const std::int8_t *position) : _control(position)
+            {
+            }
+
+            inline std::uint32_t match(std::int8_t h2) const
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; i++)
+                {
+                    mask |= static_cast<std::uint32_t>(_control[i] == h2) << i;
+                }
+
+                return mask;
+            }
+
+            inline std::uint32_t match_free() const
+            {
+                std::uint32_t mask = 0;
+                for (std::size_t i = 0; i < width; i++)
+                {
+                    mask |= static_cast<std::uint32_t>(_control[i] < 0) << i;
+                }
+
+                return mask;
+            }
+#endif
+
+            inline std::uint32_t match_empty() const
+            {
+                return match(control_empty);
+            }
+        };
+
+        inline std::size_t lowest_bit(std::uint32_t mask)
+        {
+            return static_cast<std::size_t>(std::countr_zero(mask));
+        }
+
+        // open addressing index over entries kept in insertion order (Map and Set iteration order); entries live in
+        // blocks which never move, so a loop variable stays valid when the loop body adds entries. Removed entries
+        // are holes until the entries are compacted, which is deferred while anything iterates them
+        template <typename K, typename V>
+        struct ordered_table
+        {
+            using entry = std::pair<K, V>;
+            using key_traits = same_value_zero<K>;
+
+            struct record
+            {
+                entry value;
+                bool removed;
+            };
+
+            static constexpr std::size_t min_capacity = group::width;
+
+            // capacity + group::width bytes, the tail repeats the first group so a group can be loaded at any slot
+            std::vector<std::int8_t> _control;
+            // entry index of every occupied slot
+            std::vector<std::uint32_t> _slots;
+            std::deque<record> _entries;
+            std::size_t _size = 0;
+            // slots which can still be taken before the index is rebuilt, keeps the load under 7/8
+            std::size_t _growth_left = 0;
+            // live iterators and forEach calls, entries are not moved while it is not 0
+            mutable std::size_t _iterating = 0;
+
+            static inline std::size_t mix(std::size_t hash)
+            {
+                auto mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+                return static_cast<std::size_t>(mixed ^ mixed >> 32);
+            }
+
+            inline std::size_t capacity() const
+            {
+                return _slots.size();
+            }
+
+            inline void set_control(std::size_t slot, std::int8_t value)
+            {
+                _control[slot] = value;
+                if (slot < group::width)
+                {
+                    _control[capacity() + slot] = value;
+                }
+            }
+
+            // slot holding the key, or capacity() when there is none
+            std::size_t find_slot(const K &key, std::size_t hash) const
+            {
+                if (_size == 0)
+                {
+                    return capacity();
+                }
+
+                const auto mask = capacity() - 1;
+                const auto h2 = static_cast<std::int8_t>(hash & 0x7F);
+                auto position = (hash >> 7) & mask;
+                for (std::size_t step = group::width;; step += group::width)
+                {
+                    const group current(&_control[position]);
+                    for (auto matches = current.match(h2); matches; matches &= matches - 1)
+                    {
+                        const auto slot = (position + lowest_bit(matches)) & mask;
+                        if (key_traits::equals(_entries[_slots[slot]].value.first, key))
+                        {
+                            return slot;
+                        }
+                    }
+
+                    if (current.match_empty())
+                    {
+                        return capacity();
+                    }
+
+                    position = (position + step) & mask;
+                }
+            }
+
+            std::size_t find_free_slot(std::size_t hash) const
+            {
+                const auto mask = capacity() - 1;
+                auto position = (hash >> 7) & mask;
+                for (std::size_t step = group::width;; step += group::width)
+                {
+                    const auto free = group(&_control[position]).match_free();
+                    if (free)
+                    {
+                        return (position + lowest_bit(free)) & mask;
+                    }
+
+                    position = (position + step) & mask;
+                }
+            }
+
+            // entry of the key, nullptr when there is none
+            entry *find(const K &key)
+            {
+                const auto slot = find_slot(key, mix(key_traits::hash(key)));
+                return slot < capacity() ? &_entries[_slots[slot]].value : nullptr;
+            }
+
+            const entry *find(const K &key) const
+            {
+                return mutable_(this)->find(key);
+            }
+
+            template <typename T>
+            entry &insert_or_assign(const K &key, T &&value)
+            {
+                const auto hash = mix(key_traits::hash(key));
+                const auto slot = find_slot(key, hash);
+                if (slot < capacity())
+                {
+                    auto &found = _entries[_slots[slot]].value;
+                    found.second = std::forward<T>(value);
+                    return found;
+                }
+
+                if (_growth_left == 0)
+                {
+                    rehash(_size + 1);
+                }
+
+                const auto free = find_free_slot(hash);
+                _growth_left -= _control[free] == control_empty;
+                set_control(free, static_cast<std::int8_t>(hash & 0x7F));
+                _slots[free] = static_cast<std::uint32_t>(_entries.size());
+                _entries.push_back(record{entry(key, std::forward<T>(value)), false});
+                _size++;
+                return _entries.back().value;
+            }
+
+            bool erase(const K &key)
+            {
+                const auto slot = find_slot(key, mix(key_traits::hash(key)));
+                if (slot >= capacity())
+                {
+                    return false;
+                }
+
+                auto &removed = _entries[_slots[slot]];
+                removed.removed = true;
+                if (_iterating == 0)
+                {
+                    // releases references held by the entry, a loop may still be reading it otherwise
+                    removed.value = entry();
+                }
+
+                set_control(slot, control_deleted);
+                _size--;
+
+                // holes are dropped once they make up half of the entries
+                if (_iterating == 0 && _entries.size() >= min_capacity && _size * 2 < _entries.size())
+                {
+                    rehash(_size);
+                }
+
+                return true;
+            }
+
+            void clear()
+            {
+                if (_iterating == 0)
+                {
+                    _entries.clear();
+                }
+                else
+                {
+                    for (auto &item : _entries)
+                    {
+                        item.removed = true;
+                    }
+                }
+
+                _control.clear();
+                _slots.clear();
+                _size = 0;
+                _growth_left = 0;
+            }
+
+            // drops holes unless something iterates the entries, and rebuilds index for at least `count` entries
+            void rehash(std::size_t count)
+            {
+                if (_iterating == 0 && _size < _entries.size())
+                {
+                    _entries.erase(std::remove_if(_entries.begin(), _entries.end(), [](auto &item) { return item.removed; }), _entries.end());
+                }
+
+                auto new_capacity = min_capacity;
+                while (new_capacity - new_capacity / 8 < count)
+                {
+                    new_capacity *= 2;
+                }
+
+                _control.assign(new_capacity + group::width, control_empty);
+                _slots.assign(new_capacity, 0);
+                _growth_left = new_capacity - new_capacity / 8;
+                for (std::size_t index = 0; index < _entries.size(); index++)
+                {
+                    if (_entries[index].removed)
+                    {
+                        continue;
+                    }
+
+                    const auto hash = mix(key_traits::hash(_entries[index].value.first));
+                    const auto free = find_free_slot(hash);
+                    set_control(free, static_cast<std::int8_t>(hash & 0x7F));
+                    _slots[free] = static_cast<std::uint32_t>(index);
+                    _growth_left--;
+                }
+            }
+
+            // keeps entries in place for as long as it lives
+            struct iteration_guard
+            {
+                const ordered_table *_table;
+
+                explicit iteration_guard(const ordered_table *table) : _table(table)
+                {
+                    _table->_iterating++;
+                }
+
+                iteration_guard(const iteration_guard &other) : iteration_guard(other._table)
+                {
+                }
+
+                iteration_guard &operator=(const iteration_guard &other)
+                {
+                    other._table->_iterating++;
+                    _table->_iterating--;
+                    _table = other._table;
+                    return *this;
+                }
+
+                ~iteration_guard()
+                {
+                    _table->_iterating--;
+                }
+            };
+
+            struct sentinel
+            {
+            };
+
+            // live iteration as in JS: removed entries are skipped, entries added meanwhile are visited; the guard keeps
+            // the entry a loop variable refers to in place, range-for gets its iterators from begin() without a view
+            template <typename Projection>
+            struct iterator
+            {
+                iteration_guard _guard;
+                ordered_table *_table;
+                std::size_t _index;
+
+                iterator(ordered_table *table, std::size_t index) : _guard(table), _table(table), _index(index)
+                {
+                    skip_holes();
+                }
+
+                inline void skip_holes()
+                {
+                    while (_index < _table->_entries.size() && _table->_entries[_index].removed)
+                    {
+                        _index++;
+                    }
+                }
+
+                inline decltype(auto) operator*() const
+                {
+                    return Projection{}(_table->_entries[_index].value);
+                }
+
+                inline iterator &operator++()
+                {
+                    _index++;
+                    skip_holes();
+                    return *this;
+                }
+
+                inline bool operator!=(sentinel) const
+                {
+                    return _index < _table->_entries.size();
+                }
+
+                inline bool operator==(sentinel) const
+                {
+                    return _index >= _table->_entries.size();
+                }
+            };
+
+            template <typename Projection>
+            struct view
+            {
+                iteration_guard _guard;
+
+                explicit view(const ordered_table *table) : _guard(table)
+                {
+                }
+
+                iterator<Projection> begin() const
+                {
+                    return iterator<Projection>(mutable_(_guard._table), 0);
+                }
+
+                sentinel end() const
+                {
+                    return sentinel{};
+                }
+            };
+
+            struct project_entry
+            {
+                inline entry &operator()(entry &item) const
+                {
+                    return item;
+                }
+            };
+
+            struct project_key
+            {
+                inline K &operator()(entry &item) const
+                {
+                    return item.first;
+                }
+            };
+
+            struct project_value
+            {
+                inline V &operator()(entry &item) const
+                {
+                    return item.second;
+                }
+            };
+
+            template <typename F>
+            void for_each(F &&f) const
+            {
+                iteration_guard guard(this);
+                for (std::size_t index = 0; index < _entries.size(); index++)
+                {
+                    if (!_entries[index].removed)
+                    {
+                        f(mutable_(_entries[index].value));
+                    }
+                }
+            }
+        };
+
+        // missing values read as undefined
+        template <typename V>
+        inline V undefined_value()
+        {
+            if constexpr (std::is_constructible_v<V, const undefined_t &>)
+            {
+                return V(undefined);
+            }
+            else
+            {
+                return V{};
+            }
+        }
+
+        // JS callbacks may take fewer parameters than they are called with
+        template <typename F, typename First, typename Second, typename... Rest>
+        inline void invoke_first(F &f, First &&first, Second &&second, Rest &&...)
+        {
+            if constexpr (sizeof...(Rest) > 0)
+            {
+                if constexpr (std::is_invocable_v<F &, First, Second>)
+                {
+                    f(std::forward<First>(first), std::forward<Second>(second));
+                }
+                else
+                {
+                    f(std::forward<First>(first));
+                }
+            }
+            else
+            {
+                f(std::forward<First>(first));
+            }
+        }
+
+        template <typename F, typename... Args>
+        inline void invoke_callback(F &f, Args &&...args)
+        {
+            if constexpr (std::is_invocable_v<F &, Args...>)
+            {
+                f(std::forward<Args>(args)...);
+            }
+            else
+            {
+                invoke_first(f, std::forward<Args>(args)...);
+            }
+        }
+    } // namespace collections
+
+    template <typename K, typename V>
+    struct Map : public ref_counted
+    {
+        using table_type = collections::ordered_table<K, V>;
+
+        table_type _table;
+
+        Map()
+        {
+        }
+
+        // new Map(entries), items are [key, value] tuples
+        template <typename I>
+        requires requires(const I &items) { items.get_const(); }
+        Map(const I &items)
+        {
+            for (auto &item : items.get_const())
+            {
+                _table.insert_or_assign(std::get<0>(item), std::get<1>(item));
+            }
+        }
+
+        js::number get_size() const
+        {
+            return js::number(_table._size);
+        }
+
+        V get(const K &key) const
+        {
+            const auto found = _table.find(key);
+            return found ? found->second : collections::undefined_value<V>();
+        }
+
+        ref<Map> set(const K &key, const V &value)
+        {
+            _table.insert_or_assign(key, value);
+            return ref_of(this);
+        }
+
+        js::boolean has(const K &key) const
+        {
+            return _table.find(key) != nullptr;
+        }
+
+        js::boolean _delete(const K &key)
+        {
+            return _table.erase(key);
+        }
+
+        void clear()
+        {
+            _table.clear();
+        }
+
+        template <typename F>
+        void forEach(F f)
+        {
+            const auto self = ref_of(this);
+            _table.for_each([&](auto &item) { collections::invoke_callback(f, item.second, item.first, self); });
+        }
+
+        auto keys() const
+        {
+            return typename table_type::template view<typename table_type::project_key>(&_table);
+        }
+
+        auto values() const
+        {
+            return typename table_type::template view<typename table_type::project_value>(&_table);
+        }
+
+        auto entries() const
+        {
+            return typename table_type::template view<typename table_type::project_entry>(&_table);
+        }
+
+        auto begin()
+        {
+            return typename table_type::template iterator<typename table_type::project_entry>(&_table, 0);
+        }
+
+        auto end()
+        {
+            return typename table_type::sentinel{};
+        }
+
+        js::string toString() const
+        {
+            return js::string(TXT("[object Map]"));
+        }
+    };
+
+    template <typename T>
+    struct Set : public ref_counted
+    {
+        using table_type = collections::ordered_table<T, collections::none>;
+
+        table_type _table;
+
+        Set()
+        {
+        }
+
+        // new Set(values)
+        template <typename I>
+        requires requires(const I &items) { items.get_const(); }
+        Set(const I &items)
+        {
+            for (auto &item : items.get_const())
+            {
+                _table.insert_or_assign(item, collections::none{});
+            }
+        }
+
+        js::number get_size() const
+        {
+            return js::number(_table._size);
+        }
+
+        ref<Set> add(const T &value)
+        {
+            _table.insert_or_assign(value, collections::none{});
+            return ref_of(this);
+        }
+
+        js::boolean has(const T &value) const
+        {
+            return _table.find(value) != nullptr;
+        }
+
+        js::boolean _delete(const T &value)
+        {
+            return _table.erase(value);
+        }
+
+        void clear()
+        {
+            _table.clear();
+        }
+
+        template <typename F>
+        void forEach(F f)
+        {
+            const auto self = ref_of(this);
+            _table.for_each([&](auto &item) { collections::invoke_callback(f, item.first, item.first, self); });
+        }
+
+        auto values() const
+        {
+            return typename table_type::template view<typename table_type::project_key>(&_table);
+        }
+
+        auto keys() const
+        {
+            return values();
+        }
+
+        auto begin()
+        {
+            return typename table_type::template iterator<typename table_type::project_key>(&_table, 0);
+        }
+
+        auto end()
+        {
+            return typename table_type::sentinel{};
+        }
+
+        js::string toString() const
+        {
+            return js::string(TXT("[object Set]"));
+        }
+    };
+
+    // keys are held strongly: objects are reference counted, there is no collector which could observe a key dying
+    // and a weak entry would outlive its key as a stale address; not iterable, so the difference is not observable
+    template <typename K, typename V>
+    struct WeakMap : public ref_counted
+    {
+        collections::ordered_table<K, V> _table;
+
+        V get(const K &key) const
+        {
+            const auto found = _table.find(key);
+            return found ? found->second : collections::undefined_value<V>();
+        }
+
+        ref<WeakMap> set(const K &key, const V &value)
+        {
+            _table.insert_or_assign(key, value);
+            return ref_of(this);
+        }
+
+        js::boolean has(const K &key) const
+        {
+            return _table.find(key) != nullptr;
+        }
+
+        js::boolean _delete(const K &key)
+        {
+            return _table.erase(key);
+        }
+
+        js::string toString() const
+        {
+            return js::string(TXT("[object WeakMap]"));
+        }
+    };
+
+    // Math.random and fillRandom draw from xoshiro256** (Blackman, Vigna) generators owned by the calling thread and
+    // seeded once from the OS; their output is predictable from a few values, secrets take crypto.getRandomValues
+    namespace prng
+    {
+        inline std::uint64_t rotate_left(std::uint64_t value, int count)
+        {
+            return value << count | value >> (64 - count);
+        }
+
+        // SplitMix64, spreads one seed over the whole state
+        inline std::uint64_t split_mix(std::uint64_t &seed)
+        {
+            auto z = seed += 0x9E3779B97F4A7C15ull;
+            z = (z ^ z >> 30) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ z >> 27) * 0x94D049BB133111EBull;
+            return z ^ z >> 31;
+        }
+
+        // [0, 1) from the high 52 bits: a double in [1, 2) minus one
+        inline double to_unit(std::uint64_t bits)
+        {
+            return std::bit_cast<double>(bits >> 12 | 0x3FF0000000000000ull) - 1.0;
+        }
+
+        // [0, 1) from the high 24 bits, rounding a double down to float could give 1
+        inline float to_unit_float(std::uint64_t bits)
+        {
+            return static_cast<float>(bits >> 40) * 0x1p-24f;
+        }
+
+        struct xoshiro256
+        {
+            std::uint64_t state[4];
+
+            explicit xoshiro256(std::uint64_t seed)
+            {
+                for (auto &word : state)
+                {
+                    word = split_mix(seed);
+                }
+            }
+
+            inline std::uint64_t next()
+            {
+                const auto result = rotate_left(state[1] * 5, 7) * 9;
+                const auto shifted = state[1] << 17;
+                state[2] ^= state[0];
+                state[3] ^= state[1];
+                state[1] ^= state[2];
+                state[0] ^= state[3];
+                state[2] ^= shifted;
+                state[3] = rotate_left(state[3], 45);
+                return result;
+            }
+
+            // advances by 2^128 values, streams split off this way never overlap
+            void jump()
+            {
+                static constexpr std::uint64_t polynomial[] = {0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+                std::uint64_t jumped[4] = {};
+                for (auto word : polynomial)
+                {
+                    for (auto bit = 0; bit < 64; bit++)
+                    {
+                        if (word >> bit & 1)
+                        {
+                            for (auto i = 0; i < 4; i++)
+                            {
+                                jumped[i] ^= state[i];
+                            }
+                        }
+
+                        next();
+                    }
+                }
+
+                std::copy(jumped, jumped + 4, state);
+            }
+        };
+
+        // the clock and the thread are mixed in, std::random_device is allowed to be deterministic
+        inline std::uint64_t os_seed()
+        {
+            std::random_device device;
+            auto seed = static_cast<std::uint64_t>(device()) << 32 ^ device();
+            seed ^= static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+            seed ^= static_cast<std::uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) * 0x9E3779B97F4A7C15ull;
+            return seed;
+        }
+
+        inline xoshiro256 &thread_generator()
+        {
+            static thread_local xoshiro256 instance(os_seed());
+            return instance;
+        }
+
+        // four xoshiro256** streams stepped together for bulk fills; the multiplications by 5 and 9 are shifts and adds,
+        // so with SSE2 two registers per state word step all lanes at once
+        struct xoshiro256x4
+        {
+            static constexpr std::size_t lanes = 4;
+
+            // [word][lane]
+            alignas(16) std::uint64_t state[4][lanes];
+
+            // lanes continue the thread generator 2^128, 2 * 2^128, ... values ahead of it
+            explicit xoshiro256x4(xoshiro256 seed)
+            {
+                for (std::size_t lane = 0; lane < lanes; lane++)
+                {
+                    seed.jump();
+                    for (auto word = 0; word < 4; word++)
+                    {
+                        state[word][lane] = seed.state[word];
+                    }
+                }
+            }
+
+            // steps * lanes values, one of each lane in turn
+            void generate(std::uint64_t *out, std::size_t steps)
+            {
+#ifdef JS_SSE2
+                __m128i s[4][2];
+                for (auto word = 0; word < 4; word++)
+                {
+                    s[word][0] = _mm_load_si128(reinterpret_cast<const __m128i *>(state[word]));
+                    s[word][1] = _mm_load_si128(reinterpret_cast<const __m128i *>(state[word] + 2));
+                }
+
+                for (std::size_t step = 0; step < steps; step++, out += lanes)
+                {
+                    for (auto half = 0; half < 2; half++)
+                    {
+                        auto &s0 = s[0][half];
+                        auto &s1 = s[1][half];
+                        auto &s2 = s[2][half];
+                        auto &s3 = s[3][half];
+                        const auto times5 = _mm_add_epi64(_mm_slli_epi64(s1, 2), s1);
+                        const auto rotated = _mm_or_si128(_mm_slli_epi64(times5, 7), _mm_srli_epi64(times5, 57));
+                        const auto result = _mm_add_epi64(_mm_slli_epi64(rotated, 3), rotated);
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + half * 2), result);
+
+                        const auto shifted = _mm_slli_epi64(s1, 17);
+                        s2 = _mm_xor_si128(s2, s0);
+                        s3 = _mm_xor_si128(s3, s1);
+                        s1 = _mm_xor_si128(s1, s2);
+                        s0 = _mm_xor_si128(s0, s3);
+                        s2 = _mm_xor_si128(s2, shifted);
+                        s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+                    }
+                }
+
+                for (auto word = 0; word < 4; word++)
+                {
+                    _mm_store_si128(reinterpret_cast<__m128i *>(state[word]), s[word][0]);
+                    _mm_store_si128(reinterpret_cast<__m128i *>(state[word] + 2), s[word][1]);
+                }
+#else
+                for (std::size_t step = 0; step < steps; step++, out += lanes)
+                {
+                    for (std::size_t lane = 0; lane < lanes; lane++)
+                    {
+                        out[lane] = rotate_left(state[1][lane] * 5, 7) * 9;
+                        const auto shifted = state[1][lane] << 17;
+                        state[2][lane] ^= state[0][lane];
+                        state[3][lane] ^= state[1][lane];
+                        state[1][lane] ^= state[2][lane];
+                        state[0][lane] ^= state[3][lane];
+                        state[2][lane] ^= shifted;
+                        state[3][lane] = rotate_left(state[3][lane], 45);
+                    }
+                }
+#endif
+            }
+        };
+
+        inline xoshiro256x4 &thread_bulk_generator()
+        {
+            static thread_local xoshiro256x4 instance(thread_generator());
+            return instance;
+        }
+
+        // values are made in blocks which stay in L1 and are then converted or copied to the target
+        static constexpr std::size_t block_size = 256;
+
+        template <typename E>
+        void fill_unit(E *values, std::size_t count)
+        {
+            auto &generator = thread_bulk_generator();
+            alignas(16) std::uint64_t block[block_size];
+            while (count > 0)
+            {
+                const auto used = std::min(count, block_size);
+                generator.generate(block, (used + xoshiro256x4::lanes - 1) / xoshiro256x4::lanes);
+                for (std::size_t i = 0; i < used; i++)
+                {
+                    if constexpr (std::is_same_v<E, float>)
+                    {
+                        values[i] = to_unit_float(block[i]);
+                    }
+                    else
+                    {
+                        values[i] = static_cast<E>(to_unit(block[i]));
+                    }
+                }
+
+                values += used;
+                count -= used;
+            }
+        }
+
+        inline void fill_bits(void *target, std::size_t size)
+        {
+            auto &generator = thread_bulk_generator();
+            auto out = static_cast<unsigned char *>(target);
+            alignas(16) std::uint64_t block[block_size];
+            while (size > 0)
+            {
+                const auto used = std::min(size, sizeof(block));
+                generator.generate(block, (used + sizeof(std::uint64_t) * xoshiro256x4::lanes - 1) / (sizeof(std::uint64_t) * xoshiro256x4::lanes));
+                std::memcpy(out, block, used);
+                out += used;
+                size -= used;
+            }
+        }
+
+        // OS entropy source of the standard library (BCryptGenRandom, getrandom or /dev/urandom)
+        inline void fill_entropy(void *target, std::size_t size)
+        {
+            static thread_local std::random_device device;
+            auto out = static_cast<unsigned char *>(target);
+            while (size > 0)
+            {
+                const auto value = device();
+                const auto used = std::min(size, sizeof(value));
+                std::memcpy(out, &value, used);
+                out += used;
+                size -= used;
+            }
+        }
+    } // namespace prng
+
+    // Float32Array and Float64Array get numbers in [0, 1), integer typed arrays random bits
+    template <typename A>
+    A fillRandom(A values)
+    {
+        auto &items = values->get();
+        using E = typename std::remove_reference_t<decltype(items)>::value_type;
+        if constexpr (std::is_floating_point_v<E>)
+        {
+            prng::fill_unit(items.data(), items.size());
+        }
+        else
+        {
+            prng::fill_bits(items.data(), items.size() * sizeof(E));
+        }
+
+        return values;
+    }
+
+    static struct crypto_t
+    {
+        constexpr crypto_t *operator->()
+        {
+            return this;
+        }
+
+        // integer typed arrays only and at most 65536 bytes, as in Web Crypto
+        template <typename A>
+        A getRandomValues(A values)
+        {
+            auto &items = values->get();
+            using E = typename std::remove_reference_t<decltype(items)>::value_type;
+            static_assert(std::is_integral_v<E>, "crypto.getRandomValues: integer typed array expected");
+            if (items.size() * sizeof(E) > 65536)
+            {
+                // thrown as a value a script catch clause can take
+                throw any(string(TXT("QuotaExceededError: crypto.getRandomValues: quota exceeded")));
+            }
+
+            prng::fill_entropy(items.data(), items.size() * sizeof(E));
+            return values;
+        }
+    } crypto;
+
+    static struct math_t
+    {
+        static number E;
+        static number LN10;
+        static number LN2;
+        static number LOG2E;
+        static number LOG10E;
+        static number PI;
+        static number SQRT1_2;
+        static number SQRT2;
+
+        constexpr math_t *operator->()
+        {
+            return this;
+        }
+
+        static number pow(number op1, number op2)
+        {
+            return number(std::pow(static_cast<double>(op1), static_cast<double>(op2)));
+        }
+
+        static number min(number op1, number op2)
+        {
+            return number(std::min(static_cast<double>(op1), static_cast<double>(op2)));
+        }
+
+        static number max(number op1, number op2)
+        {
+            return number(std::max(static_cast<double>(op1), static_cast<double>(op2)));
+        }
+
+        static number sin(number op1)
+        {
+            return number(std::sin(static_cast<double>(op1)));
+        }
+
+        static number cos(number op1)
+        {
+            return number(std::cos(static_cast<double>(op1)));
+        }
+
+        static number asin(number op1)
+        {
+            return number(std::asin(static_cast<double>(op1)));
+        }
+
+        static number acos(number op1)
+        {
+            return number(std::acos(static_cast<double>(op1)));
+        }
+
+        static number abs(number op1)
+        {
+            return number(std::abs(static_cast<double>(op1)));
+        }
+
+        static number floor(number op1)
+        {
+            return number(std::floor(static_cast<double>(op1)));
+        }
+
+        static number round(number op1, int numDecimalPlaces = 0)
+        {
+            const auto mult = 10 ^ (numDecimalPlaces);
+            return number(std::floor(static_cast<double>(op1) * mult + 0.5) / mult);
+        }
+
+        static number sqrt(number op1)
+        {
+            return number(std::sqrt(static_cast<double>(op1)));
+        }
+
+        static number tan(number op1)
+        {
+            return number(std::tan(static_cast<double>(op1)));
+        }
+
+        static number atan(number op1)
+        {
+            return number(std::atan(static_cast<double>(op1)));
+        }
+
+        static number atan2(number op1, number op2)
+        {
+            return number(std::atan2(static_cast<double>(op1), static_cast<double>(op2)));
+        }
+
+        static number log(number op1)
+        {
+            return number(std::log(static_cast<double>(op1)));
+        }
+
+        static number exp(number op1)
+        {
+            return number(std::exp(static_cast<double>(op1)));
+        }
+
+        static number random()
+        {
+            return number(prng::to_unit(prng::thread_generator().next()));
+        }
+
+        static number sign(number op1)
+        {
+            auto d = static_cast<double>(op1);
+            return number(d < 0 ? -1 : d > 0 ? 1
+                                             : 0);
+        }
+    } Math;
+
+    static number E(2.718281828459045);
+    static number LN10(2.302585092994046);
+    static number LN2(0.6931471805599453);
+    static number LOG2E(1.4426950408889634);
+    static number LOG10E(0.4342944819032518);
+    static number PI(3.141592653589793);
+    static number SQRT1_2(0.7071067811865476);
+    static number SQRT2(1.4142135623730951);
+
+    template <typename I, class = std::enable_if_t<!std::is_enum_v<I>>>
+    constexpr inline I pass(I i)
+    {
+        return i;
+    }
+
+    template <typename I, class = std::enable_if_t<std::is_enum_v<I>>>
+    constexpr inline size_t pass(I i)
+    {
+        return static_cast<size_t>(i);
+    }
+
+    // JSON.parse in two stages as in simdjson: stage 1 classifies the text in 64-byte blocks with SIMD compares and
+    // collects positions of structural characters and scalar starts outside of strings, stage 2 builds values walking that index
+    // JSON.stringify writes UTF-8 into an output_buffer which is reused between calls or flushed to a file descriptor
+    namespace json
+    {
+        // thrown as string values named like the error a JS engine throws, so a script catch clause
+        // (catch (const any &)) takes them
+        [[noreturn]] inline void syntax_error(const char_t *message)
+        {
+            throw any(string(TXT("SyntaxError: ") + tstring(message)));
+        }
+
+        [[noreturn]] inline void type_error(const char_t *message)
+        {
+            throw any(string(TXT("TypeError: ") + tstring(message)));
+        }
+
+        // bit i of each mask is byte i of the block
+        struct block_masks
+        {
+            std::uint64_t quote;
+            std::uint64_t backslash;
+            std::uint64_t op;
+            std::uint64_t whitespace;
+        };
+
+        inline block_masks classify(const unsigned char *block)
+        {
+            block_masks masks{};
+#ifdef JS_SSE2
+            for (auto i = 0; i < 64; i += 16)
+            {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i));
+                const auto eq = [&](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+                const auto bits = [](__m128i m) { return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(m))); };
+                masks.quote |= bits(eq('"')) << i;
+                masks.backslash |= bits(eq('\\')) << i;
+                masks.op |= bits(_mm_or_si128(
+                                _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                                _mm_or_si128(eq(':'), eq(','))))
+                            << i;
+                masks.whitespace |= bits(_mm_or_si128(_mm_or_si128(eq(' '), eq('\t')), _mm_or_si128(eq('\n'), eq('\r')))) << i;
+            }
+#else
+            for (auto i = 0; i < 64; i++)
+            {
+                const auto bit = std::uint64_t{1} << i;
+                switch (block[i])
+                {
+                case '"':
+                    masks.quote |= bit;
+                    break;
+                case '\\':
+                    masks.backslash |= bit;
+                    break;
+                case '{':
+                case '}':
+                case '[':
+                case ']':
+                case ':':
+                case ',':
+                    masks.op |= bit;
+                    break;
+                case ' ':
+                case '\t':
+                case '\n':
+                case '\r':
+                    masks.whitespace |= bit;
+                    break;
+                }
+            }
+#endif
+            return masks;
+        }
+
+        // bit i is xor of bits [0, i], turns quote positions into a mask of string contents
+        inline std::uint64_t prefix_xor(std::uint64_t bits)
+        {
+            bits ^= bits << 1;
+            bits ^= bits << 2;
+            bits ^= bits << 4;
+            bits ^= bits << 8;
+            bits ^= bits << 16;
+            bits ^= bits << 32;
+            return bits;
+        }
+
+        // characters escaped by an odd run of backslashes, a run crossing the block end carries over in prev_escaped
+        inline std::uint64_t escaped_chars(std::uint64_t backslash, std::uint64_t &prev_escaped)
+        {
+            constexpr std::uint64_t even_bits = 0x5555555555555555ULL;
+            backslash &= ~prev_escaped;
+            const auto follows_escape = backslash << 1 | prev_escaped;
+            const auto odd_sequence_starts = backslash & ~even_bits & ~follows_escape;
+            const auto sequences_starting_on_even_bits = odd_sequence_starts + backslash;
+            prev_escaped = sequences_starting_on_even_bits < odd_sequence_starts ? 1 : 0;
+            const auto invert_mask = sequences_starting_on_even_bits << 1;
+            return (even_bits ^ invert_mask) & follows_escape;
+        }
+
+        // stage 1: positions of { } [ ] : , of opening quotes and of first characters of numbers and literals
+        inline void index_structurals(std::string_view text, std::vector<std::uint32_t> &index)
+        {
+            if (text.size() >= std::numeric_limits<std::uint32_t>::max())
+            {
+                syntax_error(TXT("JSON.parse: input is too large"));
+            }
+
+            index.clear();
+            index.reserve(text.size() / 4 + 1);
+
+            std::uint64_t prev_escaped = 0;
+            std::uint64_t prev_in_string = 0;
+            std::uint64_t prev_scalar = 0;
+            unsigned char tail[64];
+            for (std::size_t offset = 0; offset < text.size(); offset += 64)
+            {
+                auto block = reinterpret_cast<const unsigned char *>(text.data()) + offset;
+                if (text.size() - offset < 64)
+                {
+                    std::memset(tail, ' ', sizeof(tail));
+                    std::memcpy(tail, block, text.size() - offset);
+                    block = tail;
+                }
+
+                const auto masks = classify(block);
+                const auto quote = masks.quote & ~escaped_chars(masks.backslash, prev_escaped);
+                // opening quote and string contents, not closing quote
+                const auto in_string = prefix_xor(quote) ^ prev_in_string;
+                prev_in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+                const auto scalar = ~(masks.op | masks.whitespace);
+                const auto nonquote_scalar = scalar & ~quote;
+                const auto follows_nonquote_scalar = nonquote_scalar << 1 | prev_scalar;
+                prev_scalar = nonquote_scalar >> 63;
+
+                auto structurals = (masks.op | (scalar & ~follows_nonquote_scalar)) & ~(in_string ^ quote);
+                while (structurals)
+                {
+                    index.push_back(static_cast<std::uint32_t>(offset + std::countr_zero(structurals)));
+                    structurals &= structurals - 1;
+                }
+            }
+
+            if (prev_in_string)
+            {
+                syntax_error(TXT("JSON.parse: unterminated string"));
+            }
+        }
+
+        // first '"', '\\' or control character in [current, end)
+        inline const char *find_string_special(const char *current, const char *end)
+        {
+#ifdef JS_SSE2
+            for (; end - current >= 16; current += 16)
+            {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+                const auto control = _mm_cmpeq_epi8(_mm_max_epu8(chunk, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+                const auto special = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))), control);
+                const auto bits = _mm_movemask_epi8(special);
+                if (bits)
+                {
+                    return current + std::countr_zero(static_cast<unsigned>(bits));
+                }
+            }
+#endif
+            for (; current < end; current++)
+            {
+                if (*current == '"' || *current == '\\' || static_cast<unsigned char>(*current) < 0x20)
+                {
+                    break;
+                }
+            }
+
+            return current;
+        }
+
+        inline void encode_utf8(std::string &out, std::uint32_t code_point)
+        {
+            if (code_point < 0x80)
+            {
+                out.push_back(static_cast<char>(code_point));
+            }
+            else if (code_point < 0x800)
+            {
+                out.push_back(static_cast<char>(0xC0 | code_point >> 6));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else if (code_point < 0x10000)
+            {
+                out.push_back(static_cast<char>(0xE0 | code_point >> 12));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+            else
+            {
+                out.push_back(static_cast<char>(0xF0 | code_point >> 18));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 12 & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point >> 6 & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+            }
+        }
+
+        inline void append_code_point(tstring &out, std::uint32_t code_point)
+        {
+#ifdef UNICODE
+            if (code_point >= 0x10000 && sizeof(wchar_t) == 2)
+            {
+                code_point -= 0x10000;
+                out.push_back(static_cast<wchar_t>(0xD800 + (code_point >> 10)));
+                out.push_back(static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF)));
+                return;
+            }
+
+            out.push_back(static_cast<wchar_t>(code_point));
+#else
+            encode_utf8(out, code_point);
+#endif
+        }
+
+        // UTF-8 bytes of the text as string contents
+        inline void append_utf8(tstring &out, const char *begin, const char *end)
+        {
+#ifdef UNICODE
+            while (begin < end)
+            {
+                const auto lead = static_cast<unsigned char>(*begin++);
+                const auto length = lead < 0x80 ? 0 : lead < 0xE0 ? 1 : lead < 0xF0 ? 2 : 3;
+                std::uint32_t code_point = length == 0 ? lead : lead & (0x3F >> length);
+                for (auto i = 0; i < length && begin < end; i++)
+                {
+                    code_point = code_point << 6 | (static_cast<unsigned char>(*begin++) & 0x3F);
+                }
+
+                append_code_point(out, code_point);
+            }
+#else
+            out.append(begin, end);
+#endif
+        }
+
+#ifdef UNICODE
+        inline void encode_utf8(std::string &out, std::basic_string_view<char_t> text)
+        {
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                std::uint32_t code_point = static_cast<std::uint32_t>(text[i]);
+                if (sizeof(wchar_t) == 2 && code_point >= 0xD800 && code_point < 0xDC00 && i + 1 < text.size())
+                {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (static_cast<std::uint32_t>(text[++i]) - 0xDC00);
+                }
+
+                encode_utf8(out, code_point);
+            }
+        }
+
+        inline std::string to_utf8(const tstring &text)
+        {
+            std::string out;
+            out.reserve(text.size());
+            encode_utf8(out, text);
+            return out;
+        }
+#endif
+
+        inline bool is_digit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        inline bool is_terminator(char c)
+        {
+            switch (c)
+            {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+            case ',':
+            case ']':
+            case '}':
+            case ':':
+                return true;
+            }
+
+            return false;
+        }
+
+        // stage 2: values from the structural index
+        struct parser
+        {
+            static constexpr std::size_t max_depth = 1024;
+
+            std::string_view text;
+            const std::vector<std::uint32_t> &index;
+            std::size_t next = 0;
+            std::size_t depth = 0;
+
+            parser(std::string_view text, const std::vector<std::uint32_t> &index) : text(text), index(index)
+            {
+            }
+
+            std::size_t advance()
+            {
+                if (next >= index.size())
+                {
+                    syntax_error(TXT("JSON.parse: unexpected end of input"));
+                }
+
+                return index[next++];
+            }
+
+            char peek() const
+            {
+                return next < index.size() ? text[index[next]] : '\0';
+            }
+
+            any parse_document()
+            {
+                auto value = parse_value();
+                if (next != index.size())
+                {
+                    syntax_error(TXT("JSON.parse: unexpected non-whitespace character after JSON data"));
+                }
+
+                return value;
+            }
+
+            any parse_value()
+            {
+                const auto position = advance();
+                switch (text[position])
+                {
+                case '{':
+                    return parse_object();
+                case '[':
+                    return parse_array();
+                case '"':
+                {
+                    any value;
+                    value._value.emplace<js::string>(parse_string(position));
+                    return value;
+                }
+                case 't':
+                    parse_literal(position, "true");
+                    return any(true);
+                case 'f':
+                    parse_literal(position, "false");
+                    return any(false);
+                case 'n':
+                    parse_literal(position, "null");
+                    return any(nullptr);
+                case '-':
+                case '0':
+                case '1':
+                case '2':
+                case '3':
+                case '4':
+                case '5':
+                case '6':
+                case '7':
+                case '8':
+                case '9':
+                    return any(js::number(parse_number(position)));
+                }
+
+                syntax_error(TXT("JSON.parse: unexpected character"));
+            }
+
+            any parse_object()
+            {
+                enter();
+                js::object result;
+                if (peek() == '}')
+                {
+                    next++;
+                    leave();
+                    return any(result);
+                }
+
+                auto &values = result.get();
+                while (true)
+                {
+                    const auto key_position = advance();
+                    if (text[key_position] != '"')
+                    {
+                        syntax_error(TXT("JSON.parse: expected property name"));
+                    }
+
+                    js::string key(parse_string(key_position));
+                    if (text[advance()] != ':')
+                    {
+                        syntax_error(TXT("JSON.parse: expected ':' after property name"));
+                    }
+
+                    values.insert_or_assign(std::move(key), parse_value());
+
+                    const auto separator = text[advance()];
+                    if (separator == '}')
+                    {
+                        break;
+                    }
+
+                    if (separator != ',')
+                    {
+                        syntax_error(TXT("JSON.parse: expected ',' or '}' after property value"));
+                    }
+                }
+
+                leave();
+                return any(result);
+            }
+
+            any parse_array()
+            {
+                enter();
+                js::array_any result;
+                if (peek() == ']')
+                {
+                    next++;
+                    leave();
+                    return any(result);
+                }
+
+                auto &values = result.get();
+                while (true)
+                {
+                    values.push_back(parse_value());
+
+                    const auto separator = text[advance()];
+                    if (separator == ']')
+                    {
+                        break;
+                    }
+
+                    if (separator != ',')
+                    {
+                        syntax_error(TXT("JSON.parse: expected ',' or ']' after array element"));
+                    }
+                }
+
+                leave();
+                return any(result);
+            }
+
+            // runs without escapes are appended in one piece
+            tstring parse_string(std::size_t position)
+            {
+                tstring result;
+                auto current = text.data() + position + 1;
+                const auto end = text.data() + text.size();
+                while (true)
+                {
+                    const auto special = find_string_special(current, end);
+                    append_utf8(result, current, special);
+                    if (special == end)
+                    {
+                        syntax_error(TXT("JSON.parse: unterminated string"));
+                    }
+
+                    if (*special == '"')
+                    {
+                        return result;
+                    }
+
+                    if (*special != '\\')
+                    {
+                        syntax_error(TXT("JSON.parse: bad control character in string literal"));
+                    }
+
+                    current = parse_escape(result, special + 1, end);
+                }
+            }
+
+            const char *parse_escape(tstring &out, const char *current, const char *end)
+            {
+                if (current == end)
+                {
+                    syntax_error(TXT("JSON.parse: unterminated string"));
+                }
+
+                switch (*current)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    out.push_back(static_cast<char_t>(*current));
+                    return current + 1;
+                case 'b':
+                    out.push_back(TXT('\b'));
+                    return current + 1;
+                case 'f':
+                    out.push_back(TXT('\f'));
+                    return current + 1;
+                case 'n':
+                    out.push_back(TXT('\n'));
+                    return current + 1;
+                case 'r':
+                    out.push_back(TXT('\r'));
+                    return current + 1;
+                case 't':
+                    out.push_back(TXT('\t'));
+                    return current + 1;
+                case 'u':
+                {
+                    auto code_point = parse_hex4(current + 1, end);
+                    current += 5;
+                    if (code_point >= 0xD800 && code_point < 0xDC00
+                        && end - current >= 6 && current[0] == '\\' && current[1] == 'u')
+                    {
+                        const auto low = parse_hex4(current + 2, end);
+                        if (low >= 0xDC00 && low < 0xE000)
+                        {
+                            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                            current += 6;
+                        }
+                    }
+
+                    append_code_point(out, code_point);
+                    return current;
+                }
+                }
+
+                syntax_error(TXT("JSON.parse: bad escaped character"));
+            }
+
+            static std::uint32_t parse_hex4(const char *current, const char *end)
+            {
+                if (end - current < 4)
+                {
+                    syntax_error(TXT("JSON.parse: bad Unicode escape"));
+                }
+
+                std::uint32_t value = 0;
+                for (auto i = 0; i < 4; i++)
+                {
+                    const auto c = current[i];
+                    const auto digit = c >= '0' && c <= '9'   ? c - '0'
+                                       : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                       : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                                              : -1;
+                    if (digit < 0)
+                    {
+                        syntax_error(TXT("JSON.parse: bad Unicode escape"));
+                    }
+
+                    value = value << 4 | static_cast<std::uint32_t>(digit);
+                }
+
+                return value;
+            }
+
+            // validates the grammar, then takes Clinger's fast path when the mantissa and the power of ten
+            // are exact doubles, otherwise the correctly rounded std::from_chars
+            double parse_number(std::size_t position)
+            {
+                static constexpr double powers_of_ten[] = {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+                const auto begin = text.data() + position;
+                const auto end = text.data() + text.size();
+                auto current = begin;
+                const auto negative = *current == '-';
+                if (negative)
+                {
+                    current++;
+                }
+
+                if (current == end || !is_digit(*current))
+                {
+                    syntax_error(TXT("JSON.parse: no number after minus sign"));
+                }
+
+                std::uint64_t mantissa = 0;
+                auto digits = 0;
+                auto exponent = 0;
+                if (*current == '0')
+                {
+                    current++;
+                }
+                else
+                {
+                    for (; current < end && is_digit(*current); current++, digits++)
+                    {
+                        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*current - '0');
+                    }
+                }
+
+                if (current < end && *current == '.')
+                {
+                    current++;
+                    if (current == end || !is_digit(*current))
+                    {
+                        syntax_error(TXT("JSON.parse: missing digits after decimal point"));
+                    }
+
+                    for (; current < end && is_digit(*current); current++, digits++, exponent--)
+                    {
+                        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*current - '0');
+                    }
+                }
+
+                if (current < end && (*current == 'e' || *current == 'E'))
+                {
+                    current++;
+                    const auto negative_exponent = current < end && *current == '-';
+                    if (current < end && (*current == '-' || *current == '+'))
+                    {
+                        current++;
+                    }
+
+                    if (current == end || !is_digit(*current))
+                    {
+                        syntax_error(TXT("JSON.parse: missing digits after exponent indicator"));
+                    }
+
+                    auto value = 0;
+                    for (; current < end && is_digit(*current); current++)
+                    {
+                        if (value < 100000)
+                        {
+                            value = value * 10 + (*current - '0');
+                        }
+                    }
+
+                    exponent += negative_exponent ? -value : value;
+                }
+
+                if (current < end && !is_terminator(*current))
+                {
+                    syntax_error(TXT("JSON.parse: unexpected character after number"));
+                }
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0 && FLT_EVAL_METHOD != 1
+                // x87 extended precision rounds twice
+                constexpr auto fast_path = false;
+#else
+                constexpr auto fast_path = true;
+#endif
+                if (fast_path && digits <= 15 && exponent >= -22 && exponent <= 22)
+                {
+                    auto value = static_cast<double>(mantissa);
+                    value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+                    return negative ? -value : value;
+                }
+
+                double value = 0;
+                const auto result = std::from_chars(begin, current, value);
+                if (result.ec == std::errc::result_out_of_range)
+                {
+                    // overflow to infinity, underflow to zero
+                    value = exponent + digits > 0 ? std::numeric_limits<double>::infinity() : 0;
+                    return negative ? -value : value;
+                }
+
+                return value;
+            }
+
+            void parse_literal(std::size_t position, std::string_view literal)
+            {
+                if (text.compare(position, literal.size(), literal) != 0
+                    || position + literal.size() < text.size() && !is_terminator(text[position + literal.size()]))
+                {
+                    syntax_error(TXT("JSON.parse: unexpected keyword"));
+                }
+            }
+
+            // typed reads into fields of emitted interfaces, null leaves the default value
+            void read(js::number &value)
+            {
+                const auto position = advance();
+                const auto c = text[position];
+                if (c == 'n')
+                {
+                    parse_literal(position, "null");
+                    return;
+                }
+
+                if (c != '-' && !is_digit(c))
+                {
+                    type_error(TXT("JSON.parse: expected number"));
+                }
+
+                value = js::number(parse_number(position));
+            }
+
+            void read(js::string &value)
+            {
+                const auto position = advance();
+                if (text[position] == 'n')
+                {
+                    parse_literal(position, "null");
+                    value = js::string(static_cast<const char_t *>(nullptr));
+                    return;
+                }
+
+                if (text[position] != '"')
+                {
+                    type_error(TXT("JSON.parse: expected string"));
+                }
+
+                value = js::string(parse_string(position));
+            }
+
+            void read(js::boolean &value)
+            {
+                const auto position = advance();
+                switch (text[position])
+                {
+                case 't':
+                    parse_literal(position, "true");
+                    value = js::boolean(true);
+                    return;
+                case 'f':
+                    parse_literal(position, "false");
+                    value = js::boolean(false);
+                    return;
+                case 'n':
+                    parse_literal(position, "null");
+                    return;
+                }
+
+                type_error(TXT("JSON.parse: expected boolean"));
+            }
+
+            void read(any &value)
+            {
+                value = parse_value();
+            }
+
+            template <typename E>
+            void read(tmpl::array<E> &value)
+            {
+                const auto position = advance();
+                if (text[position] == 'n')
+                {
+                    parse_literal(position, "null");
+                    return;
+                }
+
+                if (text[position] != '[')
+                {
+                    type_error(TXT("JSON.parse: expected array"));
+                }
+
+                enter();
+                value = tmpl::array<E>();
+                if (peek() == ']')
+                {
+                    next++;
+                    leave();
+                    return;
+                }
+
+                auto &values = value.get();
+                while (true)
+                {
+                    values.emplace_back();
+                    read(values.back());
+
+                    const auto separator = text[advance()];
+                    if (separator == ']')
+                    {
+                        break;
+                    }
+
+                    if (separator != ',')
+                    {
+                        syntax_error(TXT("JSON.parse: expected ',' or ']' after array element"));
+                    }
+                }
+
+                leave();
+            }
+
+            template <typename T>
+            requires requires { T::__json_fields; }
+            void read(js::ref<T> &value)
+            {
+                const auto position = advance();
+                if (text[position] == 'n')
+                {
+                    parse_literal(position, "null");
+                    value = nullptr;
+                    return;
+                }
+
+                if (text[position] != '{')
+                {
+                    type_error(TXT("JSON.parse: expected object"));
+                }
+
+                enter();
+                auto target = new_<T>();
+                if (peek() == '}')
+                {
+                    next++;
+                }
+                else
+                {
+                    tstring scratch;
+                    while (true)
+                    {
+                        const auto key_position = advance();
+                        if (text[key_position] != '"')
+                        {
+                            syntax_error(TXT("JSON.parse: expected property name"));
+                        }
+
+                        const auto key = read_key(key_position, scratch);
+                        if (text[advance()] != ':')
+                        {
+                            syntax_error(TXT("JSON.parse: expected ':' after property name"));
+                        }
+
+                        target->__json_read_field(*this, T::__json_fields.index(key));
+
+                        const auto separator = text[advance()];
+                        if (separator == '}')
+                        {
+                            break;
+                        }
+
+                        if (separator != ',')
+                        {
+                            syntax_error(TXT("JSON.parse: expected ',' or '}' after property value"));
+                        }
+                    }
+                }
+
+                leave();
+                value = std::move(target);
+            }
+
+            // property name without escapes is viewed in place
+            std::basic_string_view<char_t> read_key(std::size_t position, tstring &scratch)
+            {
+#ifndef UNICODE
+                const auto begin = text.data() + position + 1;
+                const auto special = find_string_special(begin, text.data() + text.size());
+                if (special < text.data() + text.size() && *special == '"')
+                {
+                    return std::string_view(begin, special - begin);
+                }
+#endif
+                scratch = parse_string(position);
+                return scratch;
+            }
+
+            // value of unknown field, containers are skipped by bracket depth over the structural index
+            void skip()
+            {
+                const auto position = advance();
+                const auto c = text[position];
+                if (c != '{' && c != '[')
+                {
+                    if (c == '"')
+                    {
+                        parse_string(position);
+                    }
+
+                    return;
+                }
+
+                std::size_t nested = 1;
+                while (nested > 0)
+                {
+                    switch (text[advance()])
+                    {
+                    case '{':
+                    case '[':
+                        nested++;
+                        break;
+                    case '}':
+                    case ']':
+                        nested--;
+                        break;
+                    }
+                }
+            }
+
+            void enter()
+            {
+                if (++depth > max_depth)
+                {
+                    syntax_error(TXT("JSON.parse: too deeply nested"));
+                }
+            }
+
+            void leave()
+            {
+                depth--;
+            }
+        };
+
+        // structural index kept per thread between calls
+        inline std::vector<std::uint32_t> &index_buffer()
+        {
+            static thread_local std::vector<std::uint32_t> index;
+            return index;
+        }
+
+        // parses UTF-8 text
+        inline any parse(std::string_view text)
+        {
+            auto &index = index_buffer();
+            index_structurals(text, index);
+            return parser(text, index).parse_document();
+        }
+
+        // parses UTF-8 text straight into the fields of emitted interfaces
+        template <typename T>
+        T parse_as(std::string_view text)
+        {
+            auto &index = index_buffer();
+            index_structurals(text, index);
+            parser reader(text, index);
+            T value{};
+            reader.read(value);
+            if (reader.next != index.size())
+            {
+                syntax_error(TXT("JSON.parse: unexpected non-whitespace character after JSON data"));
+            }
+
+            return value;
+        }
+
+        // growable UTF-8 output, with a file descriptor it flushes in chunks so the whole text is never held at once
+        struct output_buffer
+        {
+            static constexpr std::size_t chunk_size = 64 * 1024;
+
+            std::string data;
+            int fd = -1;
+
+            output_buffer() = default;
+
+            explicit output_buffer(int fd) : fd(fd)
+            {
+                data.reserve(chunk_size * 2);
+            }
+
+            inline void append(char c)
+            {
+                data.push_back(c);
+            }
+
+            inline void append(const char *begin, std::size_t size)
+            {
+                data.append(begin, size);
+            }
+
+            inline void append(std::string_view text)
+            {
+                data.append(text);
+            }
+
+            // called between values, so a chunk is never cut inside of a token
+            inline void commit()
+            {
+                if (fd >= 0 && data.size() >= chunk_size)
+                {
+                    flush();
+                }
+            }
+
+            void flush()
+            {
+                auto current = data.data();
+                auto left = data.size();
+                while (left > 0)
+                {
+#ifdef _WIN32
+                    const auto written = _write(fd, current, static_cast<unsigned int>(std::min<std::size_t>(left, INT_MAX)));
+#else
+                    const auto written = ::write(fd, current, left);
+#endif
+                    if (written < 0)
+                    {
+                        if (errno == EINTR)
+                        {
+                            continue;
+                        }
+
+                        throw any(string(TXT("Error: JSON.stringify: write failed")));
+                    }
+
+                    current += written;
+                    left -= static_cast<std::size_t>(written);
+                }
+
+                data.clear();
+            }
+        };
+
+        // Number::toString layout over the shortest round-trip digits of std::to_chars
+        inline void append_number(std::string &out, double value)
+        {
+            if (std::isnan(value))
+            {
+                out.append("NaN", 3);
+                return;
+            }
+
+            if (std::isinf(value))
+            {
+                value < 0 ? out.append("-Infinity", 9) : out.append("Infinity", 8);
+                return;
+            }
+
+            char buffer[32];
+            if (value == std::trunc(value) && std::abs(value) < 9007199254740992.0)
+            {
+                // also turns -0 into 0
+                const auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<std::int64_t>(value));
+                out.append(buffer, result.ptr - buffer);
+                return;
+            }
+
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific);
+            auto current = buffer;
+            if (*current == '-')
+            {
+                out.push_back('-');
+                current++;
+            }
+
+            char digits[20];
+            auto count = 0;
+            for (; current < result.ptr && *current != 'e'; current++)
+            {
+                if (*current != '.')
+                {
+                    digits[count++] = *current;
+                }
+            }
+
+            auto exponent = 0;
+            current++;
+            if (*current == '+')
+            {
+                current++;
+            }
+
+            std::from_chars(current, result.ptr, exponent);
+
+            // value is 0.digits * 10^point
+            const auto point = exponent + 1;
+            if (count <= point && point <= 21)
+            {
+                out.append(digits, count);
+                out.append(point - count, '0');
+            }
+            else if (0 < point && point <= 21)
+            {
+                out.append(digits, point);
+                out.push_back('.');
+                out.append(digits + point, count - point);
+            }
+            else if (-6 < point && point <= 0)
+            {
+                out.append("0.", 2);
+                out.append(-point, '0');
+                out.append(digits, count);
+            }
+            else
+            {
+                out.push_back(digits[0]);
+                if (count > 1)
+                {
+                    out.push_back('.');
+                    out.append(digits + 1, count - 1);
+                }
+
+                out.append(point > 0 ? "e+" : "e-", 2);
+                const auto exponent_result = std::to_chars(buffer, buffer + sizeof(buffer), std::abs(point - 1));
+                out.append(buffer, exponent_result.ptr - buffer);
+            }
+        }
+
+        // JSON has no text for NaN and Infinity
+        inline void append_number(output_buffer &out, double value)
+        {
+            if (!std::isfinite(value))
+            {
+                out.append("null", 4);
+                return;
+            }
+
+            append_number(out.data, value);
+        }
+
+        inline void append_escaped(output_buffer &out, std::uint32_t c)
+        {
+            switch (c)
+            {
+            case '"':
+                out.append("\\\"", 2);
+                return;
+            case '\\':
+                out.append("\\\\", 2);
+                return;
+            case '\b':
+                out.append("\\b", 2);
+                return;
+            case '\f':
+                out.append("\\f", 2);
+                return;
+            case '\n':
+                out.append("\\n", 2);
+                return;
+            case '\r':
+                out.append("\\r", 2);
+                return;
+            case '\t':
+                out.append("\\t", 2);
+                return;
+            }
+
+            constexpr auto hex = "0123456789abcdef";
+            const char escape[] = {'\\', 'u', hex[c >> 12 & 0xF], hex[c >> 8 & 0xF], hex[c >> 4 & 0xF], hex[c & 0xF]};
+            out.append(escape, sizeof(escape));
+        }
+
+        // quoted string, runs which need no escaping are copied in one piece
+        inline void append_quoted(output_buffer &out, std::basic_string_view<char_t> value)
+        {
+            out.append('"');
+#ifdef UNICODE
+            for (std::size_t i = 0; i < value.size(); i++)
+            {
+                std::uint32_t c = static_cast<std::uint32_t>(value[i]);
+                if (c < 0x20 || c == '"' || c == '\\')
+                {
+                    append_escaped(out, c);
+                    continue;
+                }
+
+                if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xE000)
+                {
+                    const auto low = i + 1 < value.size() ? static_cast<std::uint32_t>(value[i + 1]) : 0;
+                    if (c >= 0xDC00 || low < 0xDC00 || low >= 0xE000)
+                    {
+                        // lone surrogate
+                        append_escaped(out, c);
+                        continue;
+                    }
+
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    i++;
+                }
+
+                encode_utf8(out.data, c);
+            }
+#else
+            auto current = value.data();
+            const auto end = current + value.size();
+            while (true)
+            {
+                const auto special = find_string_special(current, end);
+                out.append(current, special - current);
+                if (special == end)
+                {
+                    break;
+                }
+
+                append_escaped(out, static_cast<unsigned char>(*special));
+                current = special + 1;
+            }
+#endif
+            out.append('"');
+        }
+
+        // arguments which are not any themselves, typed arrays are copied into array_any
+        template <typename T>
+        any to_any(const T &value)
+        {
+            if constexpr (std::is_constructible_v<any, const T &>)
+            {
+                return any(value);
+            }
+            else
+            {
+                js::array_any result;
+                auto &values = result.get();
+                for (auto &item : value.get_const())
+                {
+                    values.push_back(to_any(item));
+                }
+
+                return any(result);
+            }
+        }
+
+        // the thread's buffer keeps its capacity between calls, a nested call from a replacer gets its own
+        struct buffer_lease
+        {
+            output_buffer local;
+            output_buffer *buffer;
+            bool *in_use = nullptr;
+
+            buffer_lease()
+            {
+                static thread_local output_buffer reusable;
+                static thread_local bool busy = false;
+                if (busy)
+                {
+                    buffer = &local;
+                    return;
+                }
+
+                busy = true;
+                in_use = &busy;
+                buffer = &reusable;
+                reusable.data.clear();
+            }
+
+            ~buffer_lease()
+            {
+                if (in_use)
+                {
+                    *in_use = false;
+                }
+            }
+        };
+
+        struct stringifier
+        {
+            output_buffer &out;
+            std::shared_ptr<js::function> replacer;
+            std::vector<js::string> property_list;
+            bool has_property_list = false;
+            std::string gap;
+            std::string indent;
+            // containers on the current path, for cycle detection
+            std::unordered_set<const void *> stack;
+            bool fields_empty = true;
+
+            stringifier(output_buffer &out, const any &replacer_or_list, const any &space) : out(out)
+            {
+                switch (replacer_or_list.get_type())
+                {
+                case any::function_type:
+                    replacer = replacer_or_list.get<std::shared_ptr<js::function>>();
+                    break;
+                case any::array_type:
+                    has_property_list = true;
+                    for (auto &item : replacer_or_list.array_ref_const().get_const())
+                    {
+                        if (item.get_type() != any::string_type && item.get_type() != any::number_type)
+                        {
+                            continue;
+                        }
+
+                        js::string name = item.get_type() == any::string_type ? item.string_ref_const() : key_of(item.number_ref_const()._value);
+                        if (std::find(property_list.begin(), property_list.end(), name) == property_list.end())
+                        {
+                            property_list.push_back(std::move(name));
+                        }
+                    }
+
+                    break;
+                default:
+                    break;
+                }
+
+                switch (space.get_type())
+                {
+                case any::number_type:
+                {
+                    const auto count = std::min(10.0, std::trunc(space.number_ref_const()._value));
+                    if (count >= 1)
+                    {
+                        gap.assign(static_cast<std::size_t>(count), ' ');
+                    }
+
+                    break;
+                }
+                case any::string_type:
+                {
+                    const auto &text = space.string_ref_const()._value;
+#ifdef UNICODE
+                    gap = to_utf8(text.substr(0, 10));
+#else
+                    gap = text.substr(0, 10);
+#endif
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+
+            static js::string key_of(double index)
+            {
+                output_buffer text;
+                append_number(text, index);
+#ifdef UNICODE
+                tstring wide;
+                append_utf8(wide, text.data.data(), text.data.data() + text.data.size());
+                return js::string(std::move(wide));
+#else
+                return js::string(std::move(text.data));
+#endif
+            }
+
+            // value after the replacer, undefined and functions are not serialized
+            any resolve(const js::string &key, const any &value)
+            {
+                return replacer ? replacer->invoke({any(key), value}) : value;
+            }
+
+            static bool is_serializable(const any &value)
+            {
+                switch (value.get_type())
+                {
+                case any::undefined_type:
+                case any::function_type:
+                    return false;
+                case any::number_type:
+                    return !mutable_(value.number_ref_const()).is_undefined();
+                case any::string_type:
+                    return !value.string_ref_const().is_undefined();
+                default:
+                    return true;
+                }
+            }
+
+            template <typename V>
+            static bool is_serializable_typed(const V &value)
+            {
+                if constexpr (std::is_same_v<V, any>)
+                {
+                    return is_serializable(value);
+                }
+                else if constexpr (std::is_same_v<V, js::number>)
+                {
+                    return !mutable_(value).is_undefined();
+                }
+                else if constexpr (std::is_same_v<V, js::string>)
+                {
+                    return !value.is_undefined();
+                }
+                else if constexpr (std::is_same_v<V, js::boolean> || requires { value.get(); })
+                {
+                    return true;
+                }
+                else
+                {
+                    return is_serializable(to_any(value));
+                }
+            }
+
+            bool write_root(const any &value)
+            {
+                const auto resolved = resolve(js::string(TXT("")), value);
+                if (!is_serializable(resolved))
+                {
+                    return false;
+                }
+
+                write(resolved);
+                return true;
+            }
+
+            void write(const any &value)
+            {
+                switch (value.get_type())
+                {
+                case any::boolean_type:
+                    value.boolean_ref_const() ? out.append("true", 4) : out.append("false", 5);
+                    break;
+                case any::pointer_type:
+                    out.append("null", 4);
+                    break;
+                case any::number_type:
+                    append_number(out, value.number_ref_const()._value);
+                    break;
+                case any::string_type:
+                    write_typed(value.string_ref_const());
+                    break;
+                case any::array_type:
+                    write_typed(value.array_ref_const());
+                    break;
+                case any::object_type:
+                    write_typed(value.get<js::object>());
+                    break;
+                case any::class_type:
+                    write_instance(*value.get<js::ref<js::object>>());
+                    break;
+                default:
+                    out.append("null", 4);
+                    break;
+                }
+
+                out.commit();
+            }
+
+            void write_typed(const js::number &value)
+            {
+                append_number(out, value._value);
+            }
+
+            void write_typed(const js::string &value)
+            {
+                if (value.is_null() || value.is_undefined())
+                {
+                    out.append("null", 4);
+                    return;
+                }
+
+                append_quoted(out, value._value);
+            }
+
+            void write_typed(const js::boolean &value)
+            {
+                mutable_(value) ? out.append("true", 4) : out.append("false", 5);
+            }
+
+            void write_typed(const any &value)
+            {
+                is_serializable(value) ? write(value) : out.append("null", 4);
+            }
+
+            void write_typed(const js::object &value)
+            {
+                const auto &values = value.get_const();
+                enter(&values);
+                const auto saved = begin_fields();
+                write_properties(values);
+                end_fields(saved);
+                leave(&values);
+            }
+
+            template <typename E>
+            void write_typed(const tmpl::array<E> &value)
+            {
+                const auto &values = value.get_const();
+                if (values.empty())
+                {
+                    out.append("[]", 2);
+                    return;
+                }
+
+                enter(&values);
+                const auto stepback = indent.size();
+                indent.append(gap);
+                out.append('[');
+                for (std::size_t i = 0; i < values.size(); i++)
+                {
+                    if (i > 0)
+                    {
+                        out.append(',');
+                    }
+
+                    new_line();
+                    if (replacer)
+                    {
+                        const auto resolved = resolve(key_of(static_cast<double>(i)), to_any(values[i]));
+                        is_serializable(resolved) ? write(resolved) : out.append("null", 4);
+                    }
+                    else
+                    {
+                        is_serializable_typed(values[i]) ? write_typed(values[i]) : out.append("null", 4);
+                    }
+
+                    out.commit();
+                }
+
+                indent.resize(stepback);
+                new_line();
+                out.append(']');
+                leave(&values);
+            }
+
+            template <typename T>
+            void write_typed(const js::ref<T> &value)
+            {
+                if (!value.get())
+                {
+                    out.append("null", 4);
+                    return;
+                }
+
+                write_instance(*value);
+            }
+
+            template <typename T>
+            void write_typed(const T &value)
+            {
+                write(to_any(value));
+            }
+
+            void write_instance(const js::object &instance)
+            {
+                enter(&instance);
+                const auto saved = begin_fields();
+                if (!instance.__json_write(*this))
+                {
+                    // only own dynamic properties are reachable without the class layout
+                    write_properties(instance.get_const());
+                }
+
+                end_fields(saved);
+                leave(&instance);
+            }
+
+            void enter(const void *container)
+            {
+                if (!stack.insert(container).second)
+                {
+                    type_error(TXT("JSON.stringify: cyclic object value"));
+                }
+            }
+
+            void leave(const void *container)
+            {
+                stack.erase(container);
+            }
+
+            void new_line()
+            {
+                if (!gap.empty())
+                {
+                    out.append('\n');
+                    out.append(indent);
+                }
+            }
+
+            // indentation and emptiness of the enclosing object, restored by end_fields
+            struct fields_state
+            {
+                std::size_t stepback;
+                bool empty;
+            };
+
+            fields_state begin_fields()
+            {
+                const fields_state saved{indent.size(), fields_empty};
+                indent.append(gap);
+                fields_empty = true;
+                out.append('{');
+                return saved;
+            }
+
+            void end_fields(const fields_state &saved)
+            {
+                indent.resize(saved.stepback);
+                if (!fields_empty)
+                {
+                    new_line();
+                }
+
+                out.append('}');
+                fields_empty = saved.empty;
+            }
+
+            void begin_field(std::basic_string_view<char_t> key)
+            {
+                if (!fields_empty)
+                {
+                    out.append(',');
+                }
+
+                fields_empty = false;
+                new_line();
+                append_quoted(out, key);
+                out.append(':');
+                if (!gap.empty())
+                {
+                    out.append(' ');
+                }
+            }
+
+            void write_property(const js::string &key, const any &value)
+            {
+                const auto resolved = resolve(key, value);
+                if (!is_serializable(resolved))
+                {
+                    return;
+                }
+
+                begin_field(key._value);
+                write(resolved);
+            }
+
+            void write_properties(const js::object::object_type_base &values)
+            {
+                if (has_property_list)
+                {
+                    for (auto &key : property_list)
+                    {
+                        const auto found = values.find(key);
+                        if (found != values.end())
+                        {
+                            write_property(found->first, found->second);
+                        }
+                    }
+
+                    return;
+                }
+
+                for (auto &property : values)
+                {
+                    write_property(property.first, property.second);
+                }
+            }
+
+            // field of emitted interface or class, written without going through any
+            template <typename V>
+            void write_field(std::basic_string_view<char_t> key, const V &value)
+            {
+                if (replacer || has_property_list)
+                {
+                    js::string name{tstring(key)};
+                    if (!has_property_list || std::find(property_list.begin(), property_list.end(), name) != property_list.end())
+                    {
+                        write_property(name, to_any(value));
+                    }
+
+                    return;
+                }
+
+                if (!is_serializable_typed(value))
+                {
+                    return;
+                }
+
+                begin_field(key);
+                write_typed(value);
+                out.commit();
+            }
+        };
+
+        // returns false when the value has no JSON text (undefined, a function or dropped by the replacer),
+        // statically typed values without a replacer are written without conversion to any
+        template <typename T>
+        bool stringify(output_buffer &out, const T &value, const any &replacer, const any &space)
+        {
+            stringifier writer(out, replacer, space);
+            if constexpr (!std::is_same_v<T, any>)
+            {
+                if (!writer.replacer)
+                {
+                    if (!stringifier::is_serializable_typed(value))
+                    {
+                        return false;
+                    }
+
+                    writer.write_typed(value);
+                    return true;
+                }
+            }
+
+            return writer.write_root(to_any(value));
+        }
+
+    }
+
+    static struct json_t
     {
-        static void all()
+        constexpr json_t *operator->()
         {
+            return this;
         }
 
-        void _catch()
+        static any parse(const js::string &text)
         {
+#ifdef UNICODE
+            return json::parse(json::to_utf8(text._value));
+#else
+            return json::parse(text._value);
+#endif
         }
 
-        void finally()
+        // JSON.parse(text) as Interface, the compiler passes the emitted type
+        template <typename T>
+        static T parse(const js::string &text)
         {
+#ifdef UNICODE
+            return json::parse_as<T>(json::to_utf8(text._value));
+#else
+            return json::parse_as<T>(text._value);
+#endif
         }
 
-        void then()
+        template <typename T, typename R = undefined_t, typename S = undefined_t>
+        static js::string stringify(const T &value, const R &replacer = undefined, const S &space = undefined)
         {
-        }
+            json::buffer_lease lease;
+            auto &out = *lease.buffer;
+            if (!json::stringify(out, value, json::to_any(replacer), json::to_any(space)))
+            {
+                return js::string();
+            }
 
-        static void race()
-        {
+#ifdef UNICODE
+            tstring text;
+            json::append_utf8(text, out.data.data(), out.data.data() + out.data.size());
+            return js::string(std::move(text));
+#else
+            return js::string(out.data);
+#endif
         }
 
-        static void reject()
+        // streams the text to a file descriptor in chunks, returns false when there is no JSON text for the value
+        template <typename T, typename R = undefined_t, typename S = undefined_t>
+        static bool stringify_to(int fd, const T &value, const R &replacer = undefined, const S &space = undefined)
         {
+            json::output_buffer out(fd);
+            const auto written = json::stringify(out, value, json::to_any(replacer), json::to_any(space));
+            out.flush();
+            return written;
         }
+    } JSON;
 
-        static void resolve()
+    // console and process.stdout/stderr format into per-thread buffers without taking any lock. stdout on a terminal
+    // gets every complete line right away, redirected stdout is written in batches of io::batch_size (one writev for the
+    // buffered text and a long string argument, which is not copied), stderr at the end of every call. Text is UTF-8
+    namespace io
+    {
+        enum buffering
         {
-        }
-    };
+            unbuffered,
+            line_buffered,
+            fully_buffered
+        };
 
-    static struct math_t
-    {
-        static number E;
-        static number LN10;
-        static number LN2;
-        static number LOG2E;
-        static number LOG10E;
-        static number PI;
-        static number SQRT1_2;
-        static number SQRT2;
+        static constexpr std::size_t batch_size = 64 * 1024;
+        // strings from this size on are written from where they are instead of being copied into the buffer
+        static constexpr std::size_t copy_limit = 4 * 1024;
 
-        constexpr math_t *operator->()
+        struct segment
         {
-            return this;
-        }
+            const char *data;
+            std::size_t size;
+        };
 
-        static number pow(number op1, number op2)
+        // process-wide side of a file descriptor
+        struct channel
         {
-            return number(std::pow(static_cast<double>(op1), static_cast<double>(op2)));
-        }
+            int fd;
+            buffering mode;
+#ifndef JS_SINGLE_THREADED
+            // keeps batches of different threads from interleaving
+            std::mutex lock;
+#endif
 
-        static number min(number op1, number op2)
-        {
-            return number(std::min(static_cast<double>(op1), static_cast<double>(op2)));
-        }
+            channel(int fd, buffering mode) : fd(fd), mode(mode)
+            {
+            }
 
-        static number max(number op1, number op2)
-        {
-            return number(std::max(static_cast<double>(op1), static_cast<double>(op2)));
-        }
+            // output errors are dropped, logging does not throw
+            void write(segment *segments, std::size_t count)
+            {
+#ifndef JS_SINGLE_THREADED
+                std::lock_guard<std::mutex> guard(lock);
+#endif
+#ifdef _WIN32
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    auto current = segments[i].data;
+                    auto left = segments[i].size;
+                    while (left > 0)
+                    {
+                        const auto written = _write(fd, current, static_cast<unsigned int>(std::min<std::size_t>(left, INT_MAX)));
+                        if (written <= 0)
+                        {
+                            return;
+                        }
+
+                        current += written;
+                        left -= static_cast<std::size_t>(written);
+                    }
+                }
+#else
+                iovec vectors[2];
+                while (count > 0)
+                {
+                    const auto used = std::min<std::size_t>(count, 2);
+                    for (std::size_t i = 0; i < used; i++)
+                    {
+                        vectors[i] = iovec{const_cast<char *>(segments[i].data), segments[i].size};
+                    }
 
-        static number sin(number op1)
-        {
-            return number(std::sin(static_cast<double>(op1)));
-        }
+                    const auto written = ::writev(fd, vectors, static_cast<int>(used));
+                    if (written <= 0)
+                    {
+                        if (written < 0 && errno == EINTR)
+                        {
+                            continue;
+                        }
 
-        static number cos(number op1)
-        {
-            return number(std::cos(static_cast<double>(op1)));
-        }
+                        return;
+                    }
 
-        static number asin(number op1)
-        {
-            return number(std::asin(static_cast<double>(op1)));
-        }
+                    // partial write, continue from the first byte not written
+                    auto left = static_cast<std::size_t>(written);
+                    while (count > 0 && left >= segments->size)
+                    {
+                        left -= segments->size;
+                        segments++;
+                        count--;
+                    }
 
-        static number acos(number op1)
-        {
-            return number(std::acos(static_cast<double>(op1)));
-        }
+                    if (count > 0)
+                    {
+                        segments->data += left;
+                        segments->size -= left;
+                    }
+                }
+#endif
+            }
+        };
 
-        static number abs(number op1)
+        inline bool is_terminal(int fd)
         {
-            return number(std::abs(static_cast<double>(op1)));
+#ifdef _WIN32
+            return _isatty(fd) != 0;
+#else
+            return ::isatty(fd) != 0;
+#endif
         }
 
-        static number floor(number op1)
+        inline channel &standard_output()
         {
-            return number(std::floor(static_cast<double>(op1)));
+            static channel instance(1, is_terminal(1) ? line_buffered : fully_buffered);
+            return instance;
         }
 
-        static number round(number op1, int numDecimalPlaces = 0)
+        inline channel &standard_error()
         {
-            const auto mult = 10 ^ (numDecimalPlaces);
-            return number(std::floor(static_cast<double>(op1) * mult + 0.5) / mult);
+            static channel instance(2, unbuffered);
+            return instance;
         }
 
-        static number sqrt(number op1)
+        // thread side of a channel, what is left is written when the thread ends
+        struct buffer
         {
-            return number(std::sqrt(static_cast<double>(op1)));
-        }
+            channel &target;
+            std::string data;
 
-        static number tan(number op1)
-        {
-            return number(std::tan(static_cast<double>(op1)));
-        }
+            explicit buffer(channel &target) : target(target)
+            {
+                data.reserve(target.mode == fully_buffered ? batch_size + copy_limit : 256);
+            }
 
-        static number atan(number op1)
-        {
-            return number(std::atan(static_cast<double>(op1)));
-        }
+            buffer(const buffer &) = delete;
 
-        static number atan2(number op1, number op2)
+            ~buffer()
+            {
+                flush();
+            }
+
+            void flush()
+            {
+                if (data.empty())
+                {
+                    return;
+                }
+
+                segment pending{data.data(), data.size()};
+                target.write(&pending, 1);
+                data.clear();
+            }
+
+            // buffered text and a long string in one write
+            void flush_with(std::string_view text)
+            {
+                segment pending[2] = {{data.data(), data.size()}, {text.data(), text.size()}};
+                target.write(data.empty() ? pending + 1 : pending, data.empty() ? 1 : 2);
+                data.clear();
+            }
+
+            // called after every console call and write()
+            inline void end_of_call()
+            {
+                switch (target.mode)
+                {
+                case unbuffered:
+                    flush();
+                    break;
+                case line_buffered:
+                {
+                    // text after the last newline waits for its line to end
+                    const auto line_end = data.rfind('\n');
+                    if (line_end != std::string::npos)
+                    {
+                        segment pending{data.data(), line_end + 1};
+                        target.write(&pending, 1);
+                        data.erase(0, line_end + 1);
+                    }
+
+                    break;
+                }
+                case fully_buffered:
+                    if (data.size() >= batch_size)
+                    {
+                        flush();
+                    }
+
+                    break;
+                }
+            }
+        };
+
+        inline buffer &standard_output_buffer()
         {
-            return number(std::atan2(static_cast<double>(op1), static_cast<double>(op2)));
+            static thread_local buffer instance(standard_output());
+            return instance;
         }
 
-        static number log(number op1)
+        // earlier stdout text comes first when both streams go to the same place
+        inline buffer &standard_error_buffer()
         {
-            return number(std::log(static_cast<double>(op1)));
+            static thread_local buffer instance(standard_error());
+            standard_output_buffer().flush();
+            return instance;
         }
 
-        static number exp(number op1)
+        inline void append_text(buffer &out, std::basic_string_view<char_t> text)
         {
-            return number(std::exp(static_cast<double>(op1)));
+#ifdef UNICODE
+            json::encode_utf8(out.data, text);
+#else
+            if (text.size() >= copy_limit && out.target.mode == fully_buffered)
+            {
+                out.flush_with(text);
+                return;
+            }
+
+            out.data.append(text);
+#endif
         }
 
-        static number random()
+        // the runtime's text of a value, as console.log prints it
+        template <typename T>
+        void append_value(buffer &out, const T &value)
         {
-            std::default_random_engine generator;
-            std::uniform_real_distribution<double> distribution(0.0, 1.0);
-            auto rnd = distribution(generator);
-            return number(rnd);
+            if constexpr (std::is_same_v<T, js::number>)
+            {
+                if (mutable_(value).is_undefined())
+                {
+                    out.data.append("undefined", 9);
+                }
+                else
+                {
+                    json::append_number(out.data, value._value);
+                }
+            }
+            else if constexpr (std::is_same_v<T, js::string>)
+            {
+                switch (value._control)
+                {
+                case js::string::string_undefined:
+                    out.data.append("undefined", 9);
+                    break;
+                case js::string::string_null:
+                    out.data.append("null", 4);
+                    break;
+                default:
+                    append_text(out, value._value);
+                    break;
+                }
+            }
+            else if constexpr (std::is_same_v<T, js::boolean>)
+            {
+                if (value._control == js::boolean::boolean_undefined)
+                {
+                    out.data.append("undefined", 9);
+                }
+                else
+                {
+                    static_cast<bool>(mutable_(value)) ? out.data.append("true", 4) : out.data.append("false", 5);
+                }
+            }
+            else if constexpr (std::is_same_v<T, any>)
+            {
+                switch (value.get_type())
+                {
+                case any::undefined_type:
+                    out.data.append("undefined", 9);
+                    break;
+                case any::boolean_type:
+                    append_value(out, value.boolean_ref_const());
+                    break;
+                case any::pointer_type:
+                    out.data.append("null", 4);
+                    break;
+                case any::number_type:
+                    append_value(out, value.number_ref_const());
+                    break;
+                case any::string_type:
+                    append_value(out, value.string_ref_const());
+                    break;
+                case any::function_type:
+                    out.data.append("[function]", 10);
+                    break;
+                case any::array_type:
+                    out.data.append("[array]", 7);
+                    break;
+                case any::object_type:
+                    out.data.append("[object]", 8);
+                    break;
+                default:
+                    append_value(out, mutable_(value.class_ref_const())->toString());
+                    break;
+                }
+            }
+            else if constexpr (std::is_same_v<T, undefined_t>)
+            {
+                out.data.append("undefined", 9);
+            }
+            else if constexpr (std::is_same_v<T, std::nullptr_t>)
+            {
+                out.data.append("null", 4);
+            }
+            else if constexpr (std::is_same_v<T, bool>)
+            {
+                value ? out.data.append("true", 4) : out.data.append("false", 5);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                json::append_number(out.data, static_cast<double>(value));
+            }
+            else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, char_t>)
+            {
+                char digits[24];
+                const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+                out.data.append(digits, result.ptr - digits);
+            }
+            else if constexpr (std::is_convertible_v<const T &, std::basic_string_view<char_t>>)
+            {
+                append_text(out, std::basic_string_view<char_t>(value));
+            }
+            else
+            {
+                // other values keep their stream output
+                tostringstream stream;
+                stream << std::boolalpha << pass(mutable_(value));
+                append_text(out, stream.str());
+            }
         }
 
-        static number sign(number op1)
+        // arguments separated by spaces and the line ended as in console.log
+        template <class... Args>
+        void append_line(buffer &out, const Args &...args)
         {
-            auto d = static_cast<double>(op1);
-            return number(d < 0 ? -1 : d > 0 ? 1
-                                             : 0);
+            auto first = true;
+            ((first ? void(first = false) : out.data.push_back(' '), append_value(out, args)), ...);
+            out.data.push_back('\n');
         }
-    } Math;
-
-    static number E(2.718281828459045);
-    static number LN10(2.302585092994046);
-    static number LN2(0.6931471805599453);
-    static number LOG2E(1.4426950408889634);
-    static number LOG10E(0.4342944819032518);
-    static number PI(3.141592653589793);
-    static number SQRT1_2(0.7071067811865476);
-    static number SQRT2(1.4142135623730951);
-
-    template <typename I, class = std::enable_if_t<!std::is_enum_v<I>>>
-    constexpr inline I pass(I i)
-    {
-        return i;
-    }
-
-    template <typename I, class = std::enable_if_t<std::is_enum_v<I>>>
-    constexpr inline size_t pass(I i)
-    {
-        return static_cast<size_t>(i);
-    }
+    } // namespace io
 
     static struct Console
     {
-        Console()
-        {
-#ifdef UNICODE
-            std::wcout << std::boolalpha;
-#else
-            std::cout << std::boolalpha;
-#endif
-        }
-
         constexpr Console *operator->()
         {
             return this;
@@ -4644,54 +9689,71 @@ namespace js
         template <class... Args>
         void log(Args &&...args)
         {
-#ifdef UNICODE
-            auto dummy = {(std::wcout << pass(args), 0)...};
-            std::wcout << std::endl;
-#else
-            auto dummy = {(std::cout << pass(args), 0)...};
-            std::cout << std::endl;
-#endif
+            auto &out = io::standard_output_buffer();
+            io::append_line(out, args...);
+            out.end_of_call();
         }
 
         template <class... Args>
         void warn(Args &&...args)
         {
-#ifdef UNICODE
-            auto dummy = {(std::wclog << pass(args), 0)...};
-            std::wclog << std::endl;
-#else
-            auto dummy = {(std::clog << pass(args), 0)...};
-            std::clog << std::endl;
-#endif
+            error(args...);
         }
 
         template <class... Args>
         void error(Args &&...args)
         {
-#ifdef UNICODE
-            auto dummy = {(std::wcerr << pass(args), 0)...};
-            std::wcerr << std::endl;
-#else
-            auto dummy = {(std::cerr << pass(args), 0)...};
-            std::cerr << std::endl;
-#endif
+            auto &out = io::standard_error_buffer();
+            io::append_line(out, args...);
+            out.end_of_call();
         }
 
         template <class... Args>
         void debug(Args &&...args)
         {
-#ifdef UNICODE
-            auto dummy = {(std::wclog << pass(args), 0)...};
-            std::wclog << std::endl;
-#else
-            auto dummy = {(std::clog << pass(args), 0)...};
-            std::clog << std::endl;
-#endif
+            error(args...);
+        }
+
+        // writes out what this thread has buffered
+        void flush()
+        {
+            io::standard_error_buffer().flush();
         }
 
     } console;
 
-    struct XMLHttpRequest
+    static struct process_t
+    {
+        struct stream_t
+        {
+            io::buffer &(*buffer)();
+
+            constexpr stream_t *operator->()
+            {
+                return this;
+            }
+
+            template <typename T>
+            js::boolean write(const T &value)
+            {
+                auto &out = buffer();
+                io::append_value(out, value);
+                out.end_of_call();
+                return true;
+            }
+        };
+
+        // stdout and stderr are macros of <cstdio>, the compiler writes these names as _stdout and _stderr
+        stream_t _stdout{&io::standard_output_buffer};
+        stream_t _stderr{&io::standard_error_buffer};
+
+        constexpr process_t *operator->()
+        {
+            return this;
+        }
+    } process;
+
+    struct XMLHttpRequest : public ref_counted
     {
     };
 
@@ -4761,4 +9823,23 @@ namespace js
     // end of HTML
 } // namespace js
 
+// the runtime's most used template instances, defined once in jscore (core.cpp, cpplib/CMakeLists.txt); translation
+// units built with JS_CORE_LIB declare them extern. Their members are defined in the class and so inline, which extern
+// template does not keep from being instantiated, the compiler may only leave out the code of those it does not inline.
+// The compile time is saved by the precompiled core.h. The runtime defines have to match jscore's
+#define JS_CORE_INSTANCES(INSTANCE)                                                                        \
+    INSTANCE(struct js::tmpl::number<double>)                                                              \
+    INSTANCE(struct js::tmpl::string<js::tstring>)                                                         \
+    INSTANCE(struct js::tmpl::array<js::any>)                                                              \
+    INSTANCE(struct js::tmpl::array<js::number>)                                                           \
+    INSTANCE(struct js::tmpl::array<js::string>)                                                           \
+    INSTANCE(struct js::tmpl::compact_dict<js::string, js::any, js::object::K_hash, js::object::K_equal_to>) \
+    INSTANCE(struct js::tmpl::object<js::string, js::any>)
+
+#ifdef JS_CORE_LIB
+#define JS_CORE_EXTERN_INSTANCE(...) extern template __VA_ARGS__;
+JS_CORE_INSTANCES(JS_CORE_EXTERN_INSTANCE)
+#undef JS_CORE_EXTERN_INSTANCE
+#endif
+
 #endif // CORE_H
\ No newline at end of file
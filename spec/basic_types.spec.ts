@@ -55,6 +55,15 @@ I\'ll be 38 years old next month.\r\n').to.equals(new Run().test([
         console.log(list[2]);                   \
     '])));
 
+    it('Array - pop and join', () => expect('3\r\n1-2\r\nundefined\r\n,x\r\n').to.equals(new Run().test([
+        'let list: number[] = [1, 2, 3];        \
+        console.log(list.pop());                \
+        console.log(list.join("-"));            \
+        let empty: number[] = [];               \
+        console.log(empty.pop());               \
+        console.log(["", "x"].join(","));       \
+    '])));
+
     it('new Array', () => expect('1\r\n2\r\n3\r\n10\r\n').to.equals(new Run().test([
         'var list2: Array<number> = [1, 2, 3];   \
         console.log(list2[0]);                  \
@@ -73,6 +82,36 @@ I\'ll be 38 years old next month.\r\n').to.equals(new Run().test([
         console.log(list["v3"]);                   \
     '])));
 
+    it('Array - empty without storage', () => expect('0\r\n0\r\n1 0 5\r\n1 7\r\n').to.equals(new Run().test([
+        'let empty: number[] = [];              \
+        console.log(empty.length);              \
+        let count = 0;                          \
+        for (const x of empty) {                \
+            count++;                            \
+        }                                       \
+        console.log(count);                     \
+        let other: number[] = [];               \
+        empty.push(5);                          \
+        console.log(empty.length, other.length, empty[0]); \
+        const copy = other;                     \
+        copy.push(7);                           \
+        console.log(other.length, copy[0]);     \
+    '])));
+
+    it('Object - empty without storage', () => expect('0\r\n1 2\r\n').to.equals(new Run().test([
+        'let o: any = {};                           \
+        let keys = 0;                              \
+        for (const k in o) {                       \
+            keys++;                                \
+        }                                          \
+        console.log(keys);                         \
+        o["a"] = 1;                                \
+        let p: any = {};                           \
+        const q = p;                               \
+        q["b"] = 2;                                \
+        console.log(o["a"], p["b"]);               \
+    '])));
+
     it('Tuple', () => expect('hello\r\n10\r\nhello\r\n10\r\n').to.equals(new Run().test([
         'let x: [string, number];               \
         x = ["hello", 10];                      \
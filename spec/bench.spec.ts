@@ -0,0 +1,17 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+describe('Macrobenchmarks', () => {
+
+    // every program checks its own result and throws when it is wrong, paths are relative to test/
+    const footer = '\nconsole.log("ok");\n';
+
+    it('deltablue', () => expect('ok\r\n').to.equals(new Run().test(['../bench/macro/deltablue.ts'], undefined, undefined, footer)));
+
+    it('json', () => expect('ok\r\n').to.equals(new Run().test(['../bench/macro/json.ts'], undefined, undefined, footer)));
+
+    it('nbody', () => expect('ok\r\n').to.equals(new Run().test(['../bench/macro/nbody.ts'], undefined, undefined, footer)));
+
+    it('richards', () => expect('ok\r\n').to.equals(new Run().test(['../bench/macro/richards.ts'], undefined, undefined, footer)));
+});
@@ -1339,4 +1339,34 @@ describe('Classes', () => {
     const t = new Test();                                       \
     t.runTest();                                                \
     '])).to.equals('1\r\n2\r\n'));
+
+    it('Class - this kept by a constructor and returned by methods', () => expect('2 a b\r\n2\r\n').to.equals(new Run().test([
+        'const registry: Item[] = [];                                   \
+                                                                        \
+        class Item {                                                    \
+            name: string;                                               \
+            constructor(name: string) {                                 \
+                this.name = name;                                       \
+                registry.push(this);                                    \
+            }                                                           \
+                                                                        \
+            self() {                                                    \
+                return this;                                            \
+            }                                                           \
+        }                                                               \
+                                                                        \
+        class Counter {                                                 \
+            n = 0;                                                      \
+            inc() {                                                     \
+                this.n++;                                               \
+                return this;                                            \
+            }                                                           \
+        }                                                               \
+                                                                        \
+        new Item("a");                                                  \
+        let b = new Item("b").self();                                   \
+        b = null;                                                       \
+        console.log(registry.length, registry[0].name, registry[1].name); \
+        console.log(new Counter().inc().inc().n);                       \
+    '])));
 });
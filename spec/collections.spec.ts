@@ -0,0 +1,114 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+describe('Map and Set', () => {
+
+    it('Map - set, get, has, delete and size', () => expect('3\r\n2\r\ntrue\r\ntrue\r\nfalse\r\n1\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const m = new Map<string, number>();                               \
+         m.set("a", 1).set("b", 2);                                         \
+         m.set("a", 3);                                                     \
+         console.log(m.get("a"));                                           \
+         console.log(m.size);                                               \
+         console.log(m.has("b"));                                           \
+         console.log(m.delete("b"));                                        \
+         console.log(m.has("b"));                                           \
+         console.log(m.size);                                               \
+    '])));
+
+    it('Map - insertion order', () => expect('z1\r\nm3\r\na4\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const m = new Map<string, number>();                               \
+         m.set("z", 1);                                                     \
+         m.set("a", 2);                                                     \
+         m.set("m", 3);                                                     \
+         m.delete("a");                                                     \
+         m.set("a", 4);                                                     \
+         m.forEach((v, k) => console.log(k + v));                           \
+    '])));
+
+    it('Map - SameValueZero keys', () => expect('nan\r\nzero\r\n2\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const m = new Map<number, string>();                               \
+         m.set(NaN, "nan");                                                 \
+         m.set(-0, "zero");                                                 \
+         console.log(m.get(0 / 0));                                         \
+         console.log(m.get(0));                                             \
+         console.log(m.size);                                               \
+    '])));
+
+    it('Set - add, has and order', () => expect('2\r\ntrue\r\nb\r\na\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const s = new Set<string>();                                       \
+         s.add("b").add("a").add("b");                                      \
+         console.log(s.size);                                               \
+         console.log(s.has("a"));                                           \
+         s.forEach(v => console.log(v));                                    \
+    '])));
+
+    it('WeakMap - object keys by identity', () => expect('true\r\nfalse\r\n1\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         class Key { }                                                      \
+         const k1 = new Key();                                              \
+         const k2 = new Key();                                              \
+         const m = new WeakMap<Key, number>();                              \
+         m.set(k1, 1);                                                      \
+         console.log(m.has(k1));                                            \
+         console.log(m.has(k2));                                            \
+         console.log(m.get(k1));                                            \
+    '])));
+
+    it('Map - delete and add during for/of', () => expect('k0 k18 k19 new \r\n137 4\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const m = new Map<string, number>();                               \
+         for (let i = 0; i < 20; i++) {                                     \
+             m.set("k" + i, i);                                             \
+         }                                                                  \
+         let keys = "";                                                     \
+         let sum = 0;                                                       \
+         for (const [k, v] of m) {                                          \
+             if (k == "k0") {                                               \
+                 for (let i = 1; i < 18; i++) {                             \
+                     m.delete("k" + i);                                     \
+                 }                                                          \
+                 m.set("new", 100);                                         \
+             }                                                              \
+             keys += k + " ";                                               \
+             sum += v;                                                      \
+         }                                                                  \
+         console.log(keys);                                                 \
+         console.log(sum, m.size);                                          \
+    '])));
+
+    it('Set - delete and add during for/of', () => expect('69 3\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         const s = new Set<number>();                                       \
+         for (let i = 0; i < 20; i++) {                                     \
+             s.add(i);                                                      \
+         }                                                                  \
+         let sum = 0;                                                       \
+         for (const v of s) {                                               \
+             if (v == 0) {                                                  \
+                 for (let i = 1; i < 19; i++) {                             \
+                     s.delete(i);                                           \
+                 }                                                          \
+                 s.add(50);                                                 \
+             }                                                              \
+             sum += v;                                                      \
+         }                                                                  \
+         console.log(sum, s.size);                                          \
+    '])));
+
+    it('Set - variable reassigned during for/of', () => expect('a\r\nb\r\n0\r\n').to.equals(new Run().test([
+        '/// <reference lib="es2015.collection" />\n                        \
+         let s = new Set<string>();                                         \
+         s.add("a");                                                        \
+         s.add("b");                                                        \
+         for (const v of s) {                                               \
+             s = new Set<string>();                                         \
+             console.log(v);                                                \
+         }                                                                  \
+         console.log(s.size);                                               \
+    '])));
+});
@@ -0,0 +1,18 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+describe('Console', () => {
+
+    it('console.log - arguments', () => expect('a 1 true\r\nb\r\n').to.equals(new Run().test([
+        'console.log("a", 1, true);                                             \
+         console.log("b");                                                      \
+    '])));
+
+    it('console.log - numbers', () => expect('0.30000000000000004\r\n1e+21\r\n0.3333333333333333\r\n123456789 -2.5 0.000001 1e-7\r\n').to.equals(new Run().test([
+        'console.log(0.1 + 0.2);                                                \
+         console.log(1e21);                                                     \
+         console.log(1 / 3);                                                    \
+         console.log(123456789, -2.5, 0.000001, 1e-7);                          \
+    '])));
+});
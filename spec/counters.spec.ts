@@ -0,0 +1,28 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+import * as fs from 'fs-extra';
+
+describe('Slow path counters', () => {
+
+    it('JS_COUNTERS - JSON dump', () => {
+        // the program dumps its counters with the writer used for JS_COUNTERS_FILE at exit
+        fs.writeFileSync('test/native.d.ts', 'declare function dumpCounters(): void;\n');
+        fs.writeFileSync('test/native.h', '#pragma once\ninline void dumpCounters() { js::counters::write_json(std::cout); std::cout.flush(); }\n');
+        try {
+            const output = new Run().test([
+                '/// <reference path="native.d.ts" />\n' +
+                'const a: number[] = [];                     \
+                 a[9] = 1;                                   \
+                 dumpCounters();                             \
+            '], { unity: true, defines: ['JS_COUNTERS'] });
+
+            const counters = JSON.parse(output);
+            expect(1).to.equals(counters.array_grow);
+            expect(0).to.equals(counters.array_read_past_end);
+        } finally {
+            fs.unlinkSync('test/native.d.ts');
+            fs.unlinkSync('test/native.h');
+        }
+    });
+});
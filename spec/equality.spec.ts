@@ -0,0 +1,97 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+// cases follow test262 language/expressions/equals, strict-equals, addition and less-than
+describe('Equality', () => {
+
+    it('Abstract equality - null and undefined', () => expect('true\r\ntrue\r\nfalse\r\nfalse\r\n').to.equals(new Run().test([
+        'let n: any = null, u: any = undefined, z: any = 0, e: any = "";    \
+         console.log(n == u);                                               \
+         console.log(u == n);                                               \
+         console.log(u == z);                                               \
+         console.log(n == e);                                               \
+    '])));
+
+    it('Abstract equality - number, string and boolean', () => expect('true\r\ntrue\r\ntrue\r\ntrue\r\ntrue\r\ntrue\r\ntrue\r\n').to.equals(new Run().test([
+        'let one: any = 1, s1: any = "1", t: any = true, e: any = "", z: any = 0, w: any = " 1 ";  \
+         console.log(one == s1);                                            \
+         console.log(s1 == one);                                            \
+         console.log(t == one);                                             \
+         console.log(t == s1);                                              \
+         console.log(e == z);                                               \
+         console.log(w == one);                                             \
+         console.log(s1 == t);                                              \
+    '])));
+
+    it('Abstract equality - NaN', () => expect('false\r\ntrue\r\nfalse\r\n').to.equals(new Run().test([
+        'let a: any = NaN, b: any = "abc";                                  \
+         console.log(a == a);                                               \
+         console.log(a != a);                                               \
+         console.log(b == a);                                               \
+    '])));
+
+    it('Strict equality - types are not converted', () => expect('false\r\nfalse\r\ntrue\r\nfalse\r\n').to.equals(new Run().test([
+        'let one: any = 1, s1: any = "1", n: any = null, u: any = undefined; \
+         console.log(one === s1);                                           \
+         console.log(n === u);                                              \
+         console.log(one === 1);                                            \
+         console.log(s1 !== "1");                                           \
+    '])));
+
+    it('Strict equality - objects by reference', () => expect('true\r\nfalse\r\ntrue\r\nfalse\r\ntrue\r\n').to.equals(new Run().test([
+        'let a: any = [1], b: any = [1], c: any = a, o: any = {}, p: any = {}; \
+         console.log(a === a);                                              \
+         console.log(a === b);                                              \
+         console.log(a === c);                                              \
+         console.log(o === p);                                              \
+         console.log(o === o);                                              \
+    '])));
+
+    it('Static types - literal comparison', () => expect('true\r\nfalse\r\ntrue\r\n').to.equals(new Run().test([
+        'let x: number = 2, s: string = "a", b: boolean = true;             \
+         console.log(x == 2);                                               \
+         console.log(s != "a");                                             \
+         console.log(b == true);                                            \
+    '])));
+
+    it('Addition - any operands', () => expect('12\r\n21\r\n2\r\nNaN\r\n1\r\n').to.equals(new Run().test([
+        'let one: any = 1, s2: any = "2", t: any = true, u: any = undefined; \
+         console.log(one + s2);                                             \
+         console.log(s2 + one);                                             \
+         console.log(t + one);                                              \
+         console.log(one + u);                                              \
+         console.log(s2 - one);                                             \
+    '])));
+
+    it('Relational - any operands', () => expect('true\r\nfalse\r\nfalse\r\nfalse\r\n').to.equals(new Run().test([
+        'let s10: any = "10", s9: any = "9", n9: any = 9, a: any = "a";     \
+         console.log(s10 < s9);                                             \
+         console.log(s10 < n9);                                             \
+         console.log(a < n9);                                               \
+         console.log(a >= n9);                                              \
+    '])));
+
+    it('Any and static operands', () => expect('true false 51 15 4 10\r\n2 2 NaN NaN\r\ntrue false false true\r\n31 8 x2 xtrue\r\n').to.equals(new Run().test([
+        'let a: any = "5", t: any = true, u: any = undefined, n: any = 2;   \
+         console.log(a < 10, a > 10, a + 1, 1 + a, a - 1, a * 2);           \
+         console.log(t + 1, 1 + t, u + 1, u * 2);                           \
+         console.log(a == 5, a === 5, u == 0, t == 1);                      \
+         let s: any = "3";                                                  \
+         s += 1;                                                            \
+         let i: any = "7";                                                  \
+         i++;                                                               \
+         console.log(s, i, "x" + n, "x" + t);                               \
+    '])));
+
+    it('String to number conversion', () => expect('12.5 0 31 5\r\nInfinity -Infinity 0 NaN NaN\r\nNaN 5 0.5 NaN NaN\r\n').to.equals(new Run().test([
+        'const a: any = " 12.5\\n", b: any = "", c: any = "0x1F", d: any = "0b101"; \
+         console.log(a * 1, b * 1, c * 1, d * 1);                           \
+         const e: any = "1e400", f: any = "-Infinity", g: any = "1e-400";   \
+         const h: any = "inf", i: any = "nan";                              \
+         console.log(e * 1, f * 1, g * 1, h * 1, i * 1);                    \
+         const j: any = "0x1p3", k: any = "+5", l: any = ".5";              \
+         const m: any = "12abc", n: any = "-0x10";                          \
+         console.log(j * 1, k * 1, l * 1, m * 1, n * 1);                    \
+    '])));
+});
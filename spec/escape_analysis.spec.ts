@@ -0,0 +1,131 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+describe('Escape analysis', () => {
+
+    it('IIFE - captures and mutates locals', () => expect('2\r\nab\r\n').to.equals(new Run().test([
+        'function f() {                                 \
+            let count = 0;                              \
+            let name = "a";                             \
+            (() => {                                    \
+                count += 2;                             \
+                name += "b";                            \
+            })();                                       \
+            console.log(count);                         \
+            console.log(name);                          \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])));
+
+    it('forEach callback - captures and mutates locals', () => expect('6\r\n3\r\n').to.equals(new Run().test([
+        'function f() {                                 \
+            let sum = 0;                                \
+            let last = 0;                               \
+            [1, 2, 3].forEach(x => {                    \
+                sum += x;                               \
+                last = x;                               \
+            });                                         \
+            console.log(sum);                           \
+            console.log(last);                          \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])));
+
+    it('Returned closure - keeps its captured locals', () => expect('12\r\n11\r\n7\r\n').to.equals(new Run().test([
+        'function makeCounter() {                       \
+            let n = 10;                                 \
+            return () => {                              \
+                n++;                                    \
+                return n;                               \
+            };                                          \
+        }                                               \
+                                                        \
+        function makeAdder(k: number) {                 \
+            const add = (x: number) => x + k;           \
+            return add;                                 \
+        }                                               \
+                                                        \
+        const counter = makeCounter();                  \
+        counter();                                      \
+        console.log(counter());                         \
+        const other = makeCounter();                    \
+        console.log(other());                           \
+        console.log(makeAdder(3)(4));                   \
+    '])));
+
+    it('Stack allocated - local object and derived class', () => expect('6\r\n25\r\n6\r\n').to.equals(new Run().test([
+        'class Shape {                                  \
+            scale: number;                              \
+            constructor(scale: number) {                \
+                this.scale = scale;                     \
+            }                                           \
+                                                        \
+            area(): number {                            \
+                return 0;                               \
+            }                                           \
+        }                                               \
+                                                        \
+        class Square extends Shape {                    \
+            side: number;                               \
+            constructor(side: number) {                 \
+                super(2);                               \
+                this.side = side;                       \
+            }                                           \
+                                                        \
+            area(): number {                            \
+                return this.side * this.scale;          \
+            }                                           \
+        }                                               \
+                                                        \
+        function f() {                                  \
+            const s = new Square(3);                    \
+            const o = { x: 3, y: 4 };                   \
+            const a = [1, 2, 3];                        \
+            let t = 0;                                  \
+            for (const v of a) {                        \
+                t += v;                                 \
+            }                                           \
+                                                        \
+            console.log(s.area());                      \
+            console.log(o.x * o.x + o.y * o.y);         \
+            console.log(t);                             \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])));
+
+    it('Stored in outer array or object - stays on heap', () => expect('9\r\n2\r\ntrue\r\n').to.equals(new Run().test([
+        'class Point {                                  \
+            x: number;                                  \
+            y: number;                                  \
+            constructor(x: number, y: number) {         \
+                this.x = x;                             \
+                this.y = y;                             \
+            }                                           \
+        }                                               \
+                                                        \
+        const points: Point[] = [];                     \
+        const holder = { last: <Point>null };           \
+                                                        \
+        function add(i: number) {                       \
+            const p = new Point(i, i * 2);              \
+            points.push(p);                             \
+            const q = new Point(i, 0);                  \
+            holder.last = q;                            \
+        }                                               \
+                                                        \
+        add(1);                                         \
+        add(2);                                         \
+        let t = 0;                                      \
+        for (const p of points) {                       \
+            t += p.x + p.y;                             \
+        }                                               \
+                                                        \
+        console.log(t);                                 \
+        console.log(holder.last.x);                     \
+        console.log(points[0] instanceof Point);        \
+    '])));
+});
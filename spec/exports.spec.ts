@@ -1,6 +1,7 @@
 import { Run } from '../src/compiler';
 import { expect } from 'chai';
 import { describe, it } from 'mocha';
+import * as fs from 'fs-extra';
 
 describe('Export', () => {
 
@@ -40,6 +41,30 @@ describe('Export', () => {
     console.log(myValidator.isAcceptable("test"));  \
     '])));
 
+    it('Class export (unity)', () => expect('false\r\n').to.equals(new Run().test([
+    'import { ZipCodeValidator } from "./test_1";    \
+    const myValidator = new ZipCodeValidator();     \
+    console.log(myValidator.isAcceptable("test"));  \
+    ',
+        'export class ZipCodeValidator {            \
+            isAcceptable(s: string): boolean {      \
+                return false;                       \
+            }                                       \
+        }                                           \
+    '], { unity: true })));
+
+    it('Class export (jobs)', () => expect('false\r\n').to.equals(new Run().test([
+        'export class ZipCodeValidator {            \
+            isAcceptable(s: string): boolean {      \
+                return false;                       \
+            }                                       \
+        }                                           \
+    ',
+    'import { ZipCodeValidator } from "./test_0";    \
+    const myValidator = new ZipCodeValidator();     \
+    console.log(myValidator.isAcceptable("test"));  \
+    '], { jobs: 2 })));
+
     // can't implement it now
     it.skip('Class export - alias', () => expect('false\r\n').to.equals(new Run().test([
         'export class ZipCodeValidator {            \
@@ -52,4 +77,19 @@ describe('Export', () => {
     const myValidator = new Test.ZipCodeValidator();\
     console.log(myValidator.isAcceptable("test"));  \
     '])));
+
+    it('Reference to a declaration file (unity)', () => {
+        // the header of the declaration file is written by hand, unity.cpp includes it before the program
+        fs.writeFileSync('test/native.d.ts', 'declare function twice(n: number): number;\n');
+        fs.writeFileSync('test/native.h', '#pragma once\ninline js::number twice(js::number n) { return n + n; }\n');
+        try {
+            expect('42\r\n').to.equals(new Run().test([
+                '/// <reference path="native.d.ts" />\n' +
+                'console.log(twice(21));                     \
+            '], { unity: true }));
+        } finally {
+            fs.unlinkSync('test/native.d.ts');
+            fs.unlinkSync('test/native.h');
+        }
+    });
 });
@@ -14,4 +14,47 @@ describe('InstanceOf', () => {
         console.log(ok2 ? "true" : "false");        \
     '], { jslib: true })).to.equals('true\r\ntrue\r\ntrue\r\n'));
 
+    it('InstanceOf: deep hierarchy and siblings', () => expect(new Run().test([
+        'class A { a = 1; }                             \
+        class B extends A { b = 2; }                    \
+        class C extends B { c = 3; }                    \
+        class D extends C { d = 4; }                    \
+        class S extends A { s = 5; }                    \
+        class T extends B { t = 6; }                    \
+                                                        \
+        const a: A = new A();                           \
+        const d: A = new D();                           \
+        const s: A = new S();                           \
+        const t: A = new T();                           \
+        console.log(d instanceof A, d instanceof B, d instanceof C, d instanceof D, d instanceof S); \
+        console.log(s instanceof A, s instanceof B, s instanceof S, s instanceof T);                 \
+        console.log(t instanceof B, t instanceof C, t instanceof D, t instanceof T);                 \
+        console.log(a instanceof A, a instanceof B, a instanceof S);                                 \
+        if (d instanceof C) {                           \
+            console.log(d.c);                           \
+        }                                               \
+    '])).to.equals('true true true true false\r\ntrue false true false\r\ntrue false false true\r\ntrue false false\r\n3\r\n'));
+
+    const files = [
+        'export class Base { name(): string { return "base"; } }           \
+        export class Middle extends Base { name(): string { return "middle"; } } \
+        export class Unrelated { }                                          \
+    ',
+        'import { Base, Middle, Unrelated } from "./test_0";                \
+        class Leaf extends Middle { name(): string { return "leaf"; } }     \
+        class Other extends Base { }                                        \
+        const items: Base[] = [new Base(), new Middle(), new Leaf(), new Other()]; \
+        for (const item of items) {                                         \
+            console.log(item.name(), item instanceof Middle, item instanceof Leaf, item instanceof Other); \
+        }                                                                   \
+        const u: any = new Unrelated();                                     \
+        console.log(u instanceof Base, u instanceof Unrelated);             \
+    '];
+
+    const expected = 'base false false false\r\nmiddle true false false\r\nleaf true true false\r\nbase false false true\r\n'
+        + 'false true\r\n';
+
+    it('InstanceOf: hierarchy over two files', () => expect(new Run().test(files)).to.equals(expected));
+
+    it('InstanceOf: hierarchy over two files (jobs)', () => expect(new Run().test(files, { jobs: 2 })).to.equals(expected));
 });
@@ -0,0 +1,99 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+
+describe('JSON', () => {
+
+    it('JSON.parse - scalars', () => expect('150\r\n-0.25\r\ntrue\r\nabc\r\n').to.equals(new Run().test([
+        'console.log(JSON.parse("1.5e2"));                                  \
+         console.log(JSON.parse(" -0.25 "));                                \
+         console.log(JSON.parse("true"));                                   \
+         console.log(JSON.parse("\\"abc\\""));                              \
+    '])));
+
+    it('JSON.parse - objects and arrays', () => expect('2\r\nd\r\n3\r\n').to.equals(new Run().test([
+        'const v = JSON.parse(\'{"a": [1, 2, 3], "b": {"c": "d"}, "e": []}\'); \
+         console.log(v.a[1]);                                               \
+         console.log(v.b.c);                                                \
+         console.log(v.a[2]);                                               \
+    '])));
+
+    it('JSON.parse - string escapes', () => expect('a"b\r\nc\\d\r\nAB\r\n{[,:]}\r\n').to.equals(new Run().test([
+        'const v = JSON.parse(\'["a\\\\"b", "c\\\\\\\\d", "\\\\u0041\\\\u0042", "{[,:]}"]\'); \
+         console.log(v[0]);                                                 \
+         console.log(v[1]);                                                 \
+         console.log(v[2]);                                                 \
+         console.log(v[3]);                                                 \
+    '])));
+
+    it('JSON.stringify - values', () => expect('[1,"a\\"b\\n",true,null,0.1,1e+21]\r\n{"a":[]}\r\ntrue\r\n').to.equals(new Run().test([
+        'console.log(JSON.stringify([1, "a\\"b\\n", true, null, 0.1, 1e21]));     \
+         console.log(JSON.stringify({ a: [] }));                             \
+         console.log(JSON.stringify(undefined) === undefined);               \
+    '])));
+
+    it('JSON.stringify - space', () => expect('[\r\n  1,\r\n  {\r\n    "b": []\r\n  }\r\n]\r\n').to.equals(new Run().test([
+        'console.log(JSON.stringify(JSON.parse("[1,{\\"b\\":[]}]"), null, 2));   \
+    '])));
+
+    it('JSON.stringify - round trip', () => expect('true\r\n').to.equals(new Run().test([
+        'const text = \'{"a":{"b":[1.5,-2,"\\\\u0001"]}}\';                  \
+         console.log(JSON.stringify(JSON.parse(text)) === text);             \
+    '])));
+
+    it('JSON.parse - interface', () => expect('7\r\ntrue\r\na\r\n2\r\n').to.equals(new Run().test([
+        'interface Item { name: string; count: number; }                    \
+         interface Order { id: number; paid: boolean; items: Item[]; }      \
+         const order = JSON.parse(\'{"x": {"y": [1]}, "items": [{"count": 2, "name": "a"}], "paid": true, "id": 7}\') as Order; \
+         console.log(order.id);                                             \
+         console.log(order.paid);                                           \
+         console.log(order.items[0].name);                                  \
+         console.log(order.items[0].count);                                 \
+    '])));
+
+    it('JSON.stringify - interface and class fields', () => expect('{"x":1,"y":2}\r\n{"text":"a","at":{"x":1,"y":2}}\r\n').to.equals(new Run().test([
+        'interface Point { x: number; y: number; }                          \
+         class Label { constructor(public text: string, public at: Point) {} } \
+         const p: Point = { x: 1, y: 2 };                                   \
+         console.log(JSON.stringify(p));                                    \
+         console.log(JSON.stringify(new Label("a", p)));                    \
+    '])));
+
+    it('JSON.parse - malformed input throws', () => expect('SyntaxError: JSON.parse: expected property name\r\nSyntaxError: JSON.parse: unexpected end of input\r\ndone\r\n').to.equals(new Run().test([
+        'const inputs = ["{1: 2}", "[1, 2"];                                \
+         for (const text of inputs) {                                       \
+             try {                                                          \
+                 JSON.parse(text);                                          \
+                 console.log("parsed");                                     \
+             } catch (e) {                                                  \
+                 console.log(e);                                            \
+             }                                                              \
+         }                                                                  \
+         console.log("done");                                               \
+    '])));
+
+    it('JSON.stringify - cyclic value throws', () => expect('TypeError: JSON.stringify: cyclic object value\r\n{"b":[1]}\r\n').to.equals(new Run().test([
+        'const a: any = { name: "a" };                                      \
+         a.self = a;                                                        \
+         try {                                                              \
+             console.log(JSON.stringify(a));                                \
+         } catch (e) {                                                      \
+             console.log(e);                                                \
+         }                                                                  \
+         console.log(JSON.stringify({ b: [1] }));                           \
+    '])));
+
+    it('JSON.parse - interface with mismatched types throws', () => expect('TypeError: JSON.parse: expected number\r\nTypeError: JSON.parse: expected array\r\n3\r\n').to.equals(new Run().test([
+        'interface Item { name: string; count: number; }                    \
+         interface Order { id: number; items: Item[]; }                     \
+         const inputs = [\'{"id": "7", "items": []}\', \'{"id": 7, "items": {}}\', \'{"id": 3, "items": []}\']; \
+         for (const text of inputs) {                                       \
+             try {                                                          \
+                 const order = JSON.parse(text) as Order;                   \
+                 console.log(order.id);                                     \
+             } catch (e) {                                                  \
+                 console.log(e);                                            \
+             }                                                              \
+         }                                                                  \
+    '])));
+});
@@ -56,4 +56,60 @@ describe('Numbers', () => {
          a += 1;                                \
          console.log(a);                        \
     '])).to.equals('false\r\nNaN\r\nNaN\r\n'));
+
+    it('Math.random - range and sequence', () => expect(new Run().test([
+        'const a = Math.random();               \
+         const b = Math.random();               \
+         console.log(a >= 0 && a < 1);          \
+         console.log(b >= 0 && b < 1);          \
+         console.log(a !== b);                  \
+    '])).to.equals('true\r\ntrue\r\ntrue\r\n'));
+
+
+    it('fillRandom - Float64Array in [0, 1)', () => expect(new Run().test([
+        'const a = new Float64Array(1000);      \
+         fillRandom(a);                         \
+         let inRange = true;                    \
+         let allEqual = true;                   \
+         for (let i = 0; i < a.length; i++) {   \
+             if (a[i] < 0 || a[i] >= 1) {       \
+                 inRange = false;               \
+             }                                  \
+             if (a[i] !== a[0]) {               \
+                 allEqual = false;              \
+             }                                  \
+         }                                      \
+         console.log(inRange, allEqual);        \
+    '])).to.equals('true false\r\n'));
+
+    it('fillRandom - Uint32Array random bits', () => expect(new Run().test([
+        'const a = new Uint32Array(64);         \
+         fillRandom(a);                         \
+         let set = 0;                           \
+         for (let i = 0; i < a.length; i++) {   \
+             if (a[i] !== 0) {                  \
+                 set++;                         \
+             }                                  \
+         }                                      \
+         console.log(set > 60);                 \
+    '])).to.equals('true\r\n'));
+
+    it('crypto.getRandomValues - 65536 bytes quota', () => expect(new Run().test([
+        'const a = new Uint32Array(16384);      \
+         crypto.getRandomValues(a);             \
+         let set = 0;                           \
+         for (let i = 0; i < a.length; i++) {   \
+             if (a[i] !== 0) {                  \
+                 set++;                         \
+             }                                  \
+         }                                      \
+         console.log(set > 16000);              \
+         try {                                  \
+             const b = new Uint32Array(16385);  \
+             crypto.getRandomValues(b);         \
+             console.log("no throw");           \
+         } catch (e) {                          \
+             console.log(e);                    \
+         }                                      \
+    '])).to.equals('true\r\nQuotaExceededError: crypto.getRandomValues: quota exceeded\r\n'));
 });
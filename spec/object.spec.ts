@@ -46,4 +46,33 @@ describe('Objects', () => {
         console.log(mergedOptions.comparisonFunction);                      \
         console.log(mergedOptions.b1);                                      \
     '])));
+
+    it('object - literal of interface type', () => expect('1\r\n2\r\n').to.equals(new Run().test([
+        'interface Point {                                                  \
+            x: number;                                                      \
+            y: number;                                                      \
+        }                                                                   \
+                                                                            \
+        let x = 1;                                                          \
+        let p: Point = { x, y: 2 };                                         \
+        console.log(p.x);                                                   \
+        console.log(p.y);                                                   \
+    '])));
+
+    it('object - literal of interface type, initializers in order', () => expect('x\r\ny\r\nlabel\r\n1 2 3\r\n').to.equals(new Run().test([
+        'interface Entry {                                                  \
+            a: number;                                                      \
+            b: number;                                                      \
+            c: number;                                                      \
+        }                                                                   \
+                                                                            \
+        let n = 0;                                                          \
+        function next(name: string) {                                       \
+            console.log(name);                                              \
+            return ++n;                                                     \
+        }                                                                   \
+                                                                            \
+        const e: Entry = { a: next("x"), b: next("y"), c: next("label") };  \
+        console.log(e.a, e.b, e.c);                                         \
+    '])));
 });
@@ -153,6 +153,17 @@ describe('Arithmetic Operators', () => {
         console.log(r);                             \
     '])));
 
+    it('Logical (static types)', () => expect('0\r\n5\r\nb\r\n\r\n7\r\n').to.equals(new Run().test([
+        'let x: number = 0, y: number = 5;          \
+        let s: string = "", t: string = "b";        \
+        let u: number;                              \
+        console.log(x && y);                        \
+        console.log(x || y);                        \
+        console.log(s || t);                        \
+        console.log(s ?? t);                        \
+        console.log(u ?? 7);                        \
+    '])));
+
     it('In operator (array)', () => expect('true\r\n').to.equals(new Run().test([
         'let c = [1, 2, 3];                         \
         let b = 2 in c;                             \
@@ -105,6 +105,47 @@ describe('Statements', () => {
         }                                                       \
     '])).to.contains('John').contains('Doe').contains('25'));
 
+    it('for/in - property order', () => expect(new Run().test([
+        'let o: any = {};                                       \
+        o["b"] = 1;                                             \
+        o["10"] = 2;                                            \
+        o["a"] = 3;                                             \
+        o["2"] = 4;                                             \
+        for (const x in o) {                                    \
+            console.log(x);                                     \
+        }                                                       \
+    '])).to.equals('2\r\n10\r\nb\r\na\r\n'));
+
+    it('for/in - property order after delete and re-insert', () => expect(new Run().test([
+        'let o: any = {};                                       \
+        o["b"] = 1;                                             \
+        o["10"] = 2;                                            \
+        o["a"] = 3;                                             \
+        o["2"] = 4;                                             \
+        delete o["10"];                                         \
+        delete o["b"];                                          \
+        o["10"] = 5;                                            \
+        o["b"] = 6;                                             \
+        o["1"] = 7;                                             \
+        for (const x in o) {                                    \
+            console.log(x + "=" + o[x]);                        \
+        }                                                       \
+    '])).to.equals('1=7\r\n2=4\r\n10=5\r\na=3\r\nb=6\r\n'));
+
+    it('for/in - keys deleted in the body are skipped', () => expect(new Run().test([
+        'let o: any = {};                                       \
+        o["a"] = 1;                                             \
+        o["b"] = 2;                                             \
+        o["c"] = 3;                                             \
+        for (const x in o) {                                    \
+            console.log(x);                                     \
+            if (x == "a") {                                     \
+                delete o["b"];                                  \
+                o["d"] = 4;                                     \
+            }                                                   \
+        }                                                       \
+    '])).to.equals('a\r\nc\r\n'));
+
     it('simple for/in (global) 1', () => expect(new Run().test([
         'var person = {fname:"John", lname:"Doe", age:25};      \
                                                                 \
@@ -293,4 +334,211 @@ describe('Statements', () => {
     }                                                           \
     console.log("done");                                        \
     '])).to.equals('done\r\n'));
+
+    it('for - integer counter, length bound while the body pushes', () => expect(new Run().test([
+        'function f() {                                 \
+            const a = [1, 2, 3];                        \
+            let t = 0;                                  \
+            for (let i = 0; i < a.length; i++) {        \
+                if (i < 3) {                            \
+                    a.push(i * 10);                     \
+                }                                       \
+                                                        \
+                t += a[i];                              \
+            }                                           \
+                                                        \
+            console.log(t);                             \
+            console.log(a.length);                      \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('36\r\n6\r\n'));
+
+    it('for - integer counter, += step near int32 boundary', () => expect(new Run().test([
+        'function f() {                                 \
+            for (let i = 2147483640; i < 2147483647; i += 3) { \
+                console.log(i + 1);                     \
+            }                                           \
+                                                        \
+            let n = 0;                                  \
+            for (let j = 2147483600; j <= 2147483647; j += 20) { \
+                n++;                                    \
+            }                                           \
+                                                        \
+            console.log(n);                             \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('2147483641\r\n2147483644\r\n2147483647\r\n3\r\n'));
+
+    it('for - counter captured by a closure', () => expect(new Run().test([
+        'function f() {                                 \
+            let t = 0;                                  \
+            for (let i = 0; i < 3; i++) {               \
+                const half = () => i / 2;               \
+                t += half();                            \
+            }                                           \
+                                                        \
+            console.log(t);                             \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('1.5\r\n'));
+
+    it('for - counter in double arithmetic', () => expect(new Run().test([
+        'function f() {                                 \
+            let t = 0;                                  \
+            for (let i = 0; i < 5; i++) {               \
+                t += i / 2;                             \
+                if (i == 3) {                           \
+                    console.log(i / 2);                 \
+                    console.log(i * 0.1 + 1);           \
+                }                                       \
+            }                                           \
+                                                        \
+            console.log(t);                             \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('1.5\r\n1.3\r\n5\r\n'));
+
+    it('for/of (array) - body pushes and then reads a property', () => expect(new Run().test([
+        'class P {                                      \
+            y: number;                                  \
+            constructor(y: number) {                    \
+                this.y = y;                             \
+            }                                           \
+        }                                               \
+                                                        \
+        function f() {                                  \
+            const arr = [1, 2, 3];                      \
+            const p = new P(10);                        \
+            let total = 0;                              \
+            for (const x of arr) {                      \
+                if (x < 3) {                            \
+                    total += arr.push(x * 100) + p.y;   \
+                }                                       \
+                                                        \
+                total += x;                             \
+            }                                           \
+                                                        \
+            console.log(total);                         \
+            console.log(arr.length);                    \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('335\r\n5\r\n'));
+
+    it('for/of (array) - body removes elements', () => expect(new Run().test([
+        'function f() {                                 \
+            const arr = [1, 2, 3, 4];                   \
+            const o = { y: 1 };                         \
+            let total = 0;                              \
+            for (const x of arr) {                      \
+                if (x == 1) {                           \
+                    arr.pop();                          \
+                }                                       \
+                                                        \
+                total += x + o.y;                       \
+            }                                           \
+                                                        \
+            console.log(total);                         \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('9\r\n'));
+
+    it('for/of (array) - method of a local named like a library object pushes', () => expect(new Run().test([
+        'class Tally {                                  \
+            items: number[];                            \
+            constructor(items: number[]) {              \
+                this.items = items;                     \
+            }                                           \
+                                                        \
+            max(v: number) {                            \
+                this.items.push(v);                     \
+                return v;                               \
+            }                                           \
+        }                                               \
+                                                        \
+        function f() {                                  \
+            const arr = [1, 2, 3];                      \
+            const Math = new Tally(arr);                \
+            let total = 0;                              \
+            for (const x of arr) {                      \
+                if (x == 1) {                           \
+                    Math.max(4);                        \
+                }                                       \
+                                                        \
+                total += x;                             \
+            }                                           \
+                                                        \
+            console.log(total);                         \
+            console.log(arr.length);                    \
+        }                                               \
+                                                        \
+        f();                                            \
+    '])).to.equals('10\r\n4\r\n'));
+
+    it('switch (any) - cases of mixed types compare strictly', () => expect(new Run().test([
+        'function kind(v: any): string {                \
+            switch (v) {                                \
+                case 1: return "one";                   \
+                case "1": return "string one";          \
+                case true: return "true";               \
+                default: return "other";                \
+            }                                           \
+        }                                               \
+                                                        \
+        console.log(kind(1));                           \
+        console.log(kind("1"));                         \
+        console.log(kind(true));                        \
+        console.log(kind(false));                       \
+        console.log(kind({}));                          \
+    '])).to.equals('one\r\nstring one\r\ntrue\r\nother\r\nother\r\n'));
+
+    it('switch (any) - undefined and boolean values with number cases', () => expect(new Run().test([
+        'function kind(v: any): string {                \
+            switch (v) {                                \
+                case 0: return "zero";                  \
+                case 1: return "one";                   \
+            }                                           \
+                                                        \
+            return "none";                              \
+        }                                               \
+                                                        \
+        let u: any;                                     \
+        console.log(kind(u));                           \
+        console.log(kind(null));                        \
+        console.log(kind(false));                       \
+        console.log(kind(true));                        \
+        console.log(kind("0"));                         \
+        console.log(kind(0));                           \
+    '])).to.equals('none\r\nnone\r\nnone\r\nnone\r\nnone\r\nzero\r\n'));
+
+    it('switch (string) - perfect hash and repeated labels', () => expect(new Run().test([
+        'function op(s: string): number {               \
+            switch (s) {                                \
+                case "add": return 1;                   \
+                case "sub": return 2;                   \
+                case "mul": return 3;                   \
+                case "div": return 4;                   \
+                case "": return 5;                      \
+                default: return 0;                      \
+            }                                           \
+        }                                               \
+                                                        \
+        function repeated(s: string): number {          \
+            switch (s) {                                \
+                case "a": return 1;                     \
+                case "b": return 2;                     \
+                case "a": return 3;                     \
+            }                                           \
+                                                        \
+            return 0;                                   \
+        }                                               \
+                                                        \
+        console.log(op("add"), op("sub"), op("mul"), op("div"), op(""), op("mod"), op("ad")); \
+        console.log(repeated("a"), repeated("b"), repeated("c"));                             \
+    '])).to.equals('1 2 3 4 5 0 0\r\n1 2 0\r\n'));
 });
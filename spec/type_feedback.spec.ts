@@ -0,0 +1,49 @@
+import { Run } from '../src/compiler';
+import { expect } from 'chai';
+import { describe, it } from 'mocha';
+import * as fs from 'fs-extra';
+
+describe('Type feedback', () => {
+
+    const source =
+        'function add(a: any, b: any) { return a + b; }                         \
+         function less(a: any, b: any) { return a < b; }                        \
+         console.log(add(1, 2));                                                \
+         console.log(add("a", 2));                                              \
+         console.log(less(1, 2), less("b", "a"));                               \
+    ';
+
+    // location of an operand in the only line of the source
+    const location = (expression: string, offset = 0) => 'test_0.ts:1:' + (source.indexOf(expression) + offset + 1);
+
+    it('profile_generate - records types', () => {
+        const profileFile = 'test/typescript2cxx.profile';
+        if (fs.existsSync(profileFile)) {
+            fs.unlinkSync(profileFile);
+        }
+
+        expect('3\r\na2\r\ntrue false\r\n').to.equals(new Run().test([source], { profile_generate: true }));
+
+        const profile = fs.readFileSync(profileFile).toString();
+        fs.unlinkSync(profileFile);
+        expect(profile).to.contain(location('a + b') + '\tnumber\t1');
+        expect(profile).to.contain(location('a + b') + '\tstring\t1');
+    });
+
+    it('profile_use - number fast path', () => {
+        const profileFile = 'test/test.profile';
+        fs.writeFileSync(profileFile, [
+            location('a + b') + '\tnumber\t10',
+            location('a + b', 4) + '\tnumber\t10',
+            location('a < b') + '\tnumber\t10',
+            location('a < b', 4) + '\tnumber\t10'
+        ].join('\n'));
+
+        try {
+            // values of other types take the generic operator
+            expect('3\r\na2\r\ntrue false\r\n').to.equals(new Run().test([source], { profile_use: 'test.profile' }));
+        } finally {
+            fs.unlinkSync(profileFile);
+        }
+    });
+});
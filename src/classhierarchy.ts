@@ -0,0 +1,124 @@
+import * as ts from 'typescript';
+import * as crypto from 'crypto';
+
+/**
+ * Class ids by file and qualified class name, nextId is the next id for a new class. program is a random tag of the
+ * program, ids of two programs (a library compiled on its own and its user) can be the same, tags tell them apart
+ */
+export interface ClassIdTable {
+    program: number;
+    nextId: number;
+    files: { [fileName: string]: { [className: string]: number } };
+}
+
+export class ClassHierarchy {
+
+    public constructor(private typeChecker: ts.TypeChecker) {
+    }
+
+    private static isTopLevel(node: ts.Node): boolean {
+        return node.parent
+            && (node.parent.kind === ts.SyntaxKind.SourceFile || node.parent.kind === ts.SyntaxKind.ModuleBlock);
+    }
+
+    private static getClasses(sourceFile: ts.SourceFile): ts.ClassDeclaration[] {
+        const classes: ts.ClassDeclaration[] = [];
+        const visit = (node: ts.Node) => {
+            if (node.kind === ts.SyntaxKind.ClassDeclaration
+                && (<ts.ClassDeclaration>node).name
+                && ClassHierarchy.isTopLevel(node)
+                && !(ts.getCombinedModifierFlags(<ts.Declaration>node) & ts.ModifierFlags.Ambient)) {
+                classes.push(<ts.ClassDeclaration>node);
+            }
+
+            ts.forEachChild(node, visit);
+        };
+
+        visit(sourceFile);
+        return classes;
+    }
+
+    // name of a class within its file, with the namespaces it is declared in
+    private static getQualifiedName(node: ts.ClassDeclaration): string {
+        let name = node.name.text;
+        for (let parent = node.parent; parent; parent = parent.parent) {
+            if (parent.kind === ts.SyntaxKind.ModuleDeclaration) {
+                name = (<ts.ModuleDeclaration>parent).name.text + '.' + name;
+            }
+        }
+
+        return name;
+    }
+
+    /**
+     * Ids of the classes of the file and of their bases, see assignClassIds
+     */
+    public static getClassIds(sourceFile: ts.SourceFile): string {
+        return ClassHierarchy.getClasses(sourceFile)
+            .map(c => (<any>c).__class_display.join('-'))
+            .join(',');
+    }
+
+    /**
+     * Numbers classes of all files and marks declarations with __class_id and __class_display, the ids of the
+     * bases from the root of the 'extends' tree down to the class itself, so a class is a subclass of the class
+     * with id I at depth D when its display has I at D.
+     * Ids are unique for the whole program, its tag is written into every display and class_cast falls back to
+     * dynamic_cast for classes with another tag. A class keeps the id it has in the table (loaded from the manifest of
+     * the output folder), only new classes get new ids, so an edit changes the output of the files it touches
+     * and of files with classes derived from them, not of the whole program.
+     */
+    public assignClassIds(sourceFiles: ReadonlyArray<ts.SourceFile>, table?: ClassIdTable): ClassIdTable {
+        const assigned: ClassIdTable = {
+            program: table && table.program || crypto.randomBytes(4).readUInt32LE(0) || 1,
+            nextId: table && table.nextId || 1,
+            files: {}
+        };
+        const classes: ts.ClassDeclaration[] = [];
+        sourceFiles.filter(s => !s.isDeclarationFile).forEach(s => {
+            const known = table && table.files[s.fileName] || {};
+            const ids: { [className: string]: number } = {};
+            ClassHierarchy.getClasses(s).forEach(c => {
+                const name = ClassHierarchy.getQualifiedName(c);
+                ids[name] = known[name] || assigned.nextId++;
+                (<any>c).__class_id = ids[name];
+                (<any>c).__class_program = assigned.program;
+                classes.push(c);
+            });
+
+            if (Object.keys(ids).length) {
+                assigned.files[s.fileName] = ids;
+            }
+        });
+
+        const display = (node: ts.ClassDeclaration): number[] => {
+            if (!(<any>node).__class_display) {
+                const base = this.getBaseClass(node);
+                (<any>node).__class_display = (base && classes.indexOf(base) >= 0 ? display(base) : [])
+                    .concat([(<any>node).__class_id]);
+            }
+
+            return (<any>node).__class_display;
+        };
+
+        classes.forEach(display);
+        return assigned;
+    }
+
+    private getBaseClass(node: ts.ClassDeclaration): ts.ClassDeclaration {
+        const extendsClause = (node.heritageClauses || []).find(h => h.token === ts.SyntaxKind.ExtendsKeyword);
+        if (!extendsClause || !extendsClause.types.length) {
+            return undefined;
+        }
+
+        let symbol = this.typeChecker.getSymbolAtLocation(extendsClause.types[0].expression);
+        if (symbol && symbol.flags & ts.SymbolFlags.Alias) {
+            symbol = this.typeChecker.getAliasedSymbol(symbol);
+        }
+
+        const declaration = symbol && symbol.valueDeclaration;
+        return declaration && declaration.kind === ts.SyntaxKind.ClassDeclaration
+            ? <ts.ClassDeclaration>declaration
+            : undefined;
+    }
+}
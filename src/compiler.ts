@@ -1,8 +1,10 @@
 import * as ts from 'typescript';
 import * as fs from 'fs-extra';
 import { spawn } from 'cross-spawn';
-import { Emitter } from './emitter';
+import { EmitJobs } from './emitjobs';
+import { ClassHierarchy } from './classhierarchy';
 import { Helpers } from './helpers';
+import { OutputCache } from './outputcache';
 
 export enum ForegroundColorEscapeSequences {
     Grey = '\u001b[90m',
@@ -50,8 +52,12 @@ const resetEscapeSequence = '\u001b[0m';
 
 export class Run {
 
+    // output of -unity
+    public static readonly unityFileName = 'unity.cpp';
+
     private formatHost: ts.FormatDiagnosticsHost;
     private versions: Map<string, number> = new Map<string, number>();
+    private classIds: Map<string, string> = new Map<string, string>();
 
     public constructor() {
         this.formatHost = <ts.FormatDiagnosticsHost>{
@@ -71,7 +77,7 @@ export class Run {
 
             const option = item.substring(1);
             options[option] = true;
-            if (option  === 'run_on_compile') {
+            if (Run.hasValue(option, cmdLineArgs[i + 1])) {
                 options[option] = cmdLineArgs[++i];
             }
         }
@@ -84,7 +90,7 @@ export class Run {
         for (let i = 2; i < cmdLineArgs.length; i++) {
             const item = cmdLineArgs[i];
             if (!item || item[0] === '-') {
-                if (item === '-run_on_compile') {
+                if (item && Run.hasValue(item.substring(1), cmdLineArgs[i + 1])) {
                     ++i;
                 }
 
@@ -101,6 +107,19 @@ export class Run {
         return files.length === 1 ? files[0] : files;
     }
 
+    // options followed by a value, the number of -jobs is optional
+    private static hasValue(option: string, next: string): boolean {
+        switch (option) {
+            case 'run_on_compile':
+            case 'profile_use':
+                return true;
+            case 'jobs':
+                return /^\d+$/.test(next || '');
+        }
+
+        return false;
+    }
+
     public run(sourcesOrConfigFile: string[] | string, cmdLineOptions: any): void {
 
         if (typeof (sourcesOrConfigFile) === 'string') {
@@ -236,75 +255,105 @@ export class Run {
             rootFolder += '/';
         }
 
-        sourceFiles.filter(s => !s.fileName.endsWith('.d.ts') && sources.some(sf => s.fileName.endsWith(sf))).forEach(s => {
-            // track version
-            const paths = sources.filter(sf => s.fileName.endsWith(sf));
-            (<any>s).__path = paths[0];
-            const fileVersion = (<any>s).version;
-            if (fileVersion) {
-                const latestVersion = this.versions[s.fileName];
-                if (latestVersion && latestVersion === fileVersion) {
-                    if (!cmdLineOptions.suppressOutput) {
-                        console.log(
-                            'File: '
-                            + ForegroundColorEscapeSequences.White
-                            + s.fileName
-                            + resetEscapeSequence
-                            + ' current version:'
-                            + fileVersion
-                            + ', last version:'
-                            + latestVersion
-                            + '. '
-                            + ForegroundColorEscapeSequences.Red
-                            + 'Skipped.'
-                            + resetEscapeSequence);
+        const outputs = new OutputCache(outDir);
+
+        // ids have to be the same in all files, so all classes are numbered before emitting; classes keep the ids of
+        // the last compile and worker threads (-jobs) get the same ones
+        outputs.classIds = new ClassHierarchy(program.getTypeChecker()).assignClassIds(sourceFiles, outputs.classIds);
+        cmdLineOptions.classIds = outputs.classIds;
+
+        const getDependencies = (sourceFile?: ts.SourceFile) => OutputCache.getDependencies(program, sourceFile)
+            .map(d => d.fileName.startsWith(rootFolder) ? d.fileName.substring(rootFolder.length) : d.fileName);
+
+        let eliminatedAllocations = 0;
+        const programFiles = sourceFiles.filter(s => !s.fileName.endsWith('.d.ts') && sources.some(sf => s.fileName.endsWith(sf)));
+        if (cmdLineOptions.unity) {
+            eliminatedAllocations = this.generateUnity(program, programFiles, options, cmdLineOptions, outDir, outputs, getDependencies());
+        } else {
+            const changedFiles = programFiles.filter(s => {
+                // track version
+                const paths = sources.filter(sf => s.fileName.endsWith(sf));
+                (<any>s).__path = paths[0];
+                const fileVersion = (<any>s).version;
+                const classIds = ClassHierarchy.getClassIds(s);
+                if (fileVersion) {
+                    const latestVersion = this.versions[s.fileName];
+                    // ids of its classes change when a base class is replaced
+                    if (latestVersion && latestVersion === fileVersion && this.classIds[s.fileName] === classIds) {
+                        if (!cmdLineOptions.suppressOutput) {
+                            console.log(
+                                'File: '
+                                + ForegroundColorEscapeSequences.White
+                                + s.fileName
+                                + resetEscapeSequence
+                                + ' current version:'
+                                + fileVersion
+                                + ', last version:'
+                                + latestVersion
+                                + '. '
+                                + ForegroundColorEscapeSequences.Red
+                                + 'Skipped.'
+                                + resetEscapeSequence);
+                        }
+                        return false;
                     }
-                    return;
-                }
 
-                this.versions[s.fileName] = fileVersion;
-            }
+                    this.versions[s.fileName] = fileVersion;
+                    this.classIds[s.fileName] = classIds;
+                }
 
-            if (!cmdLineOptions.suppressOutput) {
-                console.log(
-                    ForegroundColorEscapeSequences.Cyan
-                    + 'Processing File: '
-                    + resetEscapeSequence
-                    + ForegroundColorEscapeSequences.White
-                    + s.fileName
-                    + resetEscapeSequence);
-            }
+                if (!cmdLineOptions.suppressOutput) {
+                    console.log(
+                        ForegroundColorEscapeSequences.Cyan
+                        + 'Processing File: '
+                        + resetEscapeSequence
+                        + ForegroundColorEscapeSequences.White
+                        + s.fileName
+                        + resetEscapeSequence);
+                }
 
-            const emitterHeader = new Emitter(program.getTypeChecker(), options, cmdLineOptions, false, program.getCurrentDirectory());
-            emitterHeader.HeaderMode = true;
-            emitterHeader.processNode(s);
-            const emitterSource = new Emitter(program.getTypeChecker(), options, cmdLineOptions, false, program.getCurrentDirectory());
-            emitterSource.SourceMode = true;
-            emitterSource.processNode(s);
+                return true;
+            });
 
-            let fileNameNoExt = s.fileName.endsWith('.ts') ? s.fileName.substr(0, s.fileName.length - 3) : s.fileName;
-            if (fileNameNoExt.startsWith(rootFolder)) {
-                fileNameNoExt = fileNameNoExt.substring(rootFolder.length);
-            }
+            EmitJobs.emitFiles(program, changedFiles, options, cmdLineOptions).forEach((emitted, index) => {
+                const s = changedFiles[index];
+                eliminatedAllocations += emitted.eliminatedAllocations;
 
-            const fileNameHeader = Helpers.correctFileNameForCxx(fileNameNoExt.concat('.', 'h'));
-            const fileNameCpp = Helpers.correctFileNameForCxx(fileNameNoExt.concat('.', 'cpp'));
+                let fileNameNoExt = s.fileName.endsWith('.ts') ? s.fileName.substr(0, s.fileName.length - 3) : s.fileName;
+                if (fileNameNoExt.startsWith(rootFolder)) {
+                    fileNameNoExt = fileNameNoExt.substring(rootFolder.length);
+                }
 
-            if (!cmdLineOptions.suppressOutput) {
-                console.log(
-                    ForegroundColorEscapeSequences.Cyan
-                    + 'Writing to file: '
-                    + resetEscapeSequence
-                    + ForegroundColorEscapeSequences.White
-                    + outDir + fileNameCpp
-                    + resetEscapeSequence);
-            }
+                const fileNameHeader = Helpers.correctFileNameForCxx(fileNameNoExt.concat('.', 'h'));
+                const fileNameCpp = Helpers.correctFileNameForCxx(fileNameNoExt.concat('.', 'cpp'));
+
+                // files with the same content keep their timestamps, so the C++ build recompiles only what changed
+                const dependencies = getDependencies(s);
+                const headerWritten = outputs.write(fileNameHeader, emitted.header, dependencies);
+                const sourceWritten = outputs.write(fileNameCpp, emitted.source, dependencies);
+                outputs.writeDependencyFile(fileNameNoExt.concat('.ts.d'), [outDir + fileNameHeader, outDir + fileNameCpp], dependencies);
+
+                if (!cmdLineOptions.suppressOutput) {
+                    console.log(
+                        ForegroundColorEscapeSequences.Cyan
+                        + (headerWritten || sourceWritten ? 'Writing to file: ' : 'Unchanged file: ')
+                        + resetEscapeSequence
+                        + ForegroundColorEscapeSequences.White
+                        + outDir + fileNameCpp
+                        + resetEscapeSequence);
+                }
+            });
+        }
 
-            fs.writeFileSync(outDir + fileNameHeader, emitterHeader.writer.getText());
-            fs.writeFileSync(outDir + fileNameCpp, emitterSource.writer.getText());
-        });
+        outputs.save();
 
         if (!cmdLineOptions.suppressOutput) {
+            console.log(
+                ForegroundColorEscapeSequences.Cyan
+                + 'Escape analysis: '
+                + resetEscapeSequence
+                + eliminatedAllocations
+                + ' heap allocation(s) eliminated');
             console.log(ForegroundColorEscapeSequences.Pink + 'Binary files have been generated...' + resetEscapeSequence);
         }
 
@@ -331,6 +380,58 @@ export class Run {
         }
     }
 
+    /**
+     * Whole program as one translation unit: declarations of all files in import order, then their implementations,
+     * in an unnamed namespace so the C++ compiler sees every function with internal linkage and can inline and drop
+     * them across files. Headers of declaration files are included before the namespace
+     */
+    private generateUnity(
+        program: ts.Program, programFiles: ts.SourceFile[], options: ts.CompilerOptions, cmdLineOptions: any,
+        outDir: string, outputs: OutputCache, dependencies: string[]): number {
+
+        const orderedFiles = Helpers.orderByImports(program, programFiles);
+        orderedFiles.forEach(s => {
+            if (!cmdLineOptions.suppressOutput) {
+                console.log(
+                    ForegroundColorEscapeSequences.Cyan
+                    + 'Processing File: '
+                    + resetEscapeSequence
+                    + ForegroundColorEscapeSequences.White
+                    + s.fileName
+                    + resetEscapeSequence);
+            }
+        });
+
+        const emitted = EmitJobs.emitFiles(program, orderedFiles, options, cmdLineOptions);
+
+        const includes: string[] = [];
+        emitted.forEach(e => e.includes.filter(i => includes.indexOf(i) < 0).forEach(i => includes.push(i)));
+
+        const text = '#include "core.h"\n'
+            + includes.map(i => `#include "${i}"\n`).join('')
+            + '\n'
+            + 'namespace\n'
+            + '{\n'
+            + emitted.map(e => e.header).concat(emitted.map(e => e.source)).join('\n')
+            + '} // namespace\n'
+            + (emitted.some(e => e.hasMain) ? '\nMAIN\n' : '');
+
+        const written = outputs.write(Run.unityFileName, text, dependencies);
+        outputs.writeDependencyFile('unity.d', [outDir + Run.unityFileName], dependencies);
+
+        if (!cmdLineOptions.suppressOutput) {
+            console.log(
+                ForegroundColorEscapeSequences.Cyan
+                + (written ? 'Writing to file: ' : 'Unchanged file: ')
+                + resetEscapeSequence
+                + ForegroundColorEscapeSequences.White
+                + outDir + Run.unityFileName
+                + resetEscapeSequence);
+        }
+
+        return emitted.reduce((count, e) => count + e.eliminatedAllocations, 0);
+    }
+
     public test(sources: string[], cmdLineOptions?: any, header?: string, footer?: string): string {
         let actualOutput = '';
 
@@ -342,6 +443,14 @@ export class Run {
         const tempSourceFiles = sources.map((s: string, index: number) => fileName + index + '.ts');
         const tempCxxFiles = sources.map((s: string, index: number) => fileName + index + '.cpp');
         const tempHFiles = sources.map((s: string, index: number) => fileName + index + '.h');
+        const tempDFiles = sources.map((s: string, index: number) => fileName + index + '.ts.d');
+        const unity = cmdLineOptions && cmdLineOptions.unity;
+        // runtime defines (JS_COUNTERS, ...) for the C++ compiler
+        const defines = (cmdLineOptions && cmdLineOptions.defines || []).map((d: string) => '/D' + d);
+        if (unity) {
+            tempCxxFiles.push(Run.unityFileName);
+            tempDFiles.push('unity.d');
+        }
 
         // clean up
         tempSourceFiles.forEach(f => {
@@ -353,6 +462,9 @@ export class Run {
         tempHFiles.forEach(f => {
             if (fs.existsSync(f)) { fs.unlinkSync(f); }
         });
+        tempDFiles.forEach(f => {
+            if (fs.existsSync(f)) { fs.unlinkSync(f); }
+        });
 
         try {
             sources.forEach((s: string, index: number) => {
@@ -378,10 +490,10 @@ export class Run {
             });
 
             // to use tsconfig to compile
-            this.run('tsconfig.test.json', { suppressOutput: true });
+            this.run('tsconfig.test.json', Object.assign({ suppressOutput: true }, cmdLineOptions));
 
             // compiling
-            const result_compile: any = spawn.sync('test.bat', tempCxxFiles);
+            const result_compile: any = spawn.sync('test.bat', (unity ? [Run.unityFileName] : tempCxxFiles).concat(defines));
             if (result_compile.error) {
                 actualOutput = result_compile.error.stack;
             } else if (result_compile.stdout.length) {
@@ -431,6 +543,13 @@ export class Run {
         tempHFiles.forEach(f => {
             if (fs.existsSync(f)) { fs.unlinkSync(f); }
         });
+        tempDFiles.forEach(f => {
+            if (fs.existsSync(f)) { fs.unlinkSync(f); }
+        });
+
+        if (fs.existsSync(OutputCache.manifestName)) {
+            fs.unlinkSync(OutputCache.manifestName);
+        }
 
         process.chdir('..');
 
@@ -0,0 +1,228 @@
+import * as ts from 'typescript';
+import * as os from 'os';
+import { MessageChannel, Worker, receiveMessageOnPort, workerData } from 'worker_threads';
+import { Emitter } from './emitter';
+import { ClassHierarchy } from './classhierarchy';
+
+export interface EmittedFile {
+    fileName: string;
+    header: string;
+    source: string;
+    hasMain: boolean;
+    eliminatedAllocations: number;
+    // -unity mode, headers of declaration files to include before the program
+    includes: string[];
+}
+
+interface EmitJobResult {
+    files?: EmittedFile[];
+    error?: string;
+}
+
+/**
+ * Emits the header and the source of files, in this thread or with -jobs N over N worker threads.
+ * A type checker can not be shared between threads, so every worker builds its own program from the same files
+ * and options: parsing and binding are repeated per worker, the emitting, which takes most of the time, is divided.
+ * Each worker holds a whole program and type checker, so memory grows with N times the size of the program.
+ */
+export class EmitJobs {
+
+    // the main thread wakes up at this interval to check that the supervisor thread is alive
+    private static readonly pollInterval = 1000;
+
+    // the supervisor thread counts a heartbeat at least this often
+    private static readonly heartbeatInterval = 100;
+
+    // a supervisor without a heartbeat for this long has died, the emit fails instead of waiting forever
+    private static readonly supervisorTimeout = 30000;
+
+    /**
+     * One emitter writes both, so the analyses of the file run once for the header and the source
+     */
+    public static emitFile(
+        program: ts.Program, sourceFile: ts.SourceFile, options: ts.CompilerOptions, cmdLineOptions: any): EmittedFile {
+
+        const emitter = new Emitter(program.getTypeChecker(), options, cmdLineOptions, false, program.getCurrentDirectory());
+        emitter.HeaderMode = true;
+        emitter.SourceMode = true;
+        emitter.processNode(sourceFile);
+
+        return {
+            fileName: sourceFile.fileName,
+            header: emitter.headerWriter.getText(),
+            source: emitter.sourceWriter.getText(),
+            hasMain: emitter.hasMain,
+            eliminatedAllocations: emitter.eliminatedAllocations,
+            includes: emitter.unityIncludes
+        };
+    }
+
+    /**
+     * Results are in the order of the files
+     */
+    public static emitFiles(
+        program: ts.Program, sourceFiles: ts.SourceFile[], options: ts.CompilerOptions, cmdLineOptions: any): EmittedFile[] {
+
+        const jobs = Math.min(EmitJobs.getJobCount(cmdLineOptions), sourceFiles.length);
+        if (jobs <= 1) {
+            return sourceFiles.map(s => EmitJobs.emitFile(program, s, options, cmdLineOptions));
+        }
+
+        // the largest files first, each to the worker with the least text so far
+        const buckets: ts.SourceFile[][] = [];
+        const sizes: number[] = [];
+        for (let i = 0; i < jobs; i++) {
+            buckets.push([]);
+            sizes.push(0);
+        }
+
+        sourceFiles.slice().sort((a, b) => b.text.length - a.text.length).forEach(s => {
+            const smallest = sizes.indexOf(Math.min(...sizes));
+            buckets[smallest].push(s);
+            sizes[smallest] += s.text.length;
+        });
+
+        const emitted = new Map<string, EmittedFile>();
+        EmitJobs.runWorkers(program, buckets.map(b => b.map(s => s.fileName)), cmdLineOptions).forEach(result => {
+            if (result.error) {
+                throw new Error(result.error);
+            }
+
+            result.files.forEach(f => emitted.set(f.fileName, f));
+        });
+
+        return sourceFiles.map(s => emitted.get(s.fileName));
+    }
+
+    /**
+     * Entry of a worker thread, see runWorkers
+     */
+    public static emitInWorker(): EmitJobResult {
+        const program = ts.createProgram(workerData.rootNames, workerData.options);
+
+        // the same numbering as in the main thread, which passes the ids it assigned
+        new ClassHierarchy(program.getTypeChecker()).assignClassIds(program.getSourceFiles(), workerData.cmdLineOptions.classIds);
+
+        return {
+            files: (<string[]>workerData.fileNames).map(
+                f => EmitJobs.emitFile(program, program.getSourceFile(f), workerData.options, workerData.cmdLineOptions))
+        };
+    }
+
+    private static getJobCount(cmdLineOptions: any): number {
+        if (!cmdLineOptions || !cmdLineOptions.jobs) {
+            return 1;
+        }
+
+        // -jobs without a number uses all processors
+        const jobs = parseInt(cmdLineOptions.jobs, 10);
+        return jobs > 0 ? jobs : os.cpus().length;
+    }
+
+    /**
+     * Runs a worker per list of files and waits for all of them, the compiler stays synchronous: workers post their
+     * results to ports which are read once a shared counter says every worker has finished.
+     * A blocked main thread can't receive the 'error' and 'exit' events of its workers, so they are started by a
+     * supervisor thread which listens to the events, counts a worker as finished when it exits for any reason
+     * and reports a worker which died without a result (out of memory, process.exit) with the cause.
+     * The supervisor counts a heartbeat, the main thread waits with a timeout and gives up when it stops.
+     */
+    private static runWorkers(program: ts.Program, fileNames: string[][], cmdLineOptions: any): EmitJobResult[] {
+        // [0] - finished workers, [1] - heartbeat of the supervisor
+        const status = new Int32Array(new SharedArrayBuffer(8));
+
+        // the config file itself is not needed to build the program and can't be sent to a thread
+        const options = Object.assign({}, program.getCompilerOptions());
+        delete options.configFile;
+
+        // specs run the TypeScript sources
+        const register = __filename.endsWith('.ts') ? `require('ts-node').register({ transpileOnly: true });` : '';
+        const script = `
+            const threads = require('worker_threads');
+            const data = threads.workerData;
+            try {
+                ${register}
+                data.port.postMessage(require(${JSON.stringify(__filename)}).EmitJobs.emitInWorker());
+            } catch (e) {
+                data.port.postMessage({ error: String(e && e.stack || e) });
+            }`;
+
+        const supervisorScript = `
+            const threads = require('worker_threads');
+            const data = threads.workerData;
+            setInterval(() => Atomics.add(data.status, 1, 1), ${EmitJobs.heartbeatInterval}).unref();
+            data.jobs.forEach((job, index) => {
+                let failure;
+                const worker = new threads.Worker(data.script, { eval: true, workerData: job, transferList: [job.port] });
+                worker.on('error', e => failure = String(e && e.stack || e));
+                worker.on('exit', code => {
+                    if (failure || code !== 0) {
+                        data.failures.postMessage({ index, error: failure || 'worker thread exited with code ' + code });
+                    }
+
+                    Atomics.add(data.status, 0, 1);
+                    Atomics.notify(data.status, 0);
+                });
+            });`;
+
+        const channels = fileNames.map(() => new MessageChannel());
+        const failures = new MessageChannel();
+        const supervisor = new Worker(supervisorScript, {
+            eval: true,
+            workerData: {
+                script,
+                status,
+                failures: failures.port2,
+                jobs: fileNames.map((names, index) => ({
+                    rootNames: program.getRootFileNames(),
+                    options,
+                    cmdLineOptions,
+                    fileNames: names,
+                    port: channels[index].port2
+                }))
+            },
+            transferList: [failures.port2, ...channels.map(c => c.port2)]
+        });
+
+        let count: number;
+        let heartbeat = Atomics.load(status, 1);
+        let silentFor = 0;
+        while ((count = Atomics.load(status, 0)) < fileNames.length) {
+            if (Atomics.wait(status, 0, count, EmitJobs.pollInterval) !== 'timed-out') {
+                continue;
+            }
+
+            const current = Atomics.load(status, 1);
+            silentFor = current === heartbeat ? silentFor + EmitJobs.pollInterval : 0;
+            heartbeat = current;
+            if (silentFor >= EmitJobs.supervisorTimeout) {
+                break;
+            }
+        }
+
+        const errors: string[] = [];
+        let failure: any;
+        while ((failure = receiveMessageOnPort(failures.port1))) {
+            errors[failure.message.index] = failure.message.error;
+        }
+
+        const results = channels.map((channel, index) => {
+            const received = receiveMessageOnPort(channel.port1);
+            channel.port1.close();
+            if (received) {
+                return <EmitJobResult>received.message;
+            }
+
+            return {
+                error: errors[index]
+                    || (count < fileNames.length
+                        ? `worker supervisor thread stopped responding, no result for ${fileNames[index].join(', ')}`
+                        : 'worker thread ended without a result')
+            };
+        });
+
+        failures.port1.close();
+        supervisor.terminate();
+        return results;
+    }
+}
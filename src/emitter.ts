@@ -3,24 +3,50 @@ import { IdentifierResolver } from './resolvers';
 import { Helpers } from './helpers';
 import { Preprocessor } from './preprocessor';
 import { CodeWriter } from './codewriter';
+import { EscapeAnalysis } from './escapeanalysis';
+import { RangeAnalysis } from './rangeanalysis';
+import { JsonSchema } from './jsonschema';
+import { TypeProfile } from './typeprofile';
 
 export class Emitter {
     public writer: CodeWriter;
+    // with HeaderMode and SourceMode both set, one emitter writes the header and the source of a file
+    public headerWriter: CodeWriter;
+    public sourceWriter: CodeWriter;
+    public eliminatedAllocations = 0;
+    // set when the file has top-level code, in -unity mode the compiler writes MAIN once for the whole program
+    public hasMain = false;
+    // -unity mode, headers of declaration files which the compiler includes before the unnamed namespace
+    public unityIncludes: string[] = [];
     private resolver: IdentifierResolver;
+    private escapeAnalysis: EscapeAnalysis;
+    private rangeAnalysis: RangeAnalysis;
+    private jsonSchema: JsonSchema;
+    // -profile_use, read once for the emitter instead of for every binary expression
+    private typeProfile: TypeProfile;
     private preprocessor: Preprocessor;
     private sourceFileName: string;
     private scope: Array<ts.Node> = new Array<ts.Node>();
     private opsMap: Map<number, string> = new Map<number, string>();
     private embeddedCPPTypes: Array<string>;
     private isWritingMain = false;
+    private part: 'header' | 'source';
 
     public constructor(
         typeChecker: ts.TypeChecker, private options: ts.CompilerOptions,
         private cmdLineOptions: any, private singleModule: boolean, private rootFolder?: string) {
 
-        this.writer = new CodeWriter();
+        this.headerWriter = new CodeWriter();
+        this.sourceWriter = new CodeWriter();
+        this.writer = this.headerWriter;
         this.resolver = new IdentifierResolver(typeChecker);
         this.preprocessor = new Preprocessor(this.resolver, this);
+        this.escapeAnalysis = new EscapeAnalysis(this.resolver);
+        this.rangeAnalysis = new RangeAnalysis(this.resolver);
+        this.jsonSchema = new JsonSchema(this.resolver);
+        if (cmdLineOptions && cmdLineOptions.profile_use) {
+            this.typeProfile = TypeProfile.load(cmdLineOptions.profile_use);
+        }
 
         this.opsMap[ts.SyntaxKind.EqualsToken] = '=';
         this.opsMap[ts.SyntaxKind.PlusToken] = '+';
@@ -65,6 +91,7 @@ export class Emitter {
 
         this.opsMap[ts.SyntaxKind.AmpersandAmpersandToken] = '__AND';
         this.opsMap[ts.SyntaxKind.BarBarToken] = '__OR';
+        this.opsMap[ts.SyntaxKind.QuestionQuestionToken] = '__COALESCE';
 
         this.opsMap[ts.SyntaxKind.CommaToken] = ',';
 
@@ -139,17 +166,22 @@ export class Emitter {
     public SourceMode: boolean;
 
     public isHeader() {
-        return this.HeaderMode;
+        return this.part ? this.part === 'header' : this.HeaderMode;
     }
 
     public isSource() {
-        return this.SourceMode;
+        return this.part ? this.part === 'source' : this.SourceMode;
     }
 
     public isHeaderWithSource() {
         return (this.HeaderMode && this.SourceMode) || (!this.HeaderMode && !this.SourceMode);
     }
 
+    // whole program in one translation unit, headers of other files are not included
+    public isUnity() {
+        return this.cmdLineOptions && this.cmdLineOptions.unity;
+    }
+
     public get isGlobalScope() {
         return this.scope.length > 0 && this.scope[this.scope.length - 1].kind === ts.SyntaxKind.SourceFile;
     }
@@ -362,7 +394,15 @@ export class Emitter {
                     const isLocal = data[0];
                     const resolvedSymbol = data[1];
                     if (isLocal !== undefined && !isLocal) {
-                        (<any>resolvedSymbol).valueDeclaration.__requireCapture = true;
+                        const valueDeclaration = (<any>resolvedSymbol).valueDeclaration;
+                        const closures = this.escapeAnalysis.getNonEscapingClosures(node, valueDeclaration);
+                        if (closures) {
+                            // closures can't outlive the frame, capture by reference
+                            closures.forEach(c => (<any>c).__lambda_by_reference = true);
+                            valueDeclaration.__captureByReference = true;
+                        } else {
+                            valueDeclaration.__requireCapture = true;
+                        }
                     }
                 }
             }
@@ -385,20 +425,6 @@ export class Emitter {
         return createThis;
     }
 
-    private hasThisAsShared(location: ts.Node): boolean {
-        let createThis = false;
-        this.childrenVisitor(location, (node: ts.Node) => {
-            if (node.kind === ts.SyntaxKind.ThisKeyword && node.parent.kind !== ts.SyntaxKind.PropertyAccessExpression) {
-                createThis = true;
-                return true;
-            }
-
-            return false;
-        });
-
-        return createThis;
-    }
-
     private processFile(sourceFile: ts.SourceFile): void {
         this.scope.push(sourceFile);
         this.processFileInternal(sourceFile);
@@ -410,15 +436,14 @@ export class Emitter {
 
         this.sourceFileName = sourceFile.fileName;
 
+        if (this.HeaderMode) {
+            this.beginPart('header');
 
-        if (this.isHeader()) {
             // added header
             this.WriteHeader();
 
             sourceFile.referencedFiles.forEach(f => {
-                this.writer.writeString('#include \"');
-                this.writer.writeString(f.fileName.replace('.d.ts', ''));
-                this.writer.writeStringNewLine('.h\"');
+                this.writeInclude(f.fileName.replace('.d.ts', '') + '.h', !f.fileName.endsWith('.d.ts'));
             });
 
             sourceFile.statements.filter(s => this.isImportStatement(s)).forEach(s => {
@@ -457,9 +482,16 @@ export class Emitter {
             sourceFile.statements.filter(s => this.isDeclarationStatement(s) || this.isVariableStatement(s)).forEach(s => {
                 this.processImplementation(s, true);
             });
+
+            if (!this.isUnity()) {
+                // end of header
+                this.writer.writeStringNewLine(`#endif`);
+            }
         }
 
-        if (this.isSource()) {
+        if (this.SourceMode) {
+            this.beginPart('source');
+
             // added header
             this.WriteHeader();
 
@@ -517,18 +549,42 @@ export class Emitter {
             if (hasVarsContent || this.writer.hasAnyContent(position, rollbackPosition)) {
                 this.writer.EndBlock();
 
-                this.writer.writeStringNewLine('');
-                this.writer.writeStringNewLine('MAIN');
+                this.hasMain = true;
+                if (!this.isUnity()) {
+                    this.writer.writeStringNewLine('');
+                    this.writer.writeStringNewLine('MAIN');
+                }
             }
         }
 
-        if (this.isHeader()) {
-            // end of header
-            this.writer.writeStringNewLine(`#endif`);
+        this.part = undefined;
+    }
+
+    private beginPart(part: 'header' | 'source') {
+        this.part = part;
+        this.writer = part === 'header' ? this.headerWriter : this.sourceWriter;
+    }
+
+    // in -unity mode files of the program are in the same translation unit and are not included
+    private writeInclude(header: string, isProgramFile: boolean) {
+        if (!this.isUnity()) {
+            this.writer.writeStringNewLine(`#include "${header}"`);
+        } else if (!isProgramFile && this.unityIncludes.indexOf(header) < 0) {
+            this.unityIncludes.push(header);
         }
     }
 
+    private isProgramFile(moduleSpecifier: ts.Node): boolean {
+        const symbol = this.resolver.getSymbolAtLocation(moduleSpecifier);
+        const declaration = symbol && symbol.valueDeclaration;
+        return declaration && declaration.kind === ts.SyntaxKind.SourceFile && !(<ts.SourceFile>declaration).isDeclarationFile;
+    }
+
     private WriteHeader() {
+        if (this.isUnity()) {
+            return;
+        }
+
         const filePath = Helpers.getSubPath(Helpers.cleanUpPath(this.sourceFileName), Helpers.cleanUpPath(this.rootFolder));
         if (this.isSource()) {
             this.writer.writeStringNewLine(`#include "${filePath.replace(/\.ts$/, '.h')}"`);
@@ -1316,11 +1372,6 @@ export class Emitter {
             this.writer.writeString(' : public object');
         }
 
-        this.writer.writeString(', public std::enable_shared_from_this<');
-        this.processIdentifier(node.name);
-        this.processTemplateParameters(<ts.ClassDeclaration>node);
-        this.writer.writeString('>');
-
         this.writer.writeString(' ');
         this.writer.BeginBlock();
         this.writer.DecreaseIntent();
@@ -1328,10 +1379,18 @@ export class Emitter {
         this.writer.IncreaseIntent();
         this.writer.writeStringNewLine();
 
-        this.writer.writeString('using std::enable_shared_from_this<');
-        this.processIdentifier(node.name);
-        this.processTemplateParameters(<ts.ClassDeclaration>node);
-        this.writer.writeStringNewLine('>::shared_from_this;');
+        // generic classes share one declaration for all instantiations, they are checked by dynamic_cast
+        const classId = (<any>node).__class_id;
+        if (classId && !(<ts.ClassDeclaration>node).typeParameters) {
+            const display: number[] = (<any>node).__class_display;
+            this.writer.writeStringNewLine('using __class_self = ' + node.name.text + ';');
+            this.writer.writeStringNewLine('static constexpr std::uint32_t __class_id = ' + classId + ';');
+            this.writer.writeStringNewLine('static constexpr std::uint32_t __class_depth = ' + display.length + ';');
+            this.writer.writeStringNewLine(
+                'static constexpr std::uint32_t __class_display[] = {'
+                + [display.length, (<any>node).__class_program].concat(display).join(', ') + '};');
+            this.writer.writeStringNewLine();
+        }
 
         /*
         if (!node.heritageClauses) {
@@ -1360,6 +1419,8 @@ export class Emitter {
             this.processDeclaration(member);
         }
 
+        this.processJsonMembers(node);
+
         this.writer.cancelNewLine();
         this.writer.cancelNewLine();
 
@@ -1376,6 +1437,88 @@ export class Emitter {
         }
     }
 
+    /**
+     * Emits JSON (de)serializers working on fields directly: __json_fields and __json_read_field used by
+     * JSON.parse for readable interfaces, __json_write used by JSON.stringify for classes and interfaces.
+     */
+    private processJsonMembers(node: ts.ClassDeclaration | ts.InterfaceDeclaration): void {
+        if (node.typeParameters) {
+            return;
+        }
+
+        const fields = this.jsonSchema.getFields(node);
+        if (!fields || !fields.length) {
+            if (node.heritageClauses) {
+                // writer inherited from base would miss fields of this one
+                this.writer.writeStringNewLine('bool __json_write(json::stringifier &) const');
+                this.writer.BeginBlock();
+                this.writer.writeString('return false');
+                this.writer.EndOfStatement();
+                this.writer.EndBlock();
+                this.writer.writeStringNewLine();
+            }
+
+            return;
+        }
+
+        if (node.kind === ts.SyntaxKind.InterfaceDeclaration && this.jsonSchema.isReadable(node)) {
+            // field names are dispatched by perfect hash built by compiler
+            this.writer.writeString('static constexpr string_switch __json_fields{');
+            fields.forEach((f, index) => {
+                if (index > 0) {
+                    this.writer.writeString(', ');
+                }
+
+                this.writer.writeString(`TXT("${(<ts.Identifier>f.name).text}")`);
+            });
+
+            this.writer.writeString('}');
+            this.writer.EndOfStatement();
+            this.writer.writeStringNewLine();
+
+            this.writer.writeStringNewLine('void __json_read_field(json::parser &__parser, std::size_t __field)');
+            this.writer.BeginBlock();
+            this.writer.writeStringNewLine('switch (__field)');
+            this.writer.BeginBlock();
+            fields.forEach((f, index) => {
+                this.writer.DecreaseIntent();
+                this.writer.writeString(`case ${index + 1}`);
+                this.writer.IncreaseIntent();
+                this.writer.writeStringNewLine(':');
+                this.writer.writeString('__parser.read(this->');
+                this.processExpression(<ts.Identifier>f.name);
+                this.writer.writeString(')');
+                this.writer.EndOfStatement();
+                this.writer.writeString('break');
+                this.writer.EndOfStatement();
+            });
+
+            this.writer.DecreaseIntent();
+            this.writer.writeString('default');
+            this.writer.IncreaseIntent();
+            this.writer.writeStringNewLine(':');
+            this.writer.writeString('__parser.skip()');
+            this.writer.EndOfStatement();
+            this.writer.EndBlock();
+            this.writer.EndBlock();
+            this.writer.writeStringNewLine();
+        }
+
+        this.writer.writeStringNewLine('bool __json_write(json::stringifier &__writer) const');
+        this.writer.BeginBlock();
+        fields.forEach(f => {
+            this.writer.writeString(`__writer.write_field(TXT("${(<ts.Identifier>f.name).text}"), this->`);
+            this.processExpression(<ts.Identifier>f.name);
+            this.writer.writeString(')');
+            this.writer.EndOfStatement();
+        });
+
+        this.writer.writeString('return true');
+        this.writer.EndOfStatement();
+        this.writer.EndBlock();
+        this.writer.writeStringNewLine();
+    }
+
     private processPropertyDeclaration(node: ts.PropertyDeclaration | ts.PropertySignature | ts.ParameterDeclaration,
         implementationMode?: boolean): void {
         if (!implementationMode) {
@@ -1453,9 +1596,7 @@ export class Emitter {
             const argument = typeLiteral.argument;
             if (argument.kind === ts.SyntaxKind.LiteralType) {
                 const literal = <ts.LiteralTypeNode>argument;
-                this.writer.writeString('#include \"');
-                this.writer.writeString((<any>literal.literal).text);
-                this.writer.writeStringNewLine('.h\"');
+                this.writeInclude((<any>literal.literal).text + '.h', this.isProgramFile(literal.literal));
             } else {
                 throw new Error('Not Implemented');
             }
@@ -1610,14 +1751,7 @@ export class Emitter {
             return;
         }
 
-        this.writer.writeString('#include \"');
-        if (node.moduleSpecifier.kind === ts.SyntaxKind.StringLiteral) {
-            const ident = <ts.StringLiteral>node.moduleSpecifier;
-            this.writer.writeString(ident.text);
-            this.writer.writeString('.h');
-        }
-
-        this.writer.writeStringNewLine('\"');
+        this.writeInclude((<ts.StringLiteral>node.moduleSpecifier).text + '.h', this.isProgramFile(node.moduleSpecifier));
 
         if (node.importClause) {
             if (node.importClause.name && node.importClause.name.kind === ts.SyntaxKind.Identifier) {
@@ -1653,6 +1787,12 @@ export class Emitter {
             && scopeItem.kind !== ts.SyntaxKind.NamespaceExportDeclaration;
 
         const forceCaptureRequired = autoAllowed && declarationList.declarations.some(d => d && (<any>d).__requireCapture);
+        // counted where the variable is defined, not again for its extern forward declaration
+        if (autoAllowed && !forwardDeclaration && !forceCaptureRequired
+            && declarationList.declarations.some(d => d && (<any>d).__captureByReference)) {
+            this.eliminatedAllocations++;
+        }
+
         if (!((<any>declarationList).__ignore_type)) {
 
             if (forwardDeclaration) {
@@ -1662,9 +1802,14 @@ export class Emitter {
             const firstType = declarationList.declarations.filter(d => d.type)[0]?.type;
             const firstInitializer = declarationList.declarations.filter(d => d.initializer)[0]?.initializer;
             const effectiveType = firstType || this.resolver.getOrResolveTypeOfAsTypeNode(firstInitializer);
-            const useAuto = autoAllowed && !!(firstInitializer);
+            const nativeIntType = (<any>declarationList.declarations[0]).__native_int;
+            // integer literal is not a proof of integer value, 'auto' would make it 'int'
+            const useAuto = autoAllowed && !!(firstInitializer)
+                && RangeAnalysis.getIntegerLiteral(firstInitializer) === undefined;
             this.processPredefineType(effectiveType);
-            if (!forceCaptureRequired) {
+            if (nativeIntType) {
+                this.writer.writeString(nativeIntType);
+            } else if (!forceCaptureRequired) {
                 this.processType(effectiveType, useAuto);
             } else {
                 if (useAuto) {
@@ -1738,7 +1883,49 @@ export class Emitter {
         return true;
     }
 
+    private processStackStorage(declarationList: ts.VariableDeclarationList): void {
+        const declaration = declarationList.declarations[0];
+        if (!declaration || !this.escapeAnalysis.isStackAllocatable(declaration)) {
+            return;
+        }
+
+        const initializer = declaration.initializer;
+        const storageName = '__' + (<ts.Identifier>declaration.name).text + '_stack';
+        switch (initializer.kind) {
+            case ts.SyntaxKind.NewExpression:
+                const newExpression = <ts.NewExpression>initializer;
+                this.processExpression(newExpression.expression);
+                this.processTemplateArguments(newExpression);
+                this.writer.writeString(' ' + storageName);
+                if (newExpression.arguments && newExpression.arguments.length) {
+                    this.writer.writeString('(');
+                    this.processCallArguments(newExpression);
+                    this.writer.writeString(')');
+                }
+
+                break;
+            case ts.SyntaxKind.ObjectLiteralExpression:
+                this.writer.writeString('object::store_type ' + storageName);
+                break;
+            case ts.SyntaxKind.ArrayLiteralExpression:
+                this.processArrayLiteralType(<ts.ArrayLiteralExpression>initializer);
+                this.writer.writeString('::store_type ' + storageName);
+                break;
+        }
+
+        this.writer.EndOfStatement();
+
+        if (initializer.kind === ts.SyntaxKind.NewExpression) {
+            this.writer.writeString('set_class_id(&' + storageName + ')');
+            this.writer.EndOfStatement();
+        }
+
+        (<any>initializer).__stack_storage = storageName;
+        this.eliminatedAllocations++;
+    }
+
     private processVariableStatement(node: ts.VariableStatement): void {
+        this.processStackStorage(node.declarationList);
         const anyVal = this.processVariableDeclarationList(node.declarationList);
         if (anyVal) {
             this.writer.EndOfStatement();
@@ -1921,7 +2108,7 @@ export class Emitter {
                     || isArray;
 
                 if (!skipPointerIf) {
-                    this.writer.writeString('std::shared_ptr<');
+                    this.writer.writeString('ref<');
                 }
 
                 // writing namespace
@@ -2475,12 +2662,6 @@ export class Emitter {
                     this.writer.writeStringNewLine('_...};');
                 });
 
-            if (node.kind === ts.SyntaxKind.Constructor && this.hasThisAsShared(node)) {
-                // adding header to constructor
-                this.processType(this.resolver.getOrResolveTypeOfAsTypeNode(node.parent));
-                this.writer.writeStringNewLine(' _this(this, [] (auto&) {/*to be finished*/});');
-            }
-
             this.markRequiredCapture(node);
             (<any>node.body).statements.filter((item, index) => index >= skipped).forEach(element => {
                 this.processStatementInternal(element, true);
@@ -2762,11 +2943,41 @@ export class Emitter {
     }
 
     private processForStatement(node: ts.ForStatement): void {
+        const nativeIntType = this.rangeAnalysis.getCounterType(node);
+        if (nativeIntType) {
+            (<any>(<ts.VariableDeclarationList>node.initializer).declarations[0]).__native_int = nativeIntType;
+        }
+
         this.writer.writeString('for (');
         const initVar = <any>node.initializer;
         this.processExpression(initVar);
         this.writer.writeString('; ');
-        this.processExpression(node.condition);
+        const condition = <ts.BinaryExpression>node.condition;
+        const lengthOnLeft = nativeIntType && this.rangeAnalysis.isLength(condition.left);
+        if (nativeIntType && (lengthOnLeft || this.rangeAnalysis.isLength(condition.right))) {
+            // compare as signed, length is unsigned
+            if (lengthOnLeft) {
+                this.writer.writeString(`static_cast<${nativeIntType}>(`);
+            }
+
+            this.processExpression(condition.left);
+            if (lengthOnLeft) {
+                this.writer.writeString(')');
+            }
+
+            this.writer.writeString(' ' + this.opsMap[condition.operatorToken.kind] + ' ');
+            if (!lengthOnLeft) {
+                this.writer.writeString(`static_cast<${nativeIntType}>(`);
+            }
+
+            this.processExpression(condition.right);
+            if (!lengthOnLeft) {
+                this.writer.writeString(')');
+            }
+        } else {
+            this.processExpression(node.condition);
+        }
+
         this.writer.writeString('; ');
         this.processExpression(node.incrementor);
         this.writer.writeStringNewLine(')');
@@ -2790,9 +3001,23 @@ export class Emitter {
 
     private processForOfStatement(node: ts.ForOfStatement): void {
 
+        if (this.resolver.isArrayType(this.resolver.getOrResolveTypeOf(node.expression))) {
+            this.processForOfStatementForArray(node);
+            return;
+        }
+
         // if has Length access use iteration
         const hasLengthAccess = this.hasPropertyAccess(node.statement, 'length');
         if (!hasLengthAccess) {
+            // copy of reference keeps iterated Map or Set even if variable is reassigned
+            const collectionName = `__collection${node.getFullStart()}_${node.getEnd()}`;
+            const isKeyedCollection = this.resolver.isKeyedCollectionType(this.resolver.getOrResolveTypeOf(node.expression));
+            if (isKeyedCollection) {
+                this.writer.writeString(`auto ${collectionName} = `);
+                this.processExpression(node.expression);
+                this.writer.EndOfStatement();
+            }
+
             this.writer.writeString('for (auto& ');
             const initVar = <any>node.initializer;
             initVar.__ignore_type = true;
@@ -2800,7 +3025,11 @@ export class Emitter {
 
             this.writer.writeString(' : ');
 
-            this.processExpression(node.expression);
+            if (isKeyedCollection) {
+                this.writer.writeString(collectionName);
+            } else {
+                this.processExpression(node.expression);
+            }
 
             this.writer.writeStringNewLine(')');
             this.processStatement(node.statement);
@@ -2811,7 +3040,7 @@ export class Emitter {
             this.processExpression(node.expression);
             this.writer.EndOfStatement();
 
-            this.writer.writeStringNewLine(`for (auto ${indexName} = 0_N; ${indexName} < ${arrayName}->get_length(); ${indexName}++)`);
+            this.writer.writeStringNewLine(`for (size_t ${indexName} = 0; ${indexName} < ${arrayName}->get_length(); ${indexName}++)`);
             this.writer.BeginBlock();
             this.writer.writeString(`auto& `);
             const initVar = <any>node.initializer;
@@ -2825,6 +3054,127 @@ export class Emitter {
         }
     }
 
+    private processForOfStatementForArray(node: ts.ForOfStatement): void {
+        const arrayName = `__array${node.getFullStart()}_${node.getEnd()}`;
+        const indexName = `__indx${node.getFullStart()}_${node.getEnd()}`;
+        const endName = `__end${node.getFullStart()}_${node.getEnd()}`;
+
+        // copy of reference keeps iterated array even if variable is reassigned
+        this.writer.writeString(`auto ${arrayName} = `);
+        this.processExpression(node.expression);
+        this.writer.EndOfStatement();
+
+        const mayMutate = this.mayMutateArrays(node.statement);
+        if (!mayMutate) {
+            // body can't change any array, length is hoisted and elements are not checked
+            this.writer.writeStringNewLine(
+                `for (auto ${indexName} = ${arrayName}->get().data(), ${endName} = ${indexName} + ${arrayName}->get().size();`
+                + ` ${indexName} != ${endName}; ++${indexName})`);
+        } else {
+            // length is read on each iteration as elements can be added or removed
+            this.writer.writeStringNewLine(
+                `for (size_t ${indexName} = 0; ${indexName} < ${arrayName}->get().size(); ${indexName}++)`);
+        }
+
+        this.writer.BeginBlock();
+
+        const initVar = <any>node.initializer;
+        if (initVar.kind === ts.SyntaxKind.VariableDeclarationList) {
+            // const element can be referenced as long as storage can't be reallocated
+            this.writer.writeString(!mayMutate && Helpers.isConst(initVar) ? 'auto& ' : 'auto ');
+            initVar.__ignore_type = true;
+        }
+
+        this.processExpression(initVar);
+        this.writer.writeString(mayMutate ? ` = ${arrayName}->get()[${indexName}]` : ` = *${indexName}`);
+        this.writer.EndOfStatement();
+
+        this.processStatement(node.statement);
+        this.writer.EndBlock();
+    }
+
+    private mayMutateArrays(location: ts.Node): boolean {
+        const pureMethods = ['indexOf', 'lastIndexOf', 'includes', 'join', 'slice', 'concat'];
+        const isAccessor = (node: ts.Node, kind: ts.SyntaxKind) => {
+            const symbol = this.resolver.getSymbolAtLocation(node);
+            return symbol && symbol.declarations && symbol.declarations.some(d => d.kind === kind);
+        };
+        // functions and objects passed to a call can be invoked or converted (toString, valueOf) by it
+        const primitiveFlags = ts.TypeFlags.NumberLike | ts.TypeFlags.StringLike | ts.TypeFlags.BooleanLike
+            | ts.TypeFlags.Undefined | ts.TypeFlags.Null;
+        const isPrimitive = (node: ts.Expression) => {
+            const type = this.resolver.getOrResolveTypeOf(node);
+            return type && (type.flags & primitiveFlags) !== 0;
+        };
+        // console and Math of the library, not local variables of the same name
+        const isLibraryObject = (node: ts.Expression) => {
+            if (node.kind !== ts.SyntaxKind.Identifier
+                || (<ts.Identifier>node).text !== 'console' && (<ts.Identifier>node).text !== 'Math') {
+                return false;
+            }
+
+            const symbol = this.resolver.getSymbolAtLocation(node);
+            return symbol && symbol.declarations && symbol.declarations.every(d => d.getSourceFile().isDeclarationFile);
+        };
+
+        // the visitor goes on with the siblings of a node which returned true, so a found mutation is never reset
+        let mayMutate = false;
+        this.childrenVisitor(location, (node: ts.Node) => {
+            if (mayMutate) {
+                return true;
+            }
+
+            switch (node.kind) {
+                case ts.SyntaxKind.CallExpression:
+                    const call = <ts.CallExpression>node;
+                    const callee = call.expression;
+                    if (callee.kind === ts.SyntaxKind.PropertyAccessExpression && call.arguments.every(isPrimitive)) {
+                        const receiver = (<ts.PropertyAccessExpression>callee).expression;
+                        const method = (<ts.PropertyAccessExpression>callee).name.text;
+                        const receiverType = this.resolver.getOrResolveTypeOf(receiver);
+                        if (isLibraryObject(receiver)
+                            || this.resolver.isStringType(receiverType)
+                            || this.resolver.isNumberType(receiverType)
+                            || this.resolver.isArrayType(receiverType) && pureMethods.indexOf(method) >= 0) {
+                            break;
+                        }
+                    }
+
+                    mayMutate = true;
+                    break;
+                case ts.SyntaxKind.NewExpression:
+                case ts.SyntaxKind.DeleteExpression:
+                case ts.SyntaxKind.TaggedTemplateExpression:
+                case ts.SyntaxKind.AwaitExpression:
+                case ts.SyntaxKind.YieldExpression:
+                    mayMutate = true;
+                    break;
+                case ts.SyntaxKind.PropertyAccessExpression:
+                    mayMutate = mayMutate || isAccessor((<ts.PropertyAccessExpression>node).name, ts.SyntaxKind.GetAccessor);
+                    break;
+                case ts.SyntaxKind.BinaryExpression:
+                    const binary = <ts.BinaryExpression>node;
+                    if (binary.operatorToken.kind < ts.SyntaxKind.FirstAssignment
+                        || binary.operatorToken.kind > ts.SyntaxKind.LastAssignment) {
+                        break;
+                    }
+
+                    const left = binary.left;
+                    mayMutate = mayMutate
+                        || left.kind === ts.SyntaxKind.ElementAccessExpression
+                        || left.kind === ts.SyntaxKind.ArrayLiteralExpression
+                        || left.kind === ts.SyntaxKind.PropertyAccessExpression
+                            && ((<ts.PropertyAccessExpression>left).name.text === 'length'
+                                || isAccessor((<ts.PropertyAccessExpression>left).name, ts.SyntaxKind.SetAccessor));
+                    break;
+            }
+
+            return mayMutate;
+        });
+
+        return mayMutate;
+    }
+
     private processBreakStatement(node: ts.BreakStatement) {
         this.writer.writeStringNewLine('break;');
     }
@@ -2856,7 +3206,9 @@ export class Emitter {
         const isTheSameTypes = caseExpressions.every(
             ce => this.resolver.typesAreTheSame(this.resolver.getOrResolveTypeOfAsTypeNode(ce), firstTypeNode));
 
-        if (isTheSameTypes && isAllStatic && !this.resolver.isStringType(firstType)) {
+        // a C++ switch over an any would convert it to a number, which throws for booleans and undefined
+        const isAnyValue = this.resolver.isAnyLikeType(this.resolver.getOrResolveTypeOf(node.expression));
+        if (isTheSameTypes && isAllStatic && !this.resolver.isStringType(firstType) && !isAnyValue) {
             this.processSwitchStatementForBasicTypesInternal(node);
             return;
         }
@@ -2913,46 +3265,57 @@ export class Emitter {
     private processSwitchStatementForAnyInternal(node: ts.SwitchStatement) {
 
         const switchName = `__switch${node.getFullStart()}_${node.getEnd()}`;
-        const isAllStatic = node.caseBlock.clauses
+        const caseExpressions = node.caseBlock.clauses
             .filter(c => c.kind === ts.SyntaxKind.CaseClause)
-            .map(element => (<ts.CaseClause>element).expression)
-            .every(expression => expression.kind === ts.SyntaxKind.NumericLiteral
-                || expression.kind === ts.SyntaxKind.StringLiteral
-                || expression.kind === ts.SyntaxKind.TrueKeyword
-                || expression.kind === ts.SyntaxKind.FalseKeyword);
+            .map(element => (<ts.CaseClause>element).expression);
 
-        if (isAllStatic) {
-            this.writer.writeString('static ');
-        }
+        const isAllStrings = caseExpressions.every(expression => expression.kind === ts.SyntaxKind.StringLiteral);
+        const typeOfExpression = this.resolver.getOrResolveTypeOf(node.expression);
+        const isStringSwitch = isAllStrings
+            && (this.resolver.isStringType(typeOfExpression) || this.resolver.isAnyLikeType(typeOfExpression));
+        if (isStringSwitch) {
+            // perfect hash is built by compiler
+            this.writer.writeString(`static constexpr string_switch ${switchName}{`);
+            caseExpressions.forEach((expression, index) => {
+                if (index > 0) {
+                    this.writer.writeString(', ');
+                }
 
-        this.writer.writeString(`switch_type ${switchName} = `);
-        this.writer.BeginBlock();
+                this.writer.writeString(`TXT("${(<ts.StringLiteral>expression).text.replace(/\n/g, '\\\n')}")`);
+            });
 
-        let caseNumber = 0;
-        node.caseBlock.clauses.filter(c => c.kind === ts.SyntaxKind.CaseClause).forEach(element => {
-            if (caseNumber > 0) {
-                this.writer.writeStringNewLine(',');
-            }
+            this.writer.writeString('}');
+            this.writer.EndOfStatement();
 
-            this.writer.BeginBlockNoIntent();
-            this.writer.writeString('any(');
-            this.processExpression((<ts.CaseClause>element).expression);
-            this.writer.writeString('), ');
-            this.writer.writeString((++caseNumber).toString());
-            this.writer.EndBlockNoIntent();
-        });
+            this.writer.writeString(`switch (${switchName}.index(`);
+            this.processExpression(node.expression);
+            this.writer.writeStringNewLine('))');
+        } else {
+            // case expressions are compared in order until first match with ===, no allocations
+            this.writer.BeginBlock();
+            this.writer.writeString(`auto&& ${switchName}_value = `);
+            this.processExpression(node.expression);
+            this.writer.EndOfStatement();
+            this.writer.writeString(`size_t ${switchName} = 0`);
+            this.writer.EndOfStatement();
 
-        this.writer.EndBlock();
-        this.writer.EndOfStatement();
+            caseExpressions.forEach((expression, index) => {
+                if (index > 0) {
+                    this.writer.writeString('else ');
+                }
 
+                this.writer.writeString(`if (strict_equals(${switchName}_value, `);
+                this.processExpression(expression);
+                this.writer.writeString(`)) ${switchName} = ${index + 1}`);
+                this.writer.EndOfStatement();
+            });
 
-        this.writer.writeString(`switch (${switchName}[`);
-        this.processExpression(node.expression);
-        this.writer.writeStringNewLine('])');
+            this.writer.writeStringNewLine(`switch (${switchName})`);
+        }
 
         this.writer.BeginBlock();
 
-        caseNumber = 0;
+        let caseNumber = 0;
         node.caseBlock.clauses.forEach(element => {
             this.writer.DecreaseIntent();
             if (element.kind === ts.SyntaxKind.CaseClause) {
@@ -2970,6 +3333,10 @@ export class Emitter {
         });
 
         this.writer.EndBlock();
+
+        if (!isStringSwitch) {
+            this.writer.EndBlock();
+        }
     }
 
     private processBlock(node: ts.Block): void {
@@ -3073,7 +3440,81 @@ export class Emitter {
         this.writer.writeString('))');
     }
 
+    /**
+     * Returns type node of interface which the literal initializes if the interface is emitted as plain struct with fields:
+     * declared in compiled sources, not generic, only property signatures and the literal sets only those properties.
+     */
+    private getObjectLiteralShape(node: ts.ObjectLiteralExpression): ts.TypeNode {
+        if ((<any>node).__stack_storage) {
+            return undefined;
+        }
+
+        const type = this.resolver.getContextualType(node);
+        const symbol = type && type.symbol;
+        if (!symbol
+            || !(symbol.flags & ts.SymbolFlags.Interface)
+            || !symbol.declarations.every(d => d.kind === ts.SyntaxKind.InterfaceDeclaration
+                && !(<ts.InterfaceDeclaration>d).typeParameters
+                && !d.getSourceFile().isDeclarationFile)) {
+            return undefined;
+        }
+
+        const properties = type.getProperties();
+        const isField = (p: ts.Symbol) => p.declarations
+            && p.declarations.every(d => d.kind === ts.SyntaxKind.PropertySignature
+                && (<ts.PropertySignature>d).name.kind === ts.SyntaxKind.Identifier
+                && !d.getSourceFile().isDeclarationFile);
+        if (!properties.every(isField)) {
+            return undefined;
+        }
+
+        const names = properties.map(p => p.name);
+        const isFieldInitializer = (p: ts.ObjectLiteralElementLike) =>
+            (p.kind === ts.SyntaxKind.PropertyAssignment || p.kind === ts.SyntaxKind.ShorthandPropertyAssignment)
+            && p.name.kind === ts.SyntaxKind.Identifier
+            && names.indexOf((<ts.Identifier>p.name).text) >= 0;
+        if (!node.properties.every(isFieldInitializer)) {
+            return undefined;
+        }
+
+        return this.resolver.typeToTypeNode(type);
+    }
+
+    private processObjectLiteralAsStruct(node: ts.ObjectLiteralExpression, shape: ts.TypeNode): void {
+        // a braced list evaluates the initializers in order
+        this.writer.writeString('new_with<');
+        this.processType(shape, false, true);
+        this.writer.writeString('>(std::tuple{');
+
+        let next = false;
+        node.properties.forEach(element => {
+            if (next) {
+                this.writer.writeString(', ');
+            }
+
+            this.writer.writeString('field(&');
+            this.processType(shape, false, true);
+            this.writer.writeString('::');
+            this.processExpression(<ts.Identifier>element.name);
+            this.writer.writeString(', ');
+            this.processExpression(element.kind === ts.SyntaxKind.PropertyAssignment
+                ? (<ts.PropertyAssignment>element).initializer
+                : <ts.Identifier>element.name);
+            this.writer.writeString(')');
+
+            next = true;
+        });
+
+        this.writer.writeString('})');
+    }
+
     private processObjectLiteralExpression(node: ts.ObjectLiteralExpression): void {
+        const shape = this.getObjectLiteralShape(node);
+        if (shape) {
+            this.processObjectLiteralAsStruct(node, shape);
+            return;
+        }
+
         let next = false;
 
         const hasSpreadAssignment = node.properties.some(e => e.kind === ts.SyntaxKind.SpreadAssignment);
@@ -3082,7 +3523,16 @@ export class Emitter {
             this.writer.writeString('utils::assign(');
         }
 
-        this.writer.writeString('object');
+        const stackStorage = (<any>node).__stack_storage;
+        if (stackStorage) {
+            this.writer.writeString(`object(ref_of(&${stackStorage})`);
+            if (node.properties.length !== 0) {
+                this.writer.writeString(', ');
+            }
+        } else {
+            this.writer.writeString('object');
+        }
+
         if (node.properties.length !== 0) {
             this.writer.BeginBlock();
             node.properties.forEach(element => {
@@ -3120,14 +3570,7 @@ export class Emitter {
                     }
 
                     this.writer.writeString(', ');
-                    if (property.name
-                        && (property.name.kind === ts.SyntaxKind.Identifier
-                            || property.name.kind === ts.SyntaxKind.NumericLiteral)) {
-                        this.processExpression(ts.createStringLiteral(property.name.text));
-                    } else {
-                        this.processExpression(<ts.Expression>property.name);
-                    }
-
+                    this.processExpression(property.name);
                     this.writer.writeString('}');
                 }
 
@@ -3135,10 +3578,14 @@ export class Emitter {
             });
 
             this.writer.EndBlock(true);
-        } else {
+        } else if (!stackStorage) {
             this.writer.writeString('{}');
         }
 
+        if (stackStorage) {
+            this.writer.writeString(')');
+        }
+
         if (hasSpreadAssignment) {
             node.properties.forEach(element => {
                 if (element.kind === ts.SyntaxKind.SpreadAssignment) {
@@ -3155,17 +3602,7 @@ export class Emitter {
         this.processExpression(node.expression);
     }
 
-    private processArrayLiteralExpression(node: ts.ArrayLiteralExpression): void {
-        let next = false;
-
-        const isDeconstruct = node.parent && node.parent.kind === ts.SyntaxKind.BinaryExpression
-            && (<ts.BinaryExpression>node.parent).left === node;
-        let isTuple = false;
-        const type = this.resolver.typeToTypeNode(this.resolver.getOrResolveTypeOf(node));
-        if (type.kind === ts.SyntaxKind.TupleType) {
-            isTuple = true;
-        }
-
+    private processArrayLiteralType(node: ts.ArrayLiteralExpression): void {
         let elementsType = (<any>node).parent.type;
         if (!elementsType) {
             if (node.elements.length !== 0) {
@@ -3179,6 +3616,27 @@ export class Emitter {
             }
         }
 
+        this.writer.writeString('array<');
+        if (elementsType) {
+            this.processType(elementsType, false);
+        } else {
+            this.writer.writeString('any');
+        }
+
+        this.writer.writeString('>');
+    }
+
+    private processArrayLiteralExpression(node: ts.ArrayLiteralExpression): void {
+        let next = false;
+
+        const isDeconstruct = node.parent && node.parent.kind === ts.SyntaxKind.BinaryExpression
+            && (<ts.BinaryExpression>node.parent).left === node;
+        let isTuple = false;
+        const type = this.resolver.typeToTypeNode(this.resolver.getOrResolveTypeOf(node));
+        if (type.kind === ts.SyntaxKind.TupleType) {
+            isTuple = true;
+        }
+
         if (isDeconstruct) {
             this.writer.writeString('std::tie(');
             node.elements.forEach(element => {
@@ -3196,18 +3654,19 @@ export class Emitter {
         }
 
         if (!isTuple) {
-            this.writer.writeString('array<');
-            if (elementsType) {
-                this.processType(elementsType, false);
-            } else {
-                this.writer.writeString('any');
-            }
-
-            this.writer.writeString('>');
+            this.processArrayLiteralType(node);
         } else {
             this.processType(type);
         }
 
+        const stackStorage = (<any>node).__stack_storage;
+        if (stackStorage) {
+            this.writer.writeString(`(ref_of(&${stackStorage})`);
+            if (node.elements.length !== 0) {
+                this.writer.writeString(', ');
+            }
+        }
+
         if (node.elements.length !== 0) {
             this.writer.BeginBlockNoIntent();
             node.elements.forEach(element => {
@@ -3221,9 +3680,13 @@ export class Emitter {
             });
 
             this.writer.EndBlockNoIntent();
-        } else {
+        } else if (!stackStorage) {
             this.writer.writeString('()');
         }
+
+        if (stackStorage) {
+            this.writer.writeString(')');
+        }
     }
 
     private processElementAccessExpression(node: ts.ElementAccessExpression): void {
@@ -3392,8 +3855,19 @@ export class Emitter {
 
         const wrapIntoRoundBrackets =
             opCode === ts.SyntaxKind.AmpersandAmpersandToken
-            || opCode === ts.SyntaxKind.BarBarToken;
-        const op = this.opsMap[node.operatorToken.kind];
+            || opCode === ts.SyntaxKind.BarBarToken
+            || opCode === ts.SyntaxKind.QuestionQuestionToken;
+        if (wrapIntoRoundBrackets && this.processLogicalExpressionAsTernary(node)) {
+            return;
+        }
+
+        if (this.processBinaryExpressionWithTypeFeedback(node)) {
+            return;
+        }
+
+        const op = this.isStrictEqualityEnough(node)
+            ? (opCode === ts.SyntaxKind.EqualsEqualsToken ? '==' : '!=')
+            : this.opsMap[node.operatorToken.kind];
         const isFunction = op.substr(0, 2) === '__';
         if (isFunction) {
             this.writer.writeString(op.substr(2) + '(');
@@ -3463,6 +3937,211 @@ export class Emitter {
         }
     }
 
+    /**
+     * Operators with operands typed any: -profile_generate records the types the operands have at runtime,
+     * -profile_use gives operators whose operands were numbers a number fast path behind a type check
+     */
+    private processBinaryExpressionWithTypeFeedback(node: ts.BinaryExpression): boolean {
+        const functor = this.getNumberFunctor(node.operatorToken.kind);
+        if (!functor) {
+            return false;
+        }
+
+        const generate = this.cmdLineOptions && this.cmdLineOptions.profile_generate;
+        const profile = this.typeProfile;
+        if (!generate && !profile) {
+            return false;
+        }
+
+        const operands = [node.left, node.right];
+        const types = operands.map(o => this.resolver.getOrResolveTypeOf(o));
+        const isAny = types.map(t => t && (t.flags & ts.TypeFlags.Any) !== 0);
+        const isNumber = types.map(t => t && (t.flags & ts.TypeFlags.NumberLike) !== 0 && (t.flags & ts.TypeFlags.EnumLike) === 0);
+        const locations = operands.map(o => this.getSourceLocation(o));
+        if (!isAny.some(a => a) || operands.some((o, i) => isAny[i] ? !locations[i] : !isNumber[i])) {
+            return false;
+        }
+
+        const fastPath = profile && operands.every((o, i) => !isAny[i] || profile.isMostly(locations[i], 'number'));
+        if (!generate && !fastPath) {
+            return false;
+        }
+
+        if (fastPath) {
+            this.writer.writeString(`type_feedback::numbers<${functor}>(`);
+        }
+
+        operands.forEach((o, i) => {
+            if (i > 0) {
+                this.writer.writeString(fastPath ? ', ' : ' ' + this.opsMap[node.operatorToken.kind] + ' ');
+            }
+
+            if (generate && isAny[i]) {
+                this.writer.writeString(`JS_OBSERVE(${JSON.stringify(locations[i])}, `);
+                this.processExpression(o);
+                this.writer.writeString(')');
+            } else {
+                this.processExpression(o);
+            }
+        });
+
+        if (fastPath) {
+            this.writer.writeString(')');
+        }
+
+        return true;
+    }
+
+    private getNumberFunctor(kind: ts.SyntaxKind): string {
+        switch (kind) {
+            case ts.SyntaxKind.PlusToken:
+                return 'std::plus<>';
+            case ts.SyntaxKind.MinusToken:
+                return 'std::minus<>';
+            case ts.SyntaxKind.AsteriskToken:
+                return 'std::multiplies<>';
+            case ts.SyntaxKind.SlashToken:
+                return 'std::divides<>';
+            case ts.SyntaxKind.LessThanToken:
+                return 'std::less<>';
+            case ts.SyntaxKind.LessThanEqualsToken:
+                return 'std::less_equal<>';
+            case ts.SyntaxKind.GreaterThanToken:
+                return 'std::greater<>';
+            case ts.SyntaxKind.GreaterThanEqualsToken:
+                return 'std::greater_equal<>';
+        }
+
+        return undefined;
+    }
+
+    // file:line:column in the TypeScript source, the key of a location in the type profile
+    private getSourceLocation(node: ts.Node): string {
+        const sourceFile = node.pos >= 0 && node.getSourceFile();
+        if (!sourceFile) {
+            return undefined;
+        }
+
+        const position = sourceFile.getLineAndCharacterOfPosition(node.getStart(sourceFile));
+        const filePath = Helpers.getSubPath(Helpers.cleanUpPath(sourceFile.fileName), Helpers.cleanUpPath(this.rootFolder))
+            .replace(/^\//, '');
+        return filePath + ':' + (position.line + 1) + ':' + (position.character + 1);
+    }
+
+    // category of statically known type, undefined for any, unions of different types and type parameters
+    private getStaticTypeCategory(type: ts.Type): ts.TypeFlags | ts.Type {
+        if (!type || this.resolver.isNotDetected(type)) {
+            return undefined;
+        }
+
+        if (type.flags & ts.TypeFlags.BooleanLike) {
+            return ts.TypeFlags.BooleanLike;
+        }
+
+        if (type.flags & ts.TypeFlags.NumberLike) {
+            return ts.TypeFlags.NumberLike;
+        }
+
+        if (type.flags & ts.TypeFlags.StringLike) {
+            return ts.TypeFlags.StringLike;
+        }
+
+        if (type.flags & (ts.TypeFlags.Object | ts.TypeFlags.Enum)) {
+            return type;
+        }
+
+        return undefined;
+    }
+
+    // == against a literal of the same primitive type can't convert types and compares as ===
+    private isStrictEqualityEnough(node: ts.BinaryExpression): boolean {
+        const opCode = node.operatorToken.kind;
+        if (opCode !== ts.SyntaxKind.EqualsEqualsToken && opCode !== ts.SyntaxKind.ExclamationEqualsToken) {
+            return false;
+        }
+
+        const isLiteral = (n: ts.Expression) => n.kind === ts.SyntaxKind.NumericLiteral
+            || n.kind === ts.SyntaxKind.StringLiteral
+            || n.kind === ts.SyntaxKind.NoSubstitutionTemplateLiteral
+            || n.kind === ts.SyntaxKind.TrueKeyword
+            || n.kind === ts.SyntaxKind.FalseKeyword;
+        if (!isLiteral(node.left) && !isLiteral(node.right)) {
+            return false;
+        }
+
+        const leftCategory = this.getStaticTypeCategory(this.resolver.getOrResolveTypeOf(node.left));
+        return (leftCategory === ts.TypeFlags.NumberLike
+                || leftCategory === ts.TypeFlags.StringLike
+                || leftCategory === ts.TypeFlags.BooleanLike)
+            && leftCategory === this.getStaticTypeCategory(this.resolver.getOrResolveTypeOf(node.right));
+    }
+
+    // reading expression twice has the same effect as reading it once
+    private isPureExpression(node: ts.Expression): boolean {
+        switch (node.kind) {
+            case ts.SyntaxKind.Identifier:
+            case ts.SyntaxKind.ThisKeyword:
+            case ts.SyntaxKind.NumericLiteral:
+            case ts.SyntaxKind.StringLiteral:
+            case ts.SyntaxKind.TrueKeyword:
+            case ts.SyntaxKind.FalseKeyword:
+                return true;
+            case ts.SyntaxKind.ParenthesizedExpression:
+                return this.isPureExpression((<ts.ParenthesizedExpression>node).expression);
+            case ts.SyntaxKind.PropertyAccessExpression:
+                const symbol = this.resolver.getSymbolAtLocation((<ts.PropertyAccessExpression>node).name);
+                const isAccessor = symbol && symbol.declarations && symbol.declarations.some(
+                    d => d.kind === ts.SyntaxKind.GetAccessor || d.kind === ts.SyntaxKind.SetAccessor);
+                return !isAccessor && this.isPureExpression((<ts.PropertyAccessExpression>node).expression);
+        }
+
+        return false;
+    }
+
+    /**
+     * Lowers ||, && and ?? over statically typed operands of the same type to a ternary,
+     * the left operand is read in place instead of being copied into a lambda frame.
+     */
+    private processLogicalExpressionAsTernary(node: ts.BinaryExpression): boolean {
+        const leftCategory = this.getStaticTypeCategory(this.resolver.getOrResolveTypeOf(node.left));
+        if (!leftCategory
+            || leftCategory !== this.getStaticTypeCategory(this.resolver.getOrResolveTypeOf(node.right))
+            || !this.isPureExpression(node.left)) {
+            return false;
+        }
+
+        const writeLeft = () => {
+            this.writer.writeString('(');
+            this.processExpression(node.left);
+            this.writer.writeString(')');
+        };
+
+        const writeRight = () => {
+            this.writer.writeString('static_cast<std::decay_t<decltype(');
+            writeLeft();
+            this.writer.writeString(')>>(');
+            this.processExpression(node.right);
+            this.writer.writeString(')');
+        };
+
+        const opCode = node.operatorToken.kind;
+        this.writer.writeString(opCode === ts.SyntaxKind.QuestionQuestionToken ? '(is_nullish(' : '(truthy(');
+        writeLeft();
+        this.writer.writeString(') ? ');
+        if (opCode === ts.SyntaxKind.BarBarToken) {
+            writeLeft();
+            this.writer.writeString(' : ');
+            writeRight();
+        } else {
+            writeRight();
+            this.writer.writeString(' : ');
+            writeLeft();
+        }
+
+        this.writer.writeString(')');
+        return true;
+    }
+
     private processDeleteExpression(node: ts.DeleteExpression): void {
         if (node.expression.kind === ts.SyntaxKind.PropertyAccessExpression) {
             const propertyAccess = <ts.PropertyAccessExpression>node.expression;
@@ -3493,14 +4172,56 @@ export class Emitter {
         }
     }
 
+    // JSON.parse(text) as Interface reads straight into the emitted struct without building any
+    private processTypedJsonParse(node: ts.CallExpression | ts.NewExpression): boolean {
+        if (node.kind !== ts.SyntaxKind.CallExpression
+            || node.arguments.length !== 1
+            || node.expression.kind !== ts.SyntaxKind.PropertyAccessExpression) {
+            return false;
+        }
+
+        const callee = <ts.PropertyAccessExpression>node.expression;
+        const symbol = this.resolver.getSymbolAtLocation(callee.expression);
+        const declaration = symbol && symbol.valueDeclaration;
+        if (callee.name.text !== 'parse'
+            || callee.expression.kind !== ts.SyntaxKind.Identifier
+            || (<ts.Identifier>callee.expression).text !== 'JSON'
+            || !declaration
+            || !declaration.getSourceFile().isDeclarationFile) {
+            return false;
+        }
+
+        const type = this.resolver.getContextualType(<ts.CallExpression>node);
+        if (!this.jsonSchema.isReadableType(type)) {
+            return false;
+        }
+
+        this.writer.writeString('JSON->parse<');
+        this.processType(this.resolver.typeToTypeNode(type));
+        this.writer.writeString('>(');
+        this.processExpression(node.arguments[0]);
+        this.writer.writeString(')');
+        return true;
+    }
+
     private processCallExpression(node: ts.CallExpression | ts.NewExpression): void {
 
+        const stackStorage = (<any>node).__stack_storage;
+        if (stackStorage) {
+            this.writer.writeString(`ref_of(&${stackStorage})`);
+            return;
+        }
+
+        if (this.processTypedJsonParse(node)) {
+            return;
+        }
+
         const isNew = node.kind === ts.SyntaxKind.NewExpression;
         const typeOfExpression = isNew && this.resolver.getOrResolveTypeOf(node.expression);
         const isArray = isNew && typeOfExpression && typeOfExpression.symbol && typeOfExpression.symbol.name === 'ArrayConstructor';
 
         if (node.kind === ts.SyntaxKind.NewExpression && !isArray) {
-            this.writer.writeString('std::make_shared<');
+            this.writer.writeString('new_<');
         }
 
         if (isArray) {
@@ -3517,9 +4238,13 @@ export class Emitter {
         }
 
         this.writer.writeString('(');
+        this.processCallArguments(node);
+        this.writer.writeString(')');
+    }
 
+    private processCallArguments(node: ts.CallExpression | ts.NewExpression): void {
         let next = false;
-        if (node.arguments.length) {
+        if (node.arguments && node.arguments.length) {
             node.arguments.forEach(element => {
                 if (next) {
                     this.writer.writeString(', ');
@@ -3529,8 +4254,6 @@ export class Emitter {
                 next = true;
             });
         }
-
-        this.writer.writeString(')');
     }
 
     private processThisExpression(node: ts.ThisExpression): void {
@@ -3549,10 +4272,8 @@ export class Emitter {
 
         if (node.parent.kind === ts.SyntaxKind.PropertyAccessExpression) {
             this.writer.writeString('this');
-        } else if (method.kind === ts.SyntaxKind.Constructor) {
-            this.writer.writeString('_this');
         } else {
-            this.writer.writeString('shared_from_this()');
+            this.writer.writeString('ref_of(this)');
         }
     }
 
@@ -3642,13 +4363,26 @@ export class Emitter {
             }
         }
 
-        // fix issue with 'continue'
+        // native integer counter read in number context
+        const nativeIntRead = (<any>node).__native_int_read;
+        if (nativeIntRead) {
+            this.writer.writeString('js::number(');
+        }
+
+        // fix issue with 'continue', stdout and stderr are macros in C++
         if (node.text === 'continue'
-            || node.text === 'catch') {
+            || node.text === 'catch'
+            || node.text === 'delete'
+            || node.text === 'stdout'
+            || node.text === 'stderr') {
             this.writer.writeString('_');
         }
 
         this.writer.writeString(node.text);
+
+        if (nativeIntRead) {
+            this.writer.writeString(')');
+        }
     }
 
     private processPropertyAccessExpression(node: ts.PropertyAccessExpression): void {
@@ -3665,7 +4399,8 @@ export class Emitter {
             && symbolInfo.declarations.length > 0
             && (symbolInfo.declarations[0].kind === ts.SyntaxKind.GetAccessor
                 || symbolInfo.declarations[0].kind === ts.SyntaxKind.SetAccessor)
-            || node.name.text === 'length' && this.resolver.isArrayOrStringType(typeInfo);
+            || node.name.text === 'length' && this.resolver.isArrayOrStringType(typeInfo)
+            || node.name.text === 'size' && this.resolver.isKeyedCollectionType(typeInfo);
 
         if (methodAccess) {
             if (isStaticMethodAccess) {
@@ -0,0 +1,289 @@
+import * as ts from 'typescript';
+import { IdentifierResolver } from './resolvers';
+import { Helpers } from './helpers';
+
+export class EscapeAnalysis {
+
+    // array methods which call the callback synchronously and never store it
+    private static readonly nonEscapingCallbackMethods = [
+        'forEach', 'map', 'filter', 'reduce', 'reduceRight', 'some', 'every', 'find', 'findIndex', 'sort', 'flatMap'];
+
+    // array methods which return the receiver itself
+    private static readonly returnsThisMethods = ['sort', 'reverse', 'fill', 'copyWithin'];
+
+    private classCache: Map<ts.Node, boolean> = new Map<ts.Node, boolean>();
+
+    public constructor(private resolver: IdentifierResolver) {
+    }
+
+    public static isFunctionLike(node: ts.Node): boolean {
+        return node.kind === ts.SyntaxKind.FunctionDeclaration
+            || node.kind === ts.SyntaxKind.FunctionExpression
+            || node.kind === ts.SyntaxKind.ArrowFunction
+            || node.kind === ts.SyntaxKind.MethodDeclaration
+            || node.kind === ts.SyntaxKind.Constructor
+            || node.kind === ts.SyntaxKind.GetAccessor
+            || node.kind === ts.SyntaxKind.SetAccessor;
+    }
+
+    public static getContainer(location: ts.Node): ts.Node {
+        let node = location.parent;
+        while (node && !EscapeAnalysis.isFunctionLike(node) && node.kind !== ts.SyntaxKind.SourceFile) {
+            node = node.parent;
+        }
+
+        return node;
+    }
+
+    /**
+     * Returns true when the closure can't outlive the frame it was created in:
+     * an IIFE or a callback passed directly to a synchronous array method.
+     */
+    public isNonEscapingClosure(node: ts.Node): boolean {
+        if (node.kind !== ts.SyntaxKind.ArrowFunction && node.kind !== ts.SyntaxKind.FunctionExpression) {
+            return false;
+        }
+
+        let child = node;
+        let parent = node.parent;
+        while (parent && parent.kind === ts.SyntaxKind.ParenthesizedExpression) {
+            child = parent;
+            parent = parent.parent;
+        }
+
+        if (!parent || parent.kind !== ts.SyntaxKind.CallExpression) {
+            return false;
+        }
+
+        const callExpression = <ts.CallExpression>parent;
+        if (callExpression.expression === child) {
+            return true;
+        }
+
+        if (callExpression.arguments.indexOf(<ts.Expression>child) < 0
+            || callExpression.expression.kind !== ts.SyntaxKind.PropertyAccessExpression) {
+            return false;
+        }
+
+        const propertyAccess = <ts.PropertyAccessExpression>callExpression.expression;
+        return EscapeAnalysis.nonEscapingCallbackMethods.indexOf(propertyAccess.name.text) >= 0
+            && this.resolver.isArrayType(this.resolver.getOrResolveTypeOf(propertyAccess.expression));
+    }
+
+    /**
+     * Returns functions between reference and the declaration of the referenced value
+     * if all of them are non-escaping closures, otherwise undefined.
+     */
+    public getNonEscapingClosures(reference: ts.Node, declaration: ts.Node): ts.Node[] {
+        const container = EscapeAnalysis.getContainer(declaration);
+        const closures: ts.Node[] = [];
+        let node = reference.parent;
+        while (node && node !== container) {
+            if (EscapeAnalysis.isFunctionLike(node) || node.kind === ts.SyntaxKind.ClassDeclaration) {
+                if (!this.isNonEscapingClosure(node)) {
+                    return undefined;
+                }
+
+                closures.push(node);
+            }
+
+            node = node.parent;
+        }
+
+        return node ? closures : undefined;
+    }
+
+    /**
+     * Returns true when value created by initializer of the declaration never leaves the frame
+     * and can be allocated on the stack.
+     */
+    public isStackAllocatable(declaration: ts.VariableDeclaration): boolean {
+        if (!declaration.initializer || declaration.name.kind !== ts.SyntaxKind.Identifier) {
+            return false;
+        }
+
+        const declarationList = <ts.VariableDeclarationList>declaration.parent;
+        if (!declarationList
+            || declarationList.kind !== ts.SyntaxKind.VariableDeclarationList
+            || declarationList.declarations.length !== 1
+            || !Helpers.isConstOrLet(declarationList)
+            || !declarationList.parent
+            || declarationList.parent.kind !== ts.SyntaxKind.VariableStatement
+            || !declarationList.parent.parent
+            || declarationList.parent.parent.kind !== ts.SyntaxKind.Block) {
+            return false;
+        }
+
+        const container = EscapeAnalysis.getContainer(declaration);
+        if (!container
+            || container.kind === ts.SyntaxKind.SourceFile
+            || (<ts.FunctionLikeDeclaration>container).asteriskToken
+            || ts.getCombinedModifierFlags(<ts.Declaration>container) & ts.ModifierFlags.Async) {
+            return false;
+        }
+
+        if (!this.isStackAllocatableInitializer(declaration)) {
+            return false;
+        }
+
+        const symbol = this.resolver.getSymbolAtLocation(declaration.name);
+        if (!symbol) {
+            return false;
+        }
+
+        let escapes = false;
+        const name = (<ts.Identifier>declaration.name).text;
+        const visit = (node: ts.Node) => {
+            if (escapes) {
+                return;
+            }
+
+            if (node.kind === ts.SyntaxKind.Identifier
+                && node !== declaration.name
+                && (<ts.Identifier>node).text === name
+                && this.resolver.getSymbolAtLocation(node) === symbol) {
+                escapes = EscapeAnalysis.getContainer(node) !== container || !this.isNonEscapingUse(<ts.Identifier>node);
+                return;
+            }
+
+            ts.forEachChild(node, visit);
+        };
+
+        ts.forEachChild(declarationList.parent.parent, visit);
+        return !escapes;
+    }
+
+    private isStackAllocatableInitializer(declaration: ts.VariableDeclaration): boolean {
+        const initializer = declaration.initializer;
+        switch (initializer.kind) {
+            case ts.SyntaxKind.NewExpression:
+                if (declaration.type) {
+                    return false;
+                }
+
+                const newExpression = <ts.NewExpression>initializer;
+                const classSymbol = this.resolver.getSymbolAtLocation(newExpression.expression);
+                const classDeclaration = classSymbol && classSymbol.valueDeclaration;
+                return classDeclaration
+                    && classDeclaration.kind === ts.SyntaxKind.ClassDeclaration
+                    && !(newExpression.arguments || []).some(a => a.kind === ts.SyntaxKind.SpreadElement)
+                    && this.isStackAllocatableClass(<ts.ClassDeclaration>classDeclaration);
+            case ts.SyntaxKind.ObjectLiteralExpression:
+                return (!declaration.type || declaration.type.kind === ts.SyntaxKind.TypeLiteral)
+                    && (<ts.ObjectLiteralExpression>initializer).properties.every(
+                        p => p.kind === ts.SyntaxKind.PropertyAssignment || p.kind === ts.SyntaxKind.ShorthandPropertyAssignment);
+            case ts.SyntaxKind.ArrayLiteralExpression:
+                const type = this.resolver.typeToTypeNode(this.resolver.getOrResolveTypeOf(initializer));
+                return (!declaration.type || declaration.type.kind === ts.SyntaxKind.ArrayType)
+                    && type && type.kind !== ts.SyntaxKind.TupleType
+                    && !(<ts.ArrayLiteralExpression>initializer).elements.some(e => e.kind === ts.SyntaxKind.SpreadElement);
+        }
+
+        return false;
+    }
+
+    private isNonEscapingUse(reference: ts.Identifier): boolean {
+        const parent = reference.parent;
+        switch (parent.kind) {
+            case ts.SyntaxKind.ElementAccessExpression:
+                return (<ts.ElementAccessExpression>parent).expression === reference;
+            case ts.SyntaxKind.ForOfStatement:
+            case ts.SyntaxKind.ForInStatement:
+                return (<ts.ForOfStatement>parent).expression === reference;
+            case ts.SyntaxKind.PropertyAccessExpression:
+                const propertyAccess = <ts.PropertyAccessExpression>parent;
+                if (propertyAccess.expression !== reference) {
+                    return false;
+                }
+
+                if (!this.isMethod(propertyAccess)) {
+                    return true;
+                }
+
+                // method reference binds the receiver
+                const call = <ts.CallExpression>propertyAccess.parent;
+                if (call.kind !== ts.SyntaxKind.CallExpression || call.expression !== propertyAccess) {
+                    return false;
+                }
+
+                if (EscapeAnalysis.returnsThisMethods.indexOf(propertyAccess.name.text) >= 0
+                    && call.parent.kind !== ts.SyntaxKind.ExpressionStatement) {
+                    return false;
+                }
+
+                // callback receiving the array as the third parameter
+                return !call.arguments.some(
+                    a => (a.kind === ts.SyntaxKind.ArrowFunction || a.kind === ts.SyntaxKind.FunctionExpression)
+                        && (<ts.FunctionLikeDeclaration>a).parameters.length > 2);
+        }
+
+        return false;
+    }
+
+    private isMethod(propertyAccess: ts.PropertyAccessExpression): boolean {
+        const symbol = this.resolver.getSymbolAtLocation(propertyAccess.name);
+        const declaration = symbol && (symbol.valueDeclaration || (symbol.declarations && symbol.declarations[0]));
+        return declaration
+            && (declaration.kind === ts.SyntaxKind.MethodDeclaration || declaration.kind === ts.SyntaxKind.MethodSignature);
+    }
+
+    private isStackAllocatableClass(classDeclaration: ts.ClassDeclaration): boolean {
+        if (this.classCache.has(classDeclaration)) {
+            return this.classCache.get(classDeclaration);
+        }
+
+        // break recursion
+        this.classCache.set(classDeclaration, false);
+
+        const flags = ts.getCombinedModifierFlags(classDeclaration);
+        let result = !(flags & ts.ModifierFlags.Ambient)
+            && !(flags & ts.ModifierFlags.Abstract)
+            && !classDeclaration.typeParameters;
+
+        // base classes
+        if (result && classDeclaration.heritageClauses) {
+            classDeclaration.heritageClauses
+                .filter(h => h.token === ts.SyntaxKind.ExtendsKeyword)
+                .forEach(h => h.types.forEach(t => {
+                    const baseSymbol = this.resolver.getSymbolAtLocation(t.expression);
+                    const baseDeclaration = baseSymbol && baseSymbol.valueDeclaration;
+                    result = result
+                        && baseDeclaration
+                        && baseDeclaration.kind === ts.SyntaxKind.ClassDeclaration
+                        && this.isStackAllocatableClass(<ts.ClassDeclaration>baseDeclaration);
+                }));
+        }
+
+        // 'this' can be used only to access members
+        const visit = (node: ts.Node, nested: boolean) => {
+            if (!result) {
+                return;
+            }
+
+            if (node.kind === ts.SyntaxKind.ThisKeyword) {
+                const propertyAccess = <ts.PropertyAccessExpression>node.parent;
+                result = !nested
+                    && propertyAccess.kind === ts.SyntaxKind.PropertyAccessExpression
+                    && propertyAccess.expression === node
+                    && (!this.isMethod(propertyAccess)
+                        || propertyAccess.parent.kind === ts.SyntaxKind.CallExpression
+                            && (<ts.CallExpression>propertyAccess.parent).expression === propertyAccess);
+                return;
+            }
+
+            const isNested = nested
+                || node.kind === ts.SyntaxKind.ArrowFunction
+                || node.kind === ts.SyntaxKind.FunctionExpression
+                || node.kind === ts.SyntaxKind.FunctionDeclaration
+                || node.kind === ts.SyntaxKind.ClassExpression;
+            ts.forEachChild(node, child => visit(child, isNested));
+        };
+
+        classDeclaration.members
+            .filter(m => !(ts.getCombinedModifierFlags(m) & ts.ModifierFlags.Static))
+            .forEach(m => visit(m, false));
+
+        this.classCache.set(classDeclaration, result);
+        return result;
+    }
+}
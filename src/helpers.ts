@@ -34,6 +34,60 @@ export class Helpers {
         return beginPath + fileNameFixed + endExt;
     }
 
+    /**
+     * Files of the program a file imports directly
+     */
+    public static getImportedFiles(program: ts.Program, sourceFile: ts.SourceFile): ts.SourceFile[] {
+        const typeChecker = program.getTypeChecker();
+        const imported: ts.SourceFile[] = [];
+        sourceFile.statements.forEach(statement => {
+            let moduleSpecifier: ts.Expression;
+            switch (statement.kind) {
+                case ts.SyntaxKind.ImportDeclaration:
+                    moduleSpecifier = (<ts.ImportDeclaration>statement).moduleSpecifier;
+                    break;
+                case ts.SyntaxKind.ExportDeclaration:
+                    moduleSpecifier = (<ts.ExportDeclaration>statement).moduleSpecifier;
+                    break;
+                case ts.SyntaxKind.ImportEqualsDeclaration:
+                    const reference = (<ts.ImportEqualsDeclaration>statement).moduleReference;
+                    if (reference.kind === ts.SyntaxKind.ExternalModuleReference) {
+                        moduleSpecifier = (<ts.ExternalModuleReference>reference).expression;
+                    }
+
+                    break;
+            }
+
+            const symbol = moduleSpecifier && typeChecker.getSymbolAtLocation(moduleSpecifier);
+            const declaration = symbol && symbol.valueDeclaration;
+            if (declaration && declaration.kind === ts.SyntaxKind.SourceFile && imported.indexOf(<ts.SourceFile>declaration) < 0) {
+                imported.push(<ts.SourceFile>declaration);
+            }
+        });
+
+        return imported;
+    }
+
+    /**
+     * Files in an order where every file comes after the files it imports, otherwise in the given order
+     */
+    public static orderByImports(program: ts.Program, sourceFiles: ts.SourceFile[]): ts.SourceFile[] {
+        const ordered: ts.SourceFile[] = [];
+        const visited: ts.SourceFile[] = [];
+        const visit = (file: ts.SourceFile) => {
+            if (visited.indexOf(file) >= 0) {
+                return;
+            }
+
+            visited.push(file);
+            Helpers.getImportedFiles(program, file).filter(f => sourceFiles.indexOf(f) >= 0).forEach(visit);
+            ordered.push(file);
+        };
+
+        sourceFiles.forEach(visit);
+        return ordered;
+    }
+
     public static cleanUpPath(path: string) {
         if (!path) {
             return;
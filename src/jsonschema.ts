@@ -0,0 +1,189 @@
+import * as ts from 'typescript';
+import { IdentifierResolver } from './resolvers';
+
+export type JsonField = ts.PropertyDeclaration | ts.PropertySignature | ts.ParameterDeclaration;
+
+export class JsonSchema {
+
+    private readableCache = new Map<ts.Node, boolean>();
+    private checking = new Set<ts.Node>();
+
+    public constructor(private resolver: IdentifierResolver) {
+    }
+
+    private static isInSources(node: ts.Node): boolean {
+        return node && !node.getSourceFile().isDeclarationFile;
+    }
+
+    /**
+     * Returns instance fields of the class or interface including fields of its base classes or interfaces
+     * if JSON.stringify can write all of them without going through any, otherwise undefined.
+     */
+    public getFields(node: ts.ClassDeclaration | ts.InterfaceDeclaration): JsonField[] {
+        const fields: JsonField[] = [];
+        if (!this.collectFields(node, fields, [])) {
+            return undefined;
+        }
+
+        const names = fields.map(f => (<ts.Identifier>f.name).text);
+        const unique = fields.filter((f, i) => names.indexOf(names[i]) === i);
+        return unique.every(f => this.isSerializableType(this.getFieldType(f), false)) ? unique : undefined;
+    }
+
+    /**
+     * Returns true when JSON.parse can read straight into fields of the interface: it has only property signatures
+     * of number, string, boolean, any, arrays or such interfaces.
+     */
+    public isReadable(node: ts.InterfaceDeclaration): boolean {
+        if (this.readableCache.has(node)) {
+            return this.readableCache.get(node);
+        }
+
+        // recursive interfaces are assumed readable while their fields are checked
+        if (this.checking.has(node)) {
+            return true;
+        }
+
+        this.checking.add(node);
+        const fields: JsonField[] = [];
+        const methods: ts.Node[] = [];
+        const result = this.collectFields(node, fields, methods)
+            && fields.length > 0
+            && methods.length === 0
+            && fields.every(f => f.kind === ts.SyntaxKind.PropertySignature && this.isSerializableType(this.getFieldType(f), true));
+        this.checking.delete(node);
+
+        // result relying on an assumption about an interface still being checked can't be kept
+        if (!result || this.checking.size === 0) {
+            this.readableCache.set(node, result);
+        }
+
+        return result;
+    }
+
+    /**
+     * Returns true when JSON.parse result of the type can be read without DOM: readable interface or array of them.
+     */
+    public isReadableType(type: ts.Type): boolean {
+        if (!type || type.flags & ts.TypeFlags.Any) {
+            return false;
+        }
+
+        if (this.resolver.isArrayType(type)) {
+            const typeArguments = this.resolver.getTypeArguments(<ts.TypeReference>type);
+            return typeArguments.length === 1 && this.isReadableType(typeArguments[0]);
+        }
+
+        const declaration = this.getDeclaration(type);
+        return declaration
+            && declaration.kind === ts.SyntaxKind.InterfaceDeclaration
+            && this.isReadable(<ts.InterfaceDeclaration>declaration);
+    }
+
+    private collectFields(node: ts.ClassDeclaration | ts.InterfaceDeclaration, fields: JsonField[], methods: ts.Node[]): boolean {
+        const symbol = node.name && this.resolver.getSymbolAtLocation(node.name);
+        if (!JsonSchema.isInSources(node)
+            || node.typeParameters
+            || !symbol
+            || symbol.declarations.length !== 1) {
+            return false;
+        }
+
+        let valid = true;
+        node.members.forEach(m => {
+            const isStatic = ts.getCombinedModifierFlags(m) & ts.ModifierFlags.Static;
+            switch (m.kind) {
+                case ts.SyntaxKind.PropertyDeclaration:
+                case ts.SyntaxKind.PropertySignature:
+                    valid = valid && m.name.kind === ts.SyntaxKind.Identifier;
+                    if (!isStatic) {
+                        fields.push(<JsonField>m);
+                    }
+
+                    break;
+                case ts.SyntaxKind.Constructor:
+                    (<ts.ConstructorDeclaration>m).parameters
+                        .filter(p => ts.getCombinedModifierFlags(p) & ts.ModifierFlags.AccessibilityModifier)
+                        .forEach(p => {
+                            valid = valid && p.name.kind === ts.SyntaxKind.Identifier;
+                            fields.push(p);
+                        });
+                    break;
+                case ts.SyntaxKind.MethodSignature:
+                case ts.SyntaxKind.MethodDeclaration:
+                case ts.SyntaxKind.GetAccessor:
+                case ts.SyntaxKind.SetAccessor:
+                    methods.push(m);
+                    break;
+                default:
+                    // index and call signatures
+                    valid = false;
+                    break;
+            }
+        });
+
+        if (!valid) {
+            return false;
+        }
+
+        // fields of base classes and interfaces are members of the emitted base struct, implemented interfaces are redeclared
+        const bases = (node.heritageClauses || [])
+            .filter(h => h.token === ts.SyntaxKind.ExtendsKeyword)
+            .map(h => h.types)
+            .reduce((all, types) => all.concat(types), <ts.ExpressionWithTypeArguments[]>[]);
+        return bases.every(b => {
+            const declaration = this.getDeclaration(this.resolver.getTypeAtLocation(b));
+            return (declaration && (declaration.kind === ts.SyntaxKind.ClassDeclaration || declaration.kind === ts.SyntaxKind.InterfaceDeclaration))
+                && this.collectFields(<ts.ClassDeclaration | ts.InterfaceDeclaration>declaration, fields, methods);
+        });
+    }
+
+    private getFieldType(field: JsonField): ts.Type {
+        return this.resolver.getTypeAtLocation(field.name);
+    }
+
+    private getDeclaration(type: ts.Type): ts.Declaration {
+        const declaration = type && type.symbol && type.symbol.declarations && type.symbol.declarations[0];
+        return JsonSchema.isInSources(declaration) ? declaration : undefined;
+    }
+
+    // optional fields are typed as T | undefined
+    private withoutNullable(type: ts.Type): ts.Type {
+        if (!(type.flags & ts.TypeFlags.Union) || type.flags & ts.TypeFlags.BooleanLike) {
+            return type;
+        }
+
+        const types = (<ts.UnionType>type).types.filter(t => !(t.flags & (ts.TypeFlags.Undefined | ts.TypeFlags.Null)));
+        if (types.length > 0 && types.every(t => (t.flags & ts.TypeFlags.BooleanLiteral) !== 0)) {
+            return types[0];
+        }
+
+        return types.length === 1 ? types[0] : undefined;
+    }
+
+    private isSerializableType(type: ts.Type, read: boolean): boolean {
+        type = type && this.withoutNullable(type);
+        if (!type || type.flags & ts.TypeFlags.EnumLike) {
+            return false;
+        }
+
+        if (type.flags & (ts.TypeFlags.Any | ts.TypeFlags.BooleanLike | ts.TypeFlags.NumberLike | ts.TypeFlags.StringLike)) {
+            return true;
+        }
+
+        if (this.resolver.isArrayType(type)) {
+            const typeArguments = this.resolver.getTypeArguments(<ts.TypeReference>type);
+            return typeArguments.length === 1 && this.isSerializableType(typeArguments[0], read);
+        }
+
+        // instances of other emitted classes and interfaces write their own fields
+        const declaration = this.getDeclaration(type);
+        if (!declaration) {
+            return false;
+        }
+
+        return read
+            ? declaration.kind === ts.SyntaxKind.InterfaceDeclaration && this.isReadable(<ts.InterfaceDeclaration>declaration)
+            : declaration.kind === ts.SyntaxKind.InterfaceDeclaration || declaration.kind === ts.SyntaxKind.ClassDeclaration;
+    }
+}
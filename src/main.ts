@@ -24,5 +24,11 @@ function print() {
     Options:
      -watch                                          Watch mode
      -run_after_compile <app.bat|exe>                Run extra application or batch file after compilation
+     -unity                                          Write the whole program into one file, unity.cpp
+     -jobs [N]                                       Emit files in N worker threads, all processors without N.
+                                                     Every thread parses and type checks the whole program again,
+                                                     so memory use grows to about N + 1 times a single thread's
+     -profile_generate                               Record types of 'any' operands at runtime into typescript2cxx.profile
+     -profile_use <file>                             Number fast paths where the profile saw 'any' operands as numbers
      `);
 }
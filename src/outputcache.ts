@@ -0,0 +1,131 @@
+import * as ts from 'typescript';
+import * as fs from 'fs-extra';
+import * as crypto from 'crypto';
+import { ClassIdTable } from './classhierarchy';
+import { Helpers } from './helpers';
+
+interface OutputEntry {
+    hash: string;
+    mtime: number;
+    sources: string[];
+}
+
+interface Manifest {
+    version: number;
+    files: { [fileName: string]: OutputEntry };
+    classIds?: ClassIdTable;
+}
+
+/**
+ * Writes generated files only when their content changed, so make/ninja see new timestamps only on the C++ files
+ * a TypeScript edit really changed. Hashes of the files written and the class ids (see ClassHierarchy) are kept in a
+ * manifest in the output folder.
+ */
+export class OutputCache {
+
+    public static readonly manifestName = 'typescript2cxx.manifest.json';
+    private static readonly manifestVersion = 1;
+
+    private files: { [fileName: string]: OutputEntry } = {};
+
+    // ids the classes had in the last compile, replaced by the ids of this one
+    public classIds: ClassIdTable;
+
+    public constructor(private outDir: string) {
+        const manifestPath = outDir + OutputCache.manifestName;
+        if (!fs.existsSync(manifestPath)) {
+            return;
+        }
+
+        try {
+            const manifest = <Manifest>JSON.parse(fs.readFileSync(manifestPath).toString());
+            if (manifest.version === OutputCache.manifestVersion && manifest.files) {
+                this.files = manifest.files;
+                this.classIds = manifest.classIds;
+            }
+        } catch (e) {
+            // unreadable manifest, every file is compared by its content
+        }
+    }
+
+    private static hash(text: string): string {
+        return crypto.createHash('sha1').update(text).digest('hex');
+    }
+
+    // make syntax: spaces escaped by a backslash, $ doubled
+    private static escapeMakePath(path: string): string {
+        return path.replace(/\\/g, '/').replace(/ /g, '\\ ').replace(/\$/g, '$$$$');
+    }
+
+    /**
+     * TypeScript files the output of a file depends on: the file itself and what it imports, transitively, or all
+     * files of the program without a file, always without the default library and declarations of packages.
+     * Class ids are kept in the manifest, so classes added to other files don't change the output of a file
+     */
+    public static getDependencies(program: ts.Program, sourceFile?: ts.SourceFile): ts.SourceFile[] {
+        const isDependency = (file: ts.SourceFile) => !program.isSourceFileDefaultLibrary(file)
+            && !program.isSourceFileFromExternalLibrary(file);
+        if (!sourceFile) {
+            return program.getSourceFiles().filter(isDependency);
+        }
+
+        const found: ts.SourceFile[] = [];
+        const visit = (file: ts.SourceFile) => {
+            if (found.indexOf(file) < 0 && isDependency(file)) {
+                found.push(file);
+                Helpers.getImportedFiles(program, file).forEach(visit);
+            }
+        };
+
+        visit(sourceFile);
+        return found;
+    }
+
+    /**
+     * Writes the file unless it already has this content, returns true when it was written
+     */
+    public write(fileName: string, text: string, sources: string[]): boolean {
+        const path = this.outDir + fileName;
+        const hash = OutputCache.hash(text);
+        const entry = this.files[fileName];
+        const stat = fs.existsSync(path) ? fs.statSync(path) : undefined;
+
+        // the recorded hash holds while the file is as it was left, a file changed since then is compared by content
+        const unchanged = stat
+            && (entry && entry.mtime === stat.mtimeMs ? entry.hash : OutputCache.hash(fs.readFileSync(path).toString())) === hash;
+
+        if (!unchanged) {
+            fs.writeFileSync(path, text);
+        }
+
+        this.files[fileName] = { hash, mtime: unchanged ? stat.mtimeMs : fs.statSync(path).mtimeMs, sources };
+        return !unchanged;
+    }
+
+    /**
+     * Dependency file in make syntax (also read by ninja): the generated files depend on the TypeScript files
+     * they were generated from, every one of those gets an empty rule so deleting it does not break the build.
+     * ninja keeps the C++ files whose output was not rewritten only when the rule running the compiler has restat = 1
+     */
+    public writeDependencyFile(fileName: string, targets: string[], dependencies: string[]): boolean {
+        const escapedDependencies = dependencies.map(d => OutputCache.escapeMakePath(d));
+        const text = targets.map(t => OutputCache.escapeMakePath(t)).join(' ') + ':'
+            + escapedDependencies.map(d => ' \\\n  ' + d).join('') + '\n'
+            + escapedDependencies.map(d => '\n' + d + ':\n').join('');
+        return this.write(fileName, text, dependencies);
+    }
+
+    /**
+     * Saves the hashes, files in the manifest which were not generated this time stay as they are
+     */
+    public save(): void {
+        const manifest: Manifest = { version: OutputCache.manifestVersion, files: {}, classIds: this.classIds };
+        Object.keys(this.files).sort().forEach(f => manifest.files[f] = this.files[f]);
+
+        const path = this.outDir + OutputCache.manifestName;
+        const text = JSON.stringify(manifest, undefined, 2) + '\n';
+        if (!fs.existsSync(path) || fs.readFileSync(path).toString() !== text) {
+            fs.writeFileSync(path, text);
+        }
+    }
+}
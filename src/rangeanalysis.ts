@@ -0,0 +1,213 @@
+import * as ts from 'typescript';
+import { IdentifierResolver } from './resolvers';
+import { EscapeAnalysis } from './escapeanalysis';
+
+export class RangeAnalysis {
+
+    private static readonly int32Max = 2147483647;
+    private static readonly int32Min = -2147483648;
+    // keep bounds far enough from int64 limits to allow one step over them
+    private static readonly int64Limit = 4611686018427387904;
+
+    public constructor(private resolver: IdentifierResolver) {
+    }
+
+    public static getIntegerLiteral(node: ts.Expression): number {
+        let sign = 1;
+        if (node.kind === ts.SyntaxKind.PrefixUnaryExpression
+            && (<ts.PrefixUnaryExpression>node).operator === ts.SyntaxKind.MinusToken) {
+            sign = -1;
+            node = (<ts.PrefixUnaryExpression>node).operand;
+        }
+
+        if (node.kind !== ts.SyntaxKind.NumericLiteral) {
+            return undefined;
+        }
+
+        const text = (<ts.NumericLiteral>node).text;
+        const value = parseInt(text, 10);
+        return value.toString() === text ? sign * value : undefined;
+    }
+
+    /**
+     * Returns native integer type for counter of 'for' statement if its value provably stays in
+     * integer range for the whole loop, otherwise undefined. References to the counter which need
+     * boxing back into js::number are marked with __native_int_read.
+     */
+    public getCounterType(node: ts.ForStatement): string {
+        const initializer = <ts.VariableDeclarationList>node.initializer;
+        if (!initializer
+            || initializer.kind !== ts.SyntaxKind.VariableDeclarationList
+            || (initializer.flags & ts.NodeFlags.Let) !== ts.NodeFlags.Let
+            || initializer.declarations.length !== 1) {
+            return undefined;
+        }
+
+        const declaration = initializer.declarations[0];
+        if (declaration.name.kind !== ts.SyntaxKind.Identifier
+            || declaration.type && declaration.type.kind !== ts.SyntaxKind.NumberKeyword
+            || !declaration.initializer) {
+            return undefined;
+        }
+
+        const start = RangeAnalysis.getIntegerLiteral(declaration.initializer);
+        if (start === undefined || start < RangeAnalysis.int32Min || start > RangeAnalysis.int32Max) {
+            return undefined;
+        }
+
+        const symbol = this.resolver.getSymbolAtLocation(declaration.name);
+        const isCounter = (n: ts.Node) => n
+            && n.kind === ts.SyntaxKind.Identifier
+            && (<ts.Identifier>n).text === (<ts.Identifier>declaration.name).text
+            && this.resolver.getSymbolAtLocation(n) === symbol;
+
+        const step = this.getStep(node.incrementor, isCounter);
+        if (!step) {
+            return undefined;
+        }
+
+        // condition: counter <op> bound
+        const condition = <ts.BinaryExpression>node.condition;
+        if (!condition || condition.kind !== ts.SyntaxKind.BinaryExpression) {
+            return undefined;
+        }
+
+        let operator = condition.operatorToken.kind;
+        let bound = condition.right;
+        if (!isCounter(condition.left)) {
+            if (!isCounter(condition.right)) {
+                return undefined;
+            }
+
+            bound = condition.left;
+            switch (operator) {
+                case ts.SyntaxKind.LessThanToken: operator = ts.SyntaxKind.GreaterThanToken; break;
+                case ts.SyntaxKind.LessThanEqualsToken: operator = ts.SyntaxKind.GreaterThanEqualsToken; break;
+                case ts.SyntaxKind.GreaterThanToken: operator = ts.SyntaxKind.LessThanToken; break;
+                case ts.SyntaxKind.GreaterThanEqualsToken: operator = ts.SyntaxKind.LessThanEqualsToken; break;
+            }
+        }
+
+        const increasing = operator === ts.SyntaxKind.LessThanToken || operator === ts.SyntaxKind.LessThanEqualsToken;
+        const decreasing = operator === ts.SyntaxKind.GreaterThanToken || operator === ts.SyntaxKind.GreaterThanEqualsToken;
+        if (!(increasing && step > 0 || decreasing && step < 0) || this.references(bound, isCounter)) {
+            return undefined;
+        }
+
+        let type: string;
+        const boundValue = RangeAnalysis.getIntegerLiteral(bound);
+        if (boundValue !== undefined) {
+            const low = Math.min(start, boundValue) - Math.abs(step);
+            const high = Math.max(start, boundValue) + Math.abs(step);
+            if (low >= RangeAnalysis.int32Min && high <= RangeAnalysis.int32Max) {
+                type = 'int32_t';
+            } else if (low >= -RangeAnalysis.int64Limit && high <= RangeAnalysis.int64Limit) {
+                type = 'int64_t';
+            }
+        } else if (this.isLength(bound) || Math.abs(step) === 1) {
+            // length is below 2^53, unit step can't reach 2^63 in any real run
+            type = 'int64_t';
+        }
+
+        if (!type || !this.markReads(node, isCounter)) {
+            return undefined;
+        }
+
+        return type;
+    }
+
+    public isLength(node: ts.Expression): boolean {
+        return node.kind === ts.SyntaxKind.PropertyAccessExpression
+            && (<ts.PropertyAccessExpression>node).name.text === 'length'
+            && this.resolver.isArrayOrStringType(this.resolver.getOrResolveTypeOf((<ts.PropertyAccessExpression>node).expression));
+    }
+
+    private getStep(incrementor: ts.Expression, isCounter: (n: ts.Node) => boolean): number {
+        if (!incrementor) {
+            return undefined;
+        }
+
+        switch (incrementor.kind) {
+            case ts.SyntaxKind.PrefixUnaryExpression:
+            case ts.SyntaxKind.PostfixUnaryExpression:
+                const unary = <ts.PrefixUnaryExpression>incrementor;
+                if (!isCounter(unary.operand)) {
+                    return undefined;
+                }
+
+                return unary.operator === ts.SyntaxKind.PlusPlusToken
+                    ? 1
+                    : unary.operator === ts.SyntaxKind.MinusMinusToken ? -1 : undefined;
+            case ts.SyntaxKind.BinaryExpression:
+                const binary = <ts.BinaryExpression>incrementor;
+                const value = RangeAnalysis.getIntegerLiteral(binary.right);
+                if (!isCounter(binary.left) || !value || value < 0 || value > RangeAnalysis.int32Max) {
+                    return undefined;
+                }
+
+                return binary.operatorToken.kind === ts.SyntaxKind.PlusEqualsToken
+                    ? value
+                    : binary.operatorToken.kind === ts.SyntaxKind.MinusEqualsToken ? -value : undefined;
+        }
+
+        return undefined;
+    }
+
+    private references(location: ts.Node, isCounter: (n: ts.Node) => boolean): boolean {
+        let found = false;
+        const visit = (node: ts.Node) => {
+            found = found || isCounter(node);
+            if (!found) {
+                ts.forEachChild(node, visit);
+            }
+        };
+
+        visit(location);
+        return found;
+    }
+
+    // all uses in the body must be reads in the same frame
+    private markReads(node: ts.ForStatement, isCounter: (n: ts.Node) => boolean): boolean {
+        const reads: ts.Node[] = [];
+        let valid = true;
+        const visit = (current: ts.Node) => {
+            if (!valid) {
+                return;
+            }
+
+            if (isCounter(current)) {
+                const parent = current.parent;
+                const isWrite = (parent.kind === ts.SyntaxKind.PrefixUnaryExpression || parent.kind === ts.SyntaxKind.PostfixUnaryExpression)
+                        && ((<ts.PrefixUnaryExpression>parent).operator === ts.SyntaxKind.PlusPlusToken
+                            || (<ts.PrefixUnaryExpression>parent).operator === ts.SyntaxKind.MinusMinusToken)
+                    || parent.kind === ts.SyntaxKind.BinaryExpression
+                        && (<ts.BinaryExpression>parent).left === current
+                        && (<ts.BinaryExpression>parent).operatorToken.kind >= ts.SyntaxKind.FirstAssignment
+                        && (<ts.BinaryExpression>parent).operatorToken.kind <= ts.SyntaxKind.LastAssignment;
+                if (isWrite || EscapeAnalysis.getContainer(current) !== EscapeAnalysis.getContainer(node)) {
+                    valid = false;
+                    return;
+                }
+
+                // array and string indexers accept native integers
+                const isIndex = parent.kind === ts.SyntaxKind.ElementAccessExpression
+                    && (<ts.ElementAccessExpression>parent).argumentExpression === current
+                    && this.resolver.isArrayOrStringType(this.resolver.getOrResolveTypeOf((<ts.ElementAccessExpression>parent).expression));
+                if (!isIndex) {
+                    reads.push(current);
+                }
+
+                return;
+            }
+
+            ts.forEachChild(current, visit);
+        };
+
+        visit(node.statement);
+        if (valid) {
+            reads.forEach(r => (<any>r).__native_int_read = true);
+        }
+
+        return valid;
+    }
+}
@@ -211,6 +211,17 @@ export class IdentifierResolver {
         return false;
     }
 
+    // Map and Set of the standard library, size is read through get_size()
+    public isKeyedCollectionType(typeInfo: ts.Type) {
+        const symbol = typeInfo && typeInfo.symbol;
+        if (!symbol || !symbol.declarations) {
+            return false;
+        }
+
+        return (symbol.name === 'Map' || symbol.name === 'Set' || symbol.name === 'ReadonlyMap' || symbol.name === 'ReadonlySet')
+            && symbol.declarations.some(d => d.getSourceFile().isDeclarationFile);
+    }
+
     public isStaticAccess(typeInfo: ts.Type): boolean {
         if (this.isThisType(typeInfo)) {
             return false;
@@ -258,10 +269,18 @@ export class IdentifierResolver {
         return this.typeChecker.getTypeOfSymbolAtLocation(symbol, location);
     }
 
+    public getContextualType(node: ts.Expression): ts.Type {
+        return this.typeChecker.getContextualType(node);
+    }
+
     public typeToTypeNode(type: ts.Type): ts.TypeNode {
         return this.typeChecker.typeToTypeNode(type);
     }
 
+    public getTypeArguments(type: ts.TypeReference): ReadonlyArray<ts.Type> {
+        return this.typeChecker.getTypeArguments(type);
+    }
+
     public checkTypeAlias(symbol: ts.Symbol): boolean {
         if  (symbol && symbol.declarations[0].kind === ts.SyntaxKind.TypeAliasDeclaration) {
             return true;
@@ -0,0 +1,60 @@
+import * as fs from 'fs-extra';
+
+/**
+ * Types operands had at runtime, per source location, as written by a program compiled with -profile_generate:
+ * lines of location, type and count separated by tabs, every run appends its counts
+ */
+export class TypeProfile {
+
+    public static readonly defaultFileName = 'typescript2cxx.profile';
+
+    // share of the observations a type needs at a location to get a fast path
+    private static readonly threshold = 0.9;
+    private static loaded = new Map<string, { mtime: number, profile: TypeProfile }>();
+
+    private locations = new Map<string, Map<string, number>>();
+
+    /**
+     * Profiles are read once per change of the file, a missing file is an empty profile
+     */
+    public static load(fileName: string): TypeProfile {
+        const mtime = fs.existsSync(fileName) ? fs.statSync(fileName).mtimeMs : 0;
+        const cached = TypeProfile.loaded.get(fileName);
+        if (cached && cached.mtime === mtime) {
+            return cached.profile;
+        }
+
+        const profile = new TypeProfile();
+        if (mtime) {
+            fs.readFileSync(fileName).toString().split(/\r?\n/).forEach(line => {
+                const [location, type, count] = line.split('\t');
+                if (location && type && count) {
+                    profile.add(location, type, Number(count));
+                }
+            });
+        }
+
+        TypeProfile.loaded.set(fileName, { mtime, profile });
+        return profile;
+    }
+
+    public isMostly(location: string, type: string): boolean {
+        const types = this.locations.get(location);
+        if (!types) {
+            return false;
+        }
+
+        let total = 0;
+        types.forEach(count => total += count);
+        return total > 0 && (types.get(type) || 0) >= total * TypeProfile.threshold;
+    }
+
+    private add(location: string, type: string, count: number) {
+        if (!this.locations.has(location)) {
+            this.locations.set(location, new Map<string, number>());
+        }
+
+        const types = this.locations.get(location);
+        types.set(type, (types.get(type) || 0) + count);
+    }
+}